@@ -0,0 +1,918 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+///////////////////////////////////////////////////////////////////////////////
+// class StructMember
+///////////////////////////////////////////////////////////////////////////////
+
+class StructMember{
+  public:
+	std::string name; /// Name of the member.
+	std::string type; /// Element type of the member (e.g. "double" or "unsigned short").
+	std::string descr; /// Description of the member.
+	std::string storage; /// On-disk storage type ("" for the in-memory type, "float", "half", or "fixed").
+	std::string range; /// Root range specification of fixed-point storage (e.g. "[0,200,16]").
+
+	bool isVector; /// Set to true if the member is a std::vector.
+	bool isMult; /// Set to true if the member is a multiplicity variable.
+	bool isWave; /// Set to true if the member is a trace variable.
+
+	StructMember() : isVector(false), isMult(false), isWave(false) { }
+
+	/** Parse the type string of a member. Types beginning with "u_" are unsigned and types beginning with
+	  * "vector:" are vectors. An optional storage specification may follow the type in square brackets.
+	  * \param[in]  type_ The type string from the definition file (e.g. "vector:double[float]").
+	  * \return True if the type was parsed successfully and false otherwise.
+	  */
+	bool SetType(const std::string &type_);
+
+	/// Return the declared type of the member as written to the class (e.g. "std::vector<Double32_t>").
+	std::string GetDeclType() const;
+
+	/// Return the in-memory element type used in method arguments (e.g. "double").
+	std::string GetArgType() const { return type; }
+
+	/// Return the member comment, including the root storage specification (if any).
+	std::string GetComment() const;
+
+	/// Return the root leaf type code of the member (e.g. "D" or "d[0,180,16]"), or an empty string if the type has none.
+	std::string GetLeafType() const;
+};
+
+bool StructMember::SetType(const std::string &type_){
+	std::string str = type_;
+
+	// Strip the storage specification.
+	size_t bracket = str.find('[');
+	if(bracket != std::string::npos){
+		if(str[str.size()-1] != ']') return false;
+		std::string spec = str.substr(bracket+1, str.size()-bracket-2);
+		str = str.substr(0, bracket);
+		if(spec == "float" || spec == "half"){ storage = spec; }
+		else{
+			// Fixed-point storage given as <min>,<max>,<bits>.
+			int commas = 0;
+			for(size_t i = 0; i < spec.size(); i++){
+				if(spec[i] == ',') commas++;
+			}
+			if(commas != 2) return false;
+			int bits = atoi(spec.substr(spec.find_last_of(',')+1).c_str());
+			if(bits < 2 || bits > 32) return false;
+			storage = "fixed";
+			range = "[" + spec + "]";
+		}
+	}
+
+	if(str.find("vector:") == 0){
+		isVector = true;
+		str = str.substr(7);
+	}
+	if(str.find("u_") == 0){
+		str = "unsigned " + str.substr(2);
+	}
+	type = str;
+
+	// Reduced precision storage is only supported for floating point members.
+	if(!storage.empty() && type != "double" && type != "float") return false;
+
+	// Float members are already stored as floats.
+	if(storage == "float" && type == "float") storage = "";
+
+	return !type.empty();
+}
+
+std::string StructMember::GetDeclType() const {
+	std::string elementType = type;
+	if(!storage.empty()) elementType = (type == "double" ? "Double32_t" : "Float16_t");
+	if(isVector) return "std::vector<" + elementType + ">";
+	return elementType;
+}
+
+std::string StructMember::GetComment() const {
+	if(storage == "float") return "// " + descr;
+	else if(storage == "half") return "//[0,0,10] " + descr;
+	else if(storage == "fixed") return "//" + range + " " + descr;
+	return "/// " + descr;
+}
+
+std::string StructMember::GetLeafType() const {
+	if(storage == "float") return (type == "double" ? "d" : "F");
+	else if(storage == "half") return (type == "double" ? "d[0,0,10]" : "f[0,0,10]");
+	else if(storage == "fixed") return (type == "double" ? "d" : "f") + range;
+	if(type == "char") return "B";
+	else if(type == "unsigned char") return "b";
+	else if(type == "short") return "S";
+	else if(type == "unsigned short") return "s";
+	else if(type == "int") return "I";
+	else if(type == "unsigned int") return "i";
+	else if(type == "long") return "G";
+	else if(type == "unsigned long") return "g";
+	else if(type == "long long") return "L";
+	else if(type == "unsigned long long") return "l";
+	else if(type == "float") return "F";
+	else if(type == "double") return "D";
+	else if(type == "bool") return "O";
+	return "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class StructClass
+///////////////////////////////////////////////////////////////////////////////
+
+class StructClass{
+  public:
+	std::string name; /// Name of the class (without the "Structure" suffix).
+	std::string shortDescr; /// Short description of the class.
+	std::string longDescr; /// Long description of the class.
+	int maxMult; /// Maximum number of events per entry written by the flat output layout.
+	int version; /// Root class version. Must be increased whenever the on-disk layout of the class changes.
+
+	std::vector<StructMember> members; /// All members of the class.
+
+	StructClass(const std::string &name_="") : name(name_), maxMult(100), version(1) { }
+
+	/// Return true if the class has any trace variables.
+	bool HasWaveform() const;
+
+	/** Get the argument list of the append method. Multiplicity variables are not included.
+	  * \param[in]  wave_ Get the arguments of the waveform class instead of the structure class.
+	  * \param[in]  bulk_ Get the arguments of the bulk append method, which takes arrays of values.
+	  * \return The argument list (e.g. "const double &ctof_, const unsigned short &loc_").
+	  */
+	std::string GetAppendArgs(const bool &wave_, const bool &bulk_=false) const;
+
+	/** Write the declaration of the structure (or waveform) class.
+	  * \param[in]  out_  The output stream.
+	  * \param[in]  wave_ Write the waveform class instead of the structure class.
+	  * \return Nothing.
+	  */
+	void WriteHeader(std::ostream &out_, const bool &wave_) const;
+
+	/** Write the definition of the structure (or waveform) class.
+	  * \param[in]  out_  The output stream.
+	  * \param[in]  wave_ Write the waveform class instead of the structure class.
+	  * \return Nothing.
+	  */
+	void WriteSource(std::ostream &out_, const bool &wave_) const;
+
+	/** Write the declaration of the reader class.
+	  * \param[in]  out_ The output stream.
+	  * \return Nothing.
+	  */
+	void WriteReaderHeader(std::ostream &out_) const;
+
+	/** Write the definition of the reader class.
+	  * \param[in]  out_ The output stream.
+	  * \return Nothing.
+	  */
+	void WriteReaderSource(std::ostream &out_) const;
+};
+
+bool StructClass::HasWaveform() const {
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave) return true;
+	}
+	return false;
+}
+
+std::string StructClass::GetAppendArgs(const bool &wave_, const bool &bulk_/*=false*/) const {
+	std::stringstream args;
+	bool first = true;
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave != wave_ || iter->isMult) continue;
+		if(!first) args << ", ";
+		if(wave_ || bulk_) args << "const " << iter->GetArgType() << " *" << iter->name << "_";
+		else args << "const " << iter->GetArgType() << " &" << iter->name << "_";
+		first = false;
+	}
+	if(wave_ || bulk_) args << (first ? "" : ", ") << "const size_t &size_";
+	return args.str();
+}
+
+void StructClass::WriteHeader(std::ostream &out_, const bool &wave_) const {
+	std::string className = name + (wave_ ? "Waveform" : "Structure");
+
+	out_ << "/** " << shortDescr << "\n";
+	if(!longDescr.empty()) out_ << "  * " << longDescr << "\n";
+	out_ << "  */\n";
+	out_ << "class " << className << " : public Structure {\n";
+	out_ << "  public:\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave != wave_) continue;
+		out_ << "\t" << iter->GetDeclType() << " " << iter->name << "; " << iter->GetComment() << "\n";
+	}
+	if(!wave_){
+		// Copies of all members for the flat output layout. These are not written with the class, and the
+		// vectors are only allocated by BranchFlat() so that copying an unused structure stays cheap.
+		out_ << "\n";
+		out_ << "\tint flat_mult; //! Number of events in the flat arrays.\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+			if(iter->isVector) out_ << "\tstd::vector<" << iter->type << "> flat_" << iter->name << "; //! Fixed size copy of " << iter->name << ".\n";
+			else out_ << "\t" << iter->type << " flat_" << iter->name << "; //! Copy of " << iter->name << ".\n";
+		}
+	}
+	out_ << "\n";
+	out_ << "\t/// Default constructor.\n";
+	out_ << "\t" << className << "();\n\n";
+
+	if(wave_) out_ << "\t/// Append traces to the waveform.\n";
+	else out_ << "\t/// Append the values of a single detector event to the structure.\n";
+	out_ << "\tvoid Append(" << GetAppendArgs(wave_) << ");\n\n";
+	if(!wave_){
+		out_ << "\t/// Append the values of multiple detector events to the structure.\n";
+		out_ << "\tvoid AppendN(" << GetAppendArgs(wave_, true) << ");\n\n";
+		out_ << "\t/// Reserve space in all vector members for a number of detector events.\n";
+		out_ << "\tvoid Reserve(const size_t &size_);\n\n";
+		out_ << "\t/// Add a leaf for each member to a tree using the flat output layout (e.g. \"<prefix>_ctof[<prefix>_mult]/D\").\n";
+		out_ << "\tvoid BranchFlat(TTree *tree_, const std::string &prefix_);\n\n";
+		out_ << "\t/// Return the maximum number of events per entry written by the flat output layout.\n";
+		out_ << "\tint GetMaxFlatMult() const { return " << maxMult << "; }\n\n";
+		out_ << "\t/// Copy all members to the flat arrays. At most " << maxMult << " events are copied and truncated entries are counted. Does nothing before BranchFlat() is called.\n";
+		out_ << "\tvoid FillFlat();\n\n";
+	}
+	out_ << "\t/// Reset all members of the structure. The capacity of all vector members is kept.\n";
+	out_ << "\tvoid Zero();\n\n";
+	out_ << "\tClassDef(" << className << ", " << version << ") // " << shortDescr << "\n";
+	out_ << "};\n\n";
+}
+
+void StructClass::WriteSource(std::ostream &out_, const bool &wave_) const {
+	std::string className = name + (wave_ ? "Waveform" : "Structure");
+
+	out_ << "///////////////////////////////////////////////////////////////////////////////\n";
+	out_ << "// class " << className << "\n";
+	out_ << "///////////////////////////////////////////////////////////////////////////////\n\n";
+
+	// Constructor.
+	out_ << className << "::" << className << "() : Structure() {\n";
+	if(!wave_) out_ << "\tflat_mult = 0;\n";
+	out_ << "\tZero();\n";
+	out_ << "}\n\n";
+
+	// Append method.
+	out_ << "void " << className << "::Append(" << GetAppendArgs(wave_) << "){\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave != wave_) continue;
+		if(iter->isMult) out_ << "\t" << iter->name << "++;\n";
+		else if(wave_) out_ << "\t" << iter->name << ".insert(" << iter->name << ".end(), " << iter->name << "_, " << iter->name << "_+size_);\n";
+		else if(iter->isVector) out_ << "\t" << iter->name << ".push_back(" << iter->name << "_);\n";
+		else out_ << "\t" << iter->name << " = " << iter->name << "_;\n";
+	}
+	out_ << "\tdirty = true;\n";
+	out_ << "}\n\n";
+
+	if(!wave_){
+		// Bulk append method.
+		out_ << "void " << className << "::AppendN(" << GetAppendArgs(wave_, true) << "){\n";
+		out_ << "\tif(size_ == 0) return;\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave) continue;
+			if(iter->isMult) out_ << "\t" << iter->name << " += size_;\n";
+			else if(iter->isVector) out_ << "\t" << iter->name << ".insert(" << iter->name << ".end(), " << iter->name << "_, " << iter->name << "_+size_);\n";
+			else out_ << "\t" << iter->name << " = " << iter->name << "_[size_-1];\n";
+		}
+		out_ << "\tdirty = true;\n";
+		out_ << "}\n\n";
+
+		// Reserve method.
+		out_ << "void " << className << "::Reserve(const size_t &size_){\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave || !iter->isVector) continue;
+			out_ << "\t" << iter->name << ".reserve(size_);\n";
+		}
+		out_ << "}\n\n";
+
+		// Flat output methods.
+		out_ << "void " << className << "::BranchFlat(TTree *tree_, const std::string &prefix_){\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave || iter->isMult || !iter->isVector || iter->GetLeafType().empty()) continue;
+			out_ << "\tflat_" << iter->name << ".assign(" << maxMult << ", 0);\n";
+		}
+		out_ << "\ttree_->Branch((prefix_+\"_mult\").c_str(), &flat_mult, (prefix_+\"_mult/I\").c_str());\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+			std::string leaf = "\"_" + iter->name + (iter->isVector ? "[\"+prefix_+\"_mult]" : "") + "/" + iter->GetLeafType() + "\"";
+			out_ << "\ttree_->Branch((prefix_+\"_" << iter->name << "\").c_str(), &flat_" << iter->name << (iter->isVector ? "[0]" : "") << ", (prefix_+" << leaf << ").c_str());\n";
+		}
+		out_ << "}\n\n";
+
+		const StructMember *first = NULL;
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end() && !first; iter++){
+			if(!iter->isWave && iter->isVector && !iter->GetLeafType().empty()) first = &(*iter);
+		}
+		out_ << "void " << className << "::FillFlat(){\n";
+		if(first) out_ << "\tif(flat_" << first->name << ".empty()) return;\n";
+		if(first){
+			out_ << "\tif(" << first->name << ".size() > " << maxMult << ") numTruncated++;\n";
+			out_ << "\tflat_mult = (" << first->name << ".size() < " << maxMult << " ? (int)" << first->name << ".size() : " << maxMult << ");\n";
+		}
+		else out_ << "\tflat_mult = 0;\n";
+		for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+			if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+			if(iter->isVector) out_ << "\tstd::copy(" << iter->name << ".begin(), " << iter->name << ".begin()+flat_mult, flat_" << iter->name << ".begin());\n";
+			else out_ << "\tflat_" << iter->name << " = " << iter->name << ";\n";
+		}
+		out_ << "}\n\n";
+	}
+
+	// Zero method.
+	out_ << "void " << className << "::Zero(){\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave != wave_) continue;
+		if(iter->isVector) out_ << "\t" << iter->name << ".clear();\n";
+		else out_ << "\t" << iter->name << " = 0;\n";
+	}
+	out_ << "\tdirty = false;\n";
+	out_ << "}\n\n";
+
+	out_ << "ClassImp(" << className << ")\n\n";
+}
+
+void StructClass::WriteReaderHeader(std::ostream &out_) const {
+	std::string className = name + "Reader";
+	std::string branchName = name;
+	for(size_t i = 0; i < branchName.size(); i++) branchName[i] = tolower(branchName[i]);
+
+	// The number of events is taken from the multiplicity variable (or from the first vector member if there is none).
+	const StructMember *mult = NULL;
+	const StructMember *first = NULL;
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave) continue;
+		if(iter->isMult && !mult) mult = &(*iter);
+		else if(iter->isVector && !first) first = &(*iter);
+	}
+
+	out_ << "/** Typed reader of " << name << "Structure. Only the selected members are read from the input tree.\n";
+	out_ << "  * Both the object and the flat output layouts are supported.\n";
+	out_ << "  */\n";
+	out_ << "class " << className << " : public StructReader {\n";
+	out_ << "  private:\n";
+	out_ << "\t" << name << "Structure *ptr; /// Structure filled from the object output layout.\n\n";
+	out_ << "\tint flat_mult; /// Number of events in the flat arrays.\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+		if(iter->isVector) out_ << "\tstd::vector<" << iter->type << "> flat_" << iter->name << "; /// Values of " << iter->name << " read from the flat output layout.\n";
+		else out_ << "\t" << iter->type << " flat_" << iter->name << "; /// Value of " << iter->name << " read from the flat output layout.\n";
+	}
+	out_ << "\n";
+	out_ << "\t" << className << "(const " << className << " &); // Not copyable.\n";
+	out_ << "\t" << className << " &operator = (const " << className << " &);\n\n";
+	out_ << "  public:\n";
+	out_ << "\t/** Default constructor. Sets up all selected members of the structure in the input tree.\n";
+	out_ << "\t  * \\param[in]  tree_   The input tree.\n";
+	out_ << "\t  * \\param[in]  fields_ Comma separated list of members to read (e.g. \"loc,tqdc\"). All members are read if empty.\n";
+	out_ << "\t  * \\param[in]  name_   Name of the structure in the input tree (i.e. the processor type).\n";
+	out_ << "\t  */\n";
+	out_ << "\t" << className << "(TTree *tree_, const std::string &fields_=\"\", const std::string &name_=\"" << branchName << "\");\n\n";
+	out_ << "\t/// Destructor. Must be called before the input tree is deleted.\n";
+	out_ << "\t~" << className << "();\n\n";
+	out_ << "\t/// Return the number of detector events in the current entry.\n";
+	out_ << "\tsize_t size() const { return (flat ? (size_t)flat_mult : (ptr ? (size_t)ptr->";
+	if(mult) out_ << mult->name;
+	else if(first) out_ << first->name << ".size()";
+	else out_ << "flat_mult";
+	out_ << " : 0)); }\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+		if(iter->isVector){
+			std::string spanType = "ColumnSpan<" + iter->type + ">";
+			out_ << "\n\t/// Return the values of " << iter->name << " in the current entry (empty if " << iter->name << " is not selected).\n";
+			out_ << "\t" << spanType << " " << iter->name << "() const { return (flat ? " << spanType << "(flat_" << iter->name << ".data(), (flat_" << iter->name << ".empty() ? 0 : flat_mult))";
+			out_ << " : (ptr ? " << spanType << "(ptr->" << iter->name << ".data(), ptr->" << iter->name << ".size()) : " << spanType << "())); }\n";
+		}
+		else{
+			out_ << "\n\t/// Return the value of " << iter->name << " in the current entry.\n";
+			out_ << "\t" << iter->type << " " << iter->name << "() const { return (flat ? flat_" << iter->name << " : (ptr ? ptr->" << iter->name << " : 0)); }\n";
+		}
+	}
+	out_ << "};\n\n";
+}
+
+void StructClass::WriteReaderSource(std::ostream &out_) const {
+	std::string className = name + "Reader";
+	std::string branchName = name;
+	for(size_t i = 0; i < branchName.size(); i++) branchName[i] = tolower(branchName[i]);
+
+	out_ << "///////////////////////////////////////////////////////////////////////////////\n";
+	out_ << "// class " << className << "\n";
+	out_ << "///////////////////////////////////////////////////////////////////////////////\n\n";
+
+	// Constructor.
+	out_ << className << "::" << className << "(TTree *tree_, const std::string &fields_/*=\"\"*/, const std::string &name_/*=\"" << branchName << "\"*/) : StructReader(tree_, name_), ptr(NULL), flat_mult(0) {\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave || iter->isMult || iter->isVector || iter->GetLeafType().empty()) continue;
+		out_ << "\tflat_" << iter->name << " = 0;\n";
+	}
+	out_ << "\tif(flat){\n";
+	out_ << "\t\tif(AddField(\"mult\")) tree->SetBranchAddress((name+\"_mult\").c_str(), &flat_mult);\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave || iter->isMult || iter->GetLeafType().empty()) continue;
+		out_ << "\t\tif(IsSelected(fields_, \"" << iter->name << "\") && AddField(\"" << iter->name << "\")){\n";
+		if(iter->isVector){
+			out_ << "\t\t\tflat_" << iter->name << ".assign(" << maxMult << ", 0);\n";
+			out_ << "\t\t\ttree->SetBranchAddress((name+\"_" << iter->name << "\").c_str(), flat_" << iter->name << ".data());\n";
+		}
+		else out_ << "\t\t\ttree->SetBranchAddress((name+\"_" << iter->name << "\").c_str(), &flat_" << iter->name << ");\n";
+		out_ << "\t\t}\n";
+	}
+	out_ << "\t}\n";
+	out_ << "\telse if(topBranch){\n";
+	out_ << "\t\tptr = new " << name << "Structure();\n";
+	out_ << "\t\ttree->SetBranchAddress(name.c_str(), &ptr);\n";
+	for(std::vector<StructMember>::const_iterator iter = members.begin(); iter != members.end(); iter++){
+		if(iter->isWave) continue;
+		if(iter->isMult) out_ << "\t\tAddField(\"" << iter->name << "\");\n";
+		else out_ << "\t\tif(IsSelected(fields_, \"" << iter->name << "\")) AddField(\"" << iter->name << "\");\n";
+	}
+	out_ << "\t}\n";
+	out_ << "\tSetCacheSize();\n";
+	out_ << "}\n\n";
+
+	// Destructor.
+	out_ << className << "::~" << className << "(){\n";
+	out_ << "\tResetAddresses();\n";
+	out_ << "\tif(ptr) delete ptr;\n";
+	out_ << "}\n\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class StructFile
+///////////////////////////////////////////////////////////////////////////////
+
+class StructFile{
+  private:
+	std::vector<StructClass> classes; /// All classes defined in the definition file.
+
+  public:
+	/** Read all class definitions from a definition file.
+	  * \param[in]  filename_ Path to the definition file.
+	  * \return True if the file was read successfully and false otherwise.
+	  */
+	bool Read(const char *filename_);
+
+	/** Write the Structures.h, Structures.cpp, LinkDef.h, Readers.h, and Readers.cpp files.
+	  * \param[in]  dir_ Path to the output directory.
+	  * \return True if all files were written successfully and false otherwise.
+	  */
+	bool Write(const std::string &dir_) const;
+};
+
+bool StructFile::Read(const char *filename_){
+	std::ifstream file(filename_);
+	if(!file.good()){
+		std::cout << " structGen: Error! Failed to open input file \"" << filename_ << "\".\n";
+		return false;
+	}
+
+	StructClass *current = NULL;
+	bool inTypes = false;
+
+	std::string line;
+	int lineNum = 0;
+	while(std::getline(file, line)){
+		lineNum++;
+
+		// Strip comments and skip empty lines.
+		size_t comment = line.find('#');
+		if(comment != std::string::npos) line.erase(comment);
+
+		std::stringstream stream(line);
+		std::string key;
+		if(!(stream >> key)) continue;
+
+		std::string rest;
+		std::getline(stream, rest);
+		rest.erase(0, rest.find_first_not_of(" \t"));
+		rest.erase(rest.find_last_not_of(" \t\r") + 1);
+
+		if(key == "BEGIN_CLASS"){
+			classes.push_back(StructClass(rest));
+			current = &classes.back();
+		}
+		else if(key == "END_CLASS"){ current = NULL; }
+		else if(!current){
+			std::cout << " structGen: Error! On line " << lineNum << ", \"" << key << "\" outside of class definition.\n";
+			return false;
+		}
+		else if(key == "SHORT"){ current->shortDescr = rest; }
+		else if(key == "LONG"){ current->longDescr = rest; }
+		else if(key == "MAX_MULT"){
+			current->maxMult = atoi(rest.c_str());
+			if(current->maxMult <= 0){
+				std::cout << " structGen: Error! On line " << lineNum << ", invalid maximum multiplicity \"" << rest << "\".\n";
+				return false;
+			}
+		}
+		else if(key == "VERSION"){
+			current->version = atoi(rest.c_str());
+			if(current->version <= 0){
+				std::cout << " structGen: Error! On line " << lineNum << ", invalid class version \"" << rest << "\".\n";
+				return false;
+			}
+		}
+		else if(key == "BEGIN_TYPES"){ inTypes = true; }
+		else if(key == "END_TYPES"){ inTypes = false; }
+		else if(inTypes){
+			StructMember member;
+			std::stringstream restStream(rest);
+			restStream >> member.name;
+			std::getline(restStream, member.descr);
+			member.descr.erase(0, member.descr.find_first_not_of(" \t"));
+			if(member.name.empty() || !member.SetType(key)){
+				std::cout << " structGen: Error! On line " << lineNum << ", invalid member definition.\n";
+				return false;
+			}
+
+			// Check for the special variable names.
+			if(member.name == "mult" || (member.name.size() > 5 && member.name.substr(member.name.size()-5) == "_mult")) member.isMult = true;
+			else if(member.name.size() > 5 && member.name.substr(member.name.size()-5) == "_wave") member.isWave = true;
+
+			current->members.push_back(member);
+		}
+		else{
+			std::cout << " structGen: Error! On line " << lineNum << ", unknown keyword \"" << key << "\".\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool StructFile::Write(const std::string &dir_) const {
+	std::ofstream header((dir_ + "/Structures.h").c_str());
+	std::ofstream source((dir_ + "/Structures.cpp").c_str());
+	std::ofstream linkdef((dir_ + "/LinkDef.h").c_str());
+	std::ofstream readerHeader((dir_ + "/Readers.h").c_str());
+	std::ofstream readerSource((dir_ + "/Readers.cpp").c_str());
+	if(!header.good() || !source.good() || !linkdef.good() || !readerHeader.good() || !readerSource.good()){
+		std::cout << " structGen: Error! Failed to open output files in \"" << dir_ << "\".\n";
+		return false;
+	}
+
+	// Structures.h
+	header << "// Structures.h\n";
+	header << "// This file was automatically generated by structGen. Do not edit.\n\n";
+	header << "#ifndef STRUCTURES_H\n";
+	header << "#define STRUCTURES_H\n\n";
+	header << "#include <vector>\n";
+	header << "#include <string>\n\n";
+	header << "#include \"TObject.h\"\n\n";
+	header << "class TTree;\n\n";
+	header << "/// Base class for all data structures.\n";
+	header << "class Structure : public TObject {\n";
+	header << "  protected:\n";
+	header << "\tbool dirty; //! Set to true if the structure was filled since the last call to Zero().\n";
+	header << "\tunsigned long long numTruncated; //! Number of entries with more events than fit in the flat arrays.\n\n";
+	header << "  public:\n";
+	header << "\t/// Default constructor.\n";
+	header << "\tStructure() : TObject(), dirty(false), numTruncated(0) { }\n\n";
+	header << "\t/// Destructor.\n";
+	header << "\tvirtual ~Structure(){ }\n\n";
+	header << "\t/// Return true if the structure was filled since the last call to Zero().\n";
+	header << "\tbool IsDirty() const { return dirty; }\n\n";
+	header << "\t/// Reserve space in all vector members for a number of detector events.\n";
+	header << "\tvirtual void Reserve(const size_t &){ }\n\n";
+	header << "\t/// Return the number of entries whose events did not all fit in the flat arrays.\n";
+	header << "\tunsigned long long GetNumTruncated() const { return numTruncated; }\n\n";
+	header << "\t/// Return the maximum number of events per entry written by the flat output layout.\n";
+	header << "\tvirtual int GetMaxFlatMult() const { return 0; }\n\n";
+	header << "\t/// Add a leaf for each member to a tree using the flat output layout.\n";
+	header << "\tvirtual void BranchFlat(TTree *, const std::string &){ }\n\n";
+	header << "\t/// Copy all members to the flat arrays.\n";
+	header << "\tvirtual void FillFlat(){ }\n\n";
+	header << "\t/// Reset all members of the structure.\n";
+	header << "\tvirtual void Zero(){ dirty = false; }\n\n";
+	header << "\tClassDef(Structure, 1) // Data structure base class\n";
+	header << "};\n\n";
+	header << "/// Raw ADC traces of all channels of a detector type.\n";
+	header << "class Trace : public Structure {\n";
+	header << "  public:\n";
+	header << "\tstd::vector<unsigned short> wave; /// Samples of all traces.\n";
+	header << "\tunsigned short mult; /// Number of traces.\n\n";
+	header << "\t/// Default constructor.\n";
+	header << "\tTrace() : Structure(), mult(0) { }\n\n";
+	header << "\t/// Append a trace to the waveform.\n";
+	header << "\tvoid Append(const unsigned short *trace_, const size_t &size_);\n\n";
+	header << "\t/// Reset all members of the structure. The capacity of the waveform is kept.\n";
+	header << "\tvoid Zero();\n\n";
+	header << "\tClassDef(Trace, 1) // Raw ADC traces\n";
+	header << "};\n\n";
+	for(std::vector<StructClass>::const_iterator iter = classes.begin(); iter != classes.end(); iter++){
+		iter->WriteHeader(header, false);
+		if(iter->HasWaveform()) iter->WriteHeader(header, true);
+	}
+	header << "#endif\n";
+
+	// Structures.cpp
+	source << "// Structures.cpp\n";
+	source << "// This file was automatically generated by structGen. Do not edit.\n\n";
+	source << "#include <algorithm>\n\n";
+	source << "#include \"TTree.h\"\n\n";
+	source << "#include \"Structures.h\"\n\n";
+	source << "ClassImp(Structure)\n\n";
+	source << "///////////////////////////////////////////////////////////////////////////////\n";
+	source << "// class Trace\n";
+	source << "///////////////////////////////////////////////////////////////////////////////\n\n";
+	source << "void Trace::Append(const unsigned short *trace_, const size_t &size_){\n";
+	source << "\twave.insert(wave.end(), trace_, trace_+size_);\n";
+	source << "\tmult++;\n";
+	source << "\tdirty = true;\n";
+	source << "}\n\n";
+	source << "void Trace::Zero(){\n";
+	source << "\twave.clear();\n";
+	source << "\tmult = 0;\n";
+	source << "\tdirty = false;\n";
+	source << "}\n\n";
+	source << "ClassImp(Trace)\n\n";
+	for(std::vector<StructClass>::const_iterator iter = classes.begin(); iter != classes.end(); iter++){
+		iter->WriteSource(source, false);
+		if(iter->HasWaveform()) iter->WriteSource(source, true);
+	}
+
+	// LinkDef.h
+	linkdef << "// LinkDef.h\n";
+	linkdef << "// This file was automatically generated by structGen. Do not edit.\n\n";
+	linkdef << "#if defined(__CINT__) || defined(__CLING__)\n\n";
+	linkdef << "#pragma link off all globals;\n";
+	linkdef << "#pragma link off all classes;\n";
+	linkdef << "#pragma link off all functions;\n\n";
+	linkdef << "#pragma link C++ class Structure+;\n";
+	linkdef << "#pragma link C++ class Trace+;\n";
+	for(std::vector<StructClass>::const_iterator iter = classes.begin(); iter != classes.end(); iter++){
+		linkdef << "#pragma link C++ class " << iter->name << "Structure+;\n";
+		if(iter->HasWaveform()) linkdef << "#pragma link C++ class " << iter->name << "Waveform+;\n";
+	}
+	linkdef << "\n#endif\n";
+
+	// Readers.h
+	readerHeader << "// Readers.h\n";
+	readerHeader << "// This file was automatically generated by structGen. Do not edit.\n\n";
+	readerHeader << "#ifndef READERS_H\n";
+	readerHeader << "#define READERS_H\n\n";
+	readerHeader << "#include <vector>\n";
+	readerHeader << "#include <string>\n\n";
+	readerHeader << "#include \"Structures.h\"\n\n";
+	readerHeader << "class TTree;\n";
+	readerHeader << "class TBranch;\n\n";
+	readerHeader << "/// Read-only view of the values of a vector member in the current entry.\n";
+	readerHeader << "template <class T>\n";
+	readerHeader << "class ColumnSpan{\n";
+	readerHeader << "  private:\n";
+	readerHeader << "\tconst T *ptr; /// Pointer to the first value.\n";
+	readerHeader << "\tsize_t length; /// Number of values.\n\n";
+	readerHeader << "  public:\n";
+	readerHeader << "\tColumnSpan() : ptr(NULL), length(0) { }\n\n";
+	readerHeader << "\tColumnSpan(const T *ptr_, const size_t &length_) : ptr(ptr_), length(length_) { }\n\n";
+	readerHeader << "\tconst T *begin() const { return ptr; }\n\n";
+	readerHeader << "\tconst T *end() const { return ptr+length; }\n\n";
+	readerHeader << "\tconst T *data() const { return ptr; }\n\n";
+	readerHeader << "\tsize_t size() const { return length; }\n\n";
+	readerHeader << "\tbool empty() const { return (length == 0); }\n\n";
+	readerHeader << "\tconst T &operator [] (const size_t &index_) const { return ptr[index_]; }\n";
+	readerHeader << "};\n\n";
+	readerHeader << "/// Base class for all structure readers.\n";
+	readerHeader << "class StructReader{\n";
+	readerHeader << "  protected:\n";
+	readerHeader << "\tTTree *tree; /// The input tree.\n";
+	readerHeader << "\tstd::string name; /// Name of the structure in the input tree (i.e. the processor type).\n";
+	readerHeader << "\tbool flat; /// Set to true if the input tree uses the flat output layout.\n\n";
+	readerHeader << "\tTBranch *topBranch; /// Branch of the structure (object output layout only).\n";
+	readerHeader << "\tstd::vector<TBranch*> branches; /// All branches read for each entry.\n\n";
+	readerHeader << "\tstd::vector<long long> entryList; /// Entries selected by SetEntryList().\n";
+	readerHeader << "\tbool useEntryList; /// Set to true if only the entries in the entry list are read.\n";
+	readerHeader << "\tsize_t listIndex; /// Index of the next entry in the entry list.\n\n";
+	readerHeader << "\tLong64_t numEntries; /// Total number of entries in the input tree.\n";
+	readerHeader << "\tLong64_t entry; /// Current entry number (-1 before the first entry is read).\n";
+	readerHeader << "\tLong64_t clusterBegin; /// First entry of the current cluster.\n";
+	readerHeader << "\tLong64_t clusterEnd; /// First entry following the current cluster.\n\n";
+	readerHeader << "\t/** Find the branch of a member and add it to the list of branches read for each entry.\n";
+	readerHeader << "\t  * \\param[in]  field_ Name of the member.\n";
+	readerHeader << "\t  * \\return A pointer to the branch or NULL if the member was not found in the input tree.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tTBranch *AddField(const std::string &field_);\n\n";
+	readerHeader << "\t/// Reset the addresses of all branches of the structure.\n";
+	readerHeader << "\tvoid ResetAddresses();\n\n";
+	readerHeader << "\t/// Return true if a member is in a comma separated list of members (or if the list is empty).\n";
+	readerHeader << "\tstatic bool IsSelected(const std::string &fields_, const std::string &field_);\n\n";
+	readerHeader << "  public:\n";
+	readerHeader << "\t/** Default constructor. Finds the structure in the input tree.\n";
+	readerHeader << "\t  * \\param[in]  tree_ The input tree.\n";
+	readerHeader << "\t  * \\param[in]  name_ Name of the structure in the input tree (i.e. the processor type).\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tStructReader(TTree *tree_, const std::string &name_);\n\n";
+	readerHeader << "\t/// Destructor.\n";
+	readerHeader << "\tvirtual ~StructReader(){ }\n\n";
+	readerHeader << "\t/// Return true if the structure was found in the input tree.\n";
+	readerHeader << "\tbool IsValid() const { return !branches.empty(); }\n\n";
+	readerHeader << "\t/// Return true if the input tree uses the flat output layout.\n";
+	readerHeader << "\tbool IsFlat() const { return flat; }\n\n";
+	readerHeader << "\t/// Return the name of the structure in the input tree.\n";
+	readerHeader << "\tstd::string GetName() const { return name; }\n\n";
+	readerHeader << "\t/// Return the number of branches read for each entry.\n";
+	readerHeader << "\tsize_t GetNumBranches() const { return branches.size(); }\n\n";
+	readerHeader << "\t/// Return the total number of entries in the input tree.\n";
+	readerHeader << "\tLong64_t GetEntries() const { return numEntries; }\n\n";
+	readerHeader << "\t/// Return the number of entries which will be read by Next().\n";
+	readerHeader << "\tLong64_t GetNumSelected() const { return (useEntryList ? (Long64_t)entryList.size() : numEntries); }\n\n";
+	readerHeader << "\t/// Return the current entry number.\n";
+	readerHeader << "\tLong64_t GetCurrentEntry() const { return entry; }\n\n";
+	readerHeader << "\t/// Return the first entry of the current cluster.\n";
+	readerHeader << "\tLong64_t GetClusterBegin() const { return clusterBegin; }\n\n";
+	readerHeader << "\t/// Return the first entry following the current cluster.\n";
+	readerHeader << "\tLong64_t GetClusterEnd() const { return clusterEnd; }\n\n";
+	readerHeader << "\t/** Set the size of the read cache of the input tree and add all branches of the structure to it.\n";
+	readerHeader << "\t  * \\param[in]  size_ Size of the read cache (in bytes).\n";
+	readerHeader << "\t  * \\return True if the read cache was set up and false otherwise.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tbool SetCacheSize(const Long64_t &size_=30000000);\n\n";
+	readerHeader << "\t/** Only read the selected entries with Next(). The entries should be in increasing order.\n";
+	readerHeader << "\t  * \\param[in]  entries_ The selected entry numbers (e.g. from the event index).\n";
+	readerHeader << "\t  * \\return Nothing.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tvoid SetEntryList(const std::vector<long long> &entries_);\n\n";
+	readerHeader << "\t/// Restart reading from the first (selected) entry.\n";
+	readerHeader << "\tvoid Rewind();\n\n";
+	readerHeader << "\t/** Read the selected members of an entry.\n";
+	readerHeader << "\t  * \\param[in]  entry_ The entry number.\n";
+	readerHeader << "\t  * \\return True if the entry was read successfully and false otherwise.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tbool GetEntry(const Long64_t &entry_);\n\n";
+	readerHeader << "\t/** Read the next (selected) entry. Entries are read cluster by cluster, and clusters without any\n";
+	readerHeader << "\t  * selected entries are skipped entirely.\n";
+	readerHeader << "\t  * \\return True if an entry was read and false if there are no more entries.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tbool Next();\n\n";
+	readerHeader << "\t/** Move to the next cluster of the input tree without reading any entries.\n";
+	readerHeader << "\t  * \\param[out] first_ The first entry of the cluster.\n";
+	readerHeader << "\t  * \\param[out] last_  The first entry following the cluster.\n";
+	readerHeader << "\t  * \\return True if there is another cluster and false otherwise.\n";
+	readerHeader << "\t  */\n";
+	readerHeader << "\tbool NextCluster(Long64_t &first_, Long64_t &last_);\n";
+	readerHeader << "};\n\n";
+	for(std::vector<StructClass>::const_iterator iter = classes.begin(); iter != classes.end(); iter++)
+		iter->WriteReaderHeader(readerHeader);
+	readerHeader << "#endif\n";
+
+	// Readers.cpp
+	readerSource << "// Readers.cpp\n";
+	readerSource << "// This file was automatically generated by structGen. Do not edit.\n\n";
+	readerSource << "#include <sstream>\n";
+	readerSource << "#include <algorithm>\n\n";
+	readerSource << "#include \"TTree.h\"\n";
+	readerSource << "#include \"TBranch.h\"\n\n";
+	readerSource << "#include \"Readers.h\"\n\n";
+	readerSource << "///////////////////////////////////////////////////////////////////////////////\n";
+	readerSource << "// class StructReader\n";
+	readerSource << "///////////////////////////////////////////////////////////////////////////////\n\n";
+	readerSource << "StructReader::StructReader(TTree *tree_, const std::string &name_) : tree(tree_), name(name_), flat(false), topBranch(NULL), useEntryList(false), listIndex(0),\n";
+	readerSource << "                                                                     numEntries(0), entry(-1), clusterBegin(0), clusterEnd(0) {\n";
+	readerSource << "\tif(!tree) return;\n";
+	readerSource << "\tnumEntries = tree->GetEntries();\n";
+	readerSource << "\ttopBranch = tree->GetBranch(name.c_str());\n";
+	readerSource << "\tif(!topBranch && tree->GetBranch((name+\"_mult\").c_str())) flat = true;\n";
+	readerSource << "}\n\n";
+	readerSource << "TBranch *StructReader::AddField(const std::string &field_){\n";
+	readerSource << "\tTBranch *branch = NULL;\n";
+	readerSource << "\tif(flat) branch = tree->GetBranch((name+\"_\"+field_).c_str());\n";
+	readerSource << "\telse if(topBranch){\n";
+	readerSource << "\t\t// An unsplit structure can only be read as a whole.\n";
+	readerSource << "\t\tif(topBranch->GetListOfBranches()->GetEntriesFast() == 0) branch = topBranch;\n";
+	readerSource << "\t\telse branch = topBranch->FindBranch(field_.c_str());\n";
+	readerSource << "\t}\n";
+	readerSource << "\tif(branch && std::find(branches.begin(), branches.end(), branch) == branches.end())\n";
+	readerSource << "\t\tbranches.push_back(branch);\n";
+	readerSource << "\treturn branch;\n";
+	readerSource << "}\n\n";
+	readerSource << "void StructReader::ResetAddresses(){\n";
+	readerSource << "\tif(!tree) return;\n";
+	readerSource << "\tif(!flat){\n";
+	readerSource << "\t\tif(topBranch) tree->ResetBranchAddress(topBranch);\n";
+	readerSource << "\t\treturn;\n";
+	readerSource << "\t}\n";
+	readerSource << "\tfor(std::vector<TBranch*>::iterator iter = branches.begin(); iter != branches.end(); iter++)\n";
+	readerSource << "\t\ttree->ResetBranchAddress(*iter);\n";
+	readerSource << "}\n\n";
+	readerSource << "bool StructReader::IsSelected(const std::string &fields_, const std::string &field_){\n";
+	readerSource << "\tif(fields_.empty()) return true;\n";
+	readerSource << "\tstd::stringstream stream(fields_);\n";
+	readerSource << "\tstd::string str;\n";
+	readerSource << "\twhile(std::getline(stream, str, ',')){\n";
+	readerSource << "\t\tstr.erase(0, str.find_first_not_of(\" \\t\"));\n";
+	readerSource << "\t\tstr.erase(str.find_last_not_of(\" \\t\") + 1);\n";
+	readerSource << "\t\tif(str == field_) return true;\n";
+	readerSource << "\t}\n";
+	readerSource << "\treturn false;\n";
+	readerSource << "}\n\n";
+	readerSource << "bool StructReader::SetCacheSize(const Long64_t &size_/*=30000000*/){\n";
+	readerSource << "\tif(!tree || branches.empty()) return false;\n";
+	readerSource << "\ttree->SetCacheSize(size_);\n";
+	readerSource << "\tfor(std::vector<TBranch*>::iterator iter = branches.begin(); iter != branches.end(); iter++)\n";
+	readerSource << "\t\ttree->AddBranchToCache(*iter, false);\n";
+	readerSource << "\ttree->StopCacheLearningPhase();\n";
+	readerSource << "\treturn true;\n";
+	readerSource << "}\n\n";
+	readerSource << "void StructReader::SetEntryList(const std::vector<long long> &entries_){\n";
+	readerSource << "\tentryList = entries_;\n";
+	readerSource << "\tuseEntryList = true;\n";
+	readerSource << "\tRewind();\n";
+	readerSource << "}\n\n";
+	readerSource << "void StructReader::Rewind(){\n";
+	readerSource << "\tentry = -1;\n";
+	readerSource << "\tlistIndex = 0;\n";
+	readerSource << "\tclusterBegin = 0;\n";
+	readerSource << "\tclusterEnd = 0;\n";
+	readerSource << "}\n\n";
+	readerSource << "bool StructReader::GetEntry(const Long64_t &entry_){\n";
+	readerSource << "\tif(branches.empty() || entry_ < 0 || entry_ >= numEntries) return false;\n";
+	readerSource << "\n";
+	readerSource << "\t// Load the entry into the tree first so that the read cache is filled for the correct cluster.\n";
+	readerSource << "\tLong64_t local = tree->LoadTree(entry_);\n";
+	readerSource << "\tif(local < 0) return false;\n";
+	readerSource << "\tfor(std::vector<TBranch*>::iterator iter = branches.begin(); iter != branches.end(); iter++){\n";
+	readerSource << "\t\tif((*iter)->GetEntry(local) < 0) return false;\n";
+	readerSource << "\t}\n";
+	readerSource << "\tentry = entry_;\n";
+	readerSource << "\treturn true;\n";
+	readerSource << "}\n\n";
+	readerSource << "bool StructReader::Next(){\n";
+	readerSource << "\tLong64_t next = entry+1;\n";
+	readerSource << "\tif(useEntryList){\n";
+	readerSource << "\t\tif(listIndex >= entryList.size()) return false;\n";
+	readerSource << "\t\tnext = entryList[listIndex++];\n";
+	readerSource << "\t}\n";
+	readerSource << "\tif(next >= numEntries) return false;\n";
+	readerSource << "\n";
+	readerSource << "\t// Move directly to the cluster containing the next entry.\n";
+	readerSource << "\tif(next < clusterBegin || next >= clusterEnd){\n";
+	readerSource << "\t\tTTree::TClusterIterator clusters = tree->GetClusterIterator(next);\n";
+	readerSource << "\t\tclusterBegin = clusters();\n";
+	readerSource << "\t\tclusterEnd = clusters.GetNextEntry();\n";
+	readerSource << "\t}\n";
+	readerSource << "\n";
+	readerSource << "\treturn GetEntry(next);\n";
+	readerSource << "}\n\n";
+	readerSource << "bool StructReader::NextCluster(Long64_t &first_, Long64_t &last_){\n";
+	readerSource << "\tif(!tree || clusterEnd >= numEntries) return false;\n";
+	readerSource << "\tTTree::TClusterIterator clusters = tree->GetClusterIterator(clusterEnd);\n";
+	readerSource << "\tclusterBegin = clusters();\n";
+	readerSource << "\tclusterEnd = clusters.GetNextEntry();\n";
+	readerSource << "\tif(clusterEnd > numEntries) clusterEnd = numEntries;\n";
+	readerSource << "\tfirst_ = clusterBegin;\n";
+	readerSource << "\tlast_ = clusterEnd;\n";
+	readerSource << "\treturn true;\n";
+	readerSource << "}\n\n";
+	for(std::vector<StructClass>::const_iterator iter = classes.begin(); iter != classes.end(); iter++)
+		iter->WriteReaderSource(readerSource);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// main
+///////////////////////////////////////////////////////////////////////////////
+
+void help(char *prog_name_){
+	std::cout << "  SYNTAX: " << prog_name_ << " -i <input> [options]\n";
+	std::cout << "   Available options:\n";
+	std::cout << "    --help (-h)     | Display this dialogue.\n";
+	std::cout << "    -i <filename>   | Specify the input structure definition file.\n";
+	std::cout << "    -d <directory>  | Specify the output directory (default=./).\n";
+}
+
+int main(int argc, char *argv[]){
+	std::string input;
+	std::string directory = ".";
+
+	for(int index = 1; index < argc; index++){
+		if(strcmp(argv[index], "--help") == 0 || strcmp(argv[index], "-h") == 0){
+			help(argv[0]);
+			return 0;
+		}
+		else if(strcmp(argv[index], "-i") == 0 && index+1 < argc){ input = argv[++index]; }
+		else if(strcmp(argv[index], "-d") == 0 && index+1 < argc){ directory = argv[++index]; }
+		else{
+			std::cout << " structGen: Error! Unrecognized argument \"" << argv[index] << "\".\n";
+			help(argv[0]);
+			return 1;
+		}
+	}
+
+	if(input.empty()){
+		std::cout << " structGen: Error! Input structure definition file not specified.\n";
+		help(argv[0]);
+		return 1;
+	}
+
+	StructFile structs;
+	if(!structs.Read(input.c_str()) || !structs.Write(directory))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,163 @@
+#ifndef ASYNCWRITER_HPP
+#define ASYNCWRITER_HPP
+
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Root libraries
+#include "TTree.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class BufferBase
+///////////////////////////////////////////////////////////////////////////////
+
+class BufferBase{
+  public:
+	/// Destructor.
+	virtual ~BufferBase(){ }
+
+	/// Set the number of snapshot slots.
+	virtual void Resize(const size_t &size_) = 0;
+
+	/// Copy the source object into a snapshot slot.
+	virtual void Store(const size_t &slot_) = 0;
+
+	/// Copy a snapshot slot into the object read by the output tree.
+	virtual void Load(const size_t &slot_) = 0;
+
+	/** Create a branch in a tree which reads from the output object of this buffer.
+	  * \param[in]  tree_       Pointer to the output tree.
+	  * \param[in]  name_       Name of the new branch.
+	  * \param[in]  bufsize_    Basket size of the new branch.
+	  * \param[in]  splitLevel_ Split level of the new branch.
+	  * \return Pointer to the new branch.
+	  */
+	virtual TBranch *MakeBranch(TTree *tree_, const char *name_, const int &bufsize_, const int &splitLevel_) = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class StructureBuffer
+///////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+class StructureBuffer : public BufferBase {
+  private:
+	T *source; /// Object filled by the scan thread.
+	T output; /// Object read by the output tree on the writer thread.
+	std::vector<T> slots; /// Snapshots of the source object waiting to be written.
+
+  public:
+	/// Source constructor.
+	StructureBuffer(T *source_) : source(source_) { }
+
+	/// Set the number of snapshot slots.
+	virtual void Resize(const size_t &size_){ slots.resize(size_); }
+
+	/// Copy the source object into a snapshot slot.
+	virtual void Store(const size_t &slot_){ slots[slot_] = *source; }
+
+	/// Copy a snapshot slot into the object read by the output tree.
+	virtual void Load(const size_t &slot_){ output = slots[slot_]; }
+
+	/// Create a branch in a tree which reads from the output object of this buffer.
+	virtual TBranch *MakeBranch(TTree *tree_, const char *name_, const int &bufsize_, const int &splitLevel_){ return tree_->Branch(name_, &output, bufsize_, splitLevel_); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class AsyncWriter
+///////////////////////////////////////////////////////////////////////////////
+
+class AsyncWriter{
+  private:
+	std::map<TTree*, std::vector<BufferBase*> > branches; /// List of buffers for each output tree.
+	std::vector<BufferBase*> owned; /// Buffers created (and deleted) by the writer.
+
+	std::vector<TTree*> slotTrees; /// The tree to fill for each snapshot slot.
+
+	size_t numSlots; /// Total number of snapshot slots.
+	size_t head; /// Index of the next slot to be filled by the scan thread.
+	size_t tail; /// Index of the next slot to be written by the writer thread.
+	size_t count; /// Number of slots waiting to be written.
+
+	unsigned long numFills; /// Total number of snapshots written.
+	unsigned long numWaits; /// Number of times the scan thread had to wait for a free slot.
+
+	bool running; /// Set to true while the writer thread is running.
+	bool stopping; /// Set to true when the writer thread has been asked to finish.
+
+	std::thread writerThread; /// Thread used for filling the output trees.
+	std::mutex queueMutex; /// Lock for the slot counters.
+	std::mutex fillMutex; /// Held by the writer thread while it fills a tree.
+	std::condition_variable dataReady; /// Signals the writer thread that a slot is ready to be written.
+	std::condition_variable slotFree; /// Signals the scan thread that a slot has been written.
+
+	/// Main loop of the writer thread.
+	void Run();
+
+  public:
+	/** Default constructor.
+	  * \param[in]  numSlots_ The number of snapshots which may be queued before the scan thread must wait.
+	  */
+	AsyncWriter(const size_t &numSlots_=64);
+
+	/// Destructor. Stops the writer thread.
+	~AsyncWriter();
+
+	/** Register a buffer with the writer and create a branch which reads from it. The buffer is not owned by the writer.
+	  * \param[in]  tree_       Pointer to the output tree.
+	  * \param[in]  name_       Name of the new branch.
+	  * \param[in]  buffer_     Pointer to the buffer for the new branch.
+	  * \param[in]  bufsize_    Basket size of the new branch.
+	  * \param[in]  splitLevel_ Split level of the new branch.
+	  * \return Pointer to the new branch.
+	  */
+	TBranch *AddBranch(TTree *tree_, const char *name_, BufferBase *buffer_, const int &bufsize_=32000, const int &splitLevel_=99);
+
+	/** Create a buffer for an object and a branch which reads from it. The buffer is owned by the writer.
+	  * \param[in]  tree_       Pointer to the output tree.
+	  * \param[in]  name_       Name of the new branch.
+	  * \param[in]  source_     Pointer to the object filled by the scan.
+	  * \param[in]  bufsize_    Basket size of the new branch.
+	  * \param[in]  splitLevel_ Split level of the new branch.
+	  * \return Pointer to the new branch.
+	  */
+	template <class T>
+	TBranch *Branch(TTree *tree_, const char *name_, T *source_, const int &bufsize_=32000, const int &splitLevel_=99){
+		BufferBase *buffer = new StructureBuffer<T>(source_);
+		owned.push_back(buffer);
+		return AddBranch(tree_, name_, buffer, bufsize_, splitLevel_);
+	}
+
+	/// Start the writer thread.
+	bool Start();
+
+	/** Take a snapshot of all objects in a tree and queue it to be filled by the writer thread.
+	  * Waits for a free slot if the queue is full.
+	  * \param[in]  tree_ Pointer to the output tree.
+	  * \return The number of queued snapshots or -1 if the tree is not handled by the writer.
+	  */
+	int Fill(TTree *tree_);
+
+	/// Wait until all queued snapshots have been written.
+	void Flush();
+
+	/// Write all queued snapshots and stop the writer thread.
+	void Stop();
+
+	/// Return true if the writer thread is running.
+	bool IsRunning() const { return running; }
+
+	/// Return the total number of snapshots written.
+	unsigned long GetNumFills() const { return numFills; }
+
+	/// Return the number of times the scan thread had to wait for a free slot.
+	unsigned long GetNumWaits() const { return numWaits; }
+
+	/// Return the lock held by the writer thread while it fills a tree (and writes baskets to the output file).
+	std::mutex &GetFillMutex(){ return fillMutex; }
+};
+
+#endif
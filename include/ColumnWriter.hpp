@@ -0,0 +1,149 @@
+#ifndef COLUMNWRITER_HPP
+#define COLUMNWRITER_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+class TObject;
+
+///////////////////////////////////////////////////////////////////////////////
+// class ColumnField
+///////////////////////////////////////////////////////////////////////////////
+
+class ColumnField{
+  public:
+	std::string name; /// Name of the structure member.
+	std::string type; /// Schema type of a single element (e.g. "float64").
+	std::string description; /// Description of the member taken from the structure dictionary.
+	std::string filename; /// Name of the column file (relative to the output directory).
+
+	size_t width; /// Size of a single element (in bytes).
+	long offset; /// Offset of the member from the start of the structure (in bytes).
+	bool isVector; /// Set to true if the member is a std::vector.
+
+	size_t (*getVector)(const void *, const char **); /// Returns the size and data pointer of a vector member.
+
+	std::ofstream *file; /// Output column file.
+	std::vector<char> buffer; /// Data waiting to be written to the column file.
+	unsigned long long bytesWritten; /// Total number of bytes written to the column file.
+
+	/// Default constructor.
+	ColumnField() : width(0), offset(0), isVector(false), getVector(NULL), file(NULL), bytesWritten(0) { }
+
+	/** Set the schema type, element width, and vector accessor of this field from a C++ type name.
+	  * \param[in]  typeName_ The true type name of the member (e.g. "vector<double>").
+	  * \return True if the type is supported and false otherwise.
+	  */
+	bool SetType(const std::string &typeName_);
+
+	/** Add data to the buffer and write the buffer to the column file if it is full.
+	  * \param[in]  data_   Pointer to the data to write.
+	  * \param[in]  length_ Number of bytes to write.
+	  * \param[in]  limit_  The buffer size at which the buffer is written to file (in bytes).
+	  * \return Nothing.
+	  */
+	void Write(const char *data_, const size_t &length_, const size_t &limit_);
+
+	/// Write any buffered data to the column file.
+	void Flush();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class ColumnGroup
+///////////////////////////////////////////////////////////////////////////////
+
+class ColumnGroup{
+  public:
+	std::string name; /// Name of the structure (i.e. the processor type).
+	std::string className; /// Class name of the structure.
+
+	const char *object; /// Pointer to the structure.
+
+	std::vector<ColumnField> fields; /// List of all columns of the structure.
+
+	ColumnField offsets; /// Cumulative vector multiplicity at the end of each entry (leading zero included).
+
+	unsigned long long elements; /// Total number of vector elements written for this structure.
+	unsigned long mismatches; /// Number of entries for which the vector members did not all have the same length.
+
+	/// Default constructor.
+	ColumnGroup() : object(NULL), elements(0), mismatches(0) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class ColumnWriter
+///////////////////////////////////////////////////////////////////////////////
+
+class ColumnWriter{
+  private:
+	std::string directory; /// Output directory for all column files.
+
+	std::vector<ColumnGroup*> groups; /// List of all structures written to the output.
+
+	unsigned long long entries; /// Total number of entries written.
+
+	size_t bufferSize; /// Size of the write buffer of each column (in bytes).
+
+	bool isOpen; /// Set to true when the output directory is ready for writing.
+
+	std::vector<char> padding; /// Zeros used for padding vector members which are shorter than the multiplicity.
+
+	/** Open an output column file.
+	  * \param[in]  field_ The field to open a file for.
+	  * \return True if the file was opened successfully and false otherwise.
+	  */
+	bool OpenColumn(ColumnField &field_);
+
+	/** Write the JSON schema describing all columns to the output directory.
+	  * \return True if the schema was written successfully and false otherwise.
+	  */
+	bool WriteSchema();
+
+  public:
+	/** Default constructor.
+	  * \param[in]  bufferSize_ Size of the write buffer of each column (in bytes).
+	  */
+	ColumnWriter(const size_t &bufferSize_=1048576);
+
+	/// Destructor. Closes all open column files.
+	~ColumnWriter();
+
+	/** Create the output directory. Existing column files in the directory are overwritten.
+	  * \param[in]  directory_ Path to the output directory.
+	  * \return True if the directory is ready for writing and false otherwise.
+	  */
+	bool Open(const std::string &directory_);
+
+	/** Add a structure to the output. One column is created for each persistent member of the structure
+	  * using the root dictionary of the structure class. Must be called before the first call to Fill().
+	  * \param[in]  name_   Name of the structure (used as the column file prefix).
+	  * \param[in]  object_ Pointer to the structure. Must remain valid until Close() is called.
+	  * \return True if the structure was added successfully and false otherwise.
+	  */
+	bool AddStructure(const std::string &name_, TObject *object_);
+
+	/** Append the current values of all structures to their columns.
+	  * \return The total number of entries written.
+	  */
+	unsigned long long Fill();
+
+	/** Write all buffered data, close all column files, and write the schema.
+	  * \return True if the schema was written successfully and false otherwise.
+	  */
+	bool Close();
+
+	/// Return the path to the output directory.
+	std::string GetDirectory() const { return directory; }
+
+	/// Return the total number of entries written.
+	unsigned long long GetEntries() const { return entries; }
+
+	/// Return the total number of bytes written to all column files.
+	unsigned long long GetBytesWritten() const;
+
+	/// Print the number of elements and bytes written for each structure.
+	void Print() const;
+};
+
+#endif
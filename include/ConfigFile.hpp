@@ -1,7 +1,48 @@
 #ifndef CONFIGFILE_HPP
 #define CONFIGFILE_HPP
 
+#include <string>
+#include <vector>
+
 class TFile;
+class TTree;
+
+class TreeConfig{
+  public:
+	std::string name; /// Name of the output tree.
+
+	int compressAlgorithm; /// Root compression algorithm (0=none, 1=ZLIB, 2=LZMA, 4=LZ4, 5=ZSTD). Negative uses the file default.
+	int compressLevel; /// Compression level (0-9).
+	int basketSize; /// Branch basket size in bytes. Zero uses the root default.
+	long long autoFlush; /// Tree auto-flush setting (>0 entries, <0 bytes). Zero uses the root default.
+	int splitLevel; /// Split level for object branches.
+
+	TreeConfig(const std::string &name_="");
+
+	bool Set(const std::string &key_, const std::string &value_);
+
+	int GetCompressionSettings() const { return 100*compressAlgorithm + compressLevel; }
+
+	std::string GetAlgorithmName() const;
+
+	bool Apply(TTree *tree_) const;
+
+	std::string Print() const;
+};
+
+class SkimConfig{
+  public:
+	std::string name; /// Name of the skim stream, appended to the output filename.
+	std::vector<std::string> branches; /// Processor types whose structures are written ("*" for all).
+	std::string filter; /// Expression which events must pass to be written to the skim (empty for all events).
+
+	SkimConfig(const std::string &name_="") : name(name_) { }
+
+	/// Return true if the structure of a processor type is written to the skim.
+	bool HasBranch(const std::string &type_) const;
+
+	std::string Print() const;
+};
 
 class ConfigFile{
   private:
@@ -13,6 +54,13 @@ class ConfigFile{
 	float eventWidth;
 	float eventDelay;
 	int buildMethod;
+	std::string outputFilter; /// Expression which events must pass to be written to the output (empty for all events).
+	std::vector<SkimConfig> skims; /// Additional filtered outputs written in the same pass.
+
+	TreeConfig dataTree;
+	TreeConfig traceTree;
+	TreeConfig rawTree;
+	TreeConfig statsTree;
   
 	ConfigFile();
 	
@@ -0,0 +1,159 @@
+#ifndef EVENTFILTER_HPP
+#define EVENTFILTER_HPP
+
+#include <vector>
+#include <string>
+
+class TObject;
+
+///////////////////////////////////////////////////////////////////////////////
+// class FilterNode
+///////////////////////////////////////////////////////////////////////////////
+
+class FilterNode{
+  public:
+	enum NodeType {CONSTANT, FIELD, NEGATE, NOT, ADD, SUBTRACT, MULTIPLY, DIVIDE,
+	               EQUAL, NOTEQUAL, LESS, LESSEQUAL, GREATER, GREATEREQUAL, AND, OR};
+
+	NodeType type; /// Operation performed by this node.
+	int left; /// Index of the left (or only) operand node.
+	int right; /// Index of the right operand node.
+
+	double value; /// Value of a constant node.
+
+	const char *field; /// Pointer to the structure member of a field node.
+	int index; /// Element index of a vector member (-1 for the number of elements, -2 for the current element).
+	double (*get)(const char *, const int &); /// Returns the value of the structure member.
+
+	/// Default constructor.
+	FilterNode() : type(CONSTANT), left(-1), right(-1), value(0), field(NULL), index(-1), get(NULL) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class FilterStructure
+///////////////////////////////////////////////////////////////////////////////
+
+class FilterStructure{
+  public:
+	std::string name; /// Name of the structure (i.e. the processor type).
+	TObject *object; /// Pointer to the structure.
+
+	/// Default constructor.
+	FilterStructure(const std::string &name_, TObject *object_) : name(name_), object(object_) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class EventFilter
+///////////////////////////////////////////////////////////////////////////////
+
+class EventFilter{
+  private:
+	std::string expression; /// The filter expression.
+	std::vector<FilterNode> nodes; /// All nodes of the compiled expression.
+	std::vector<FilterStructure> structures; /// Structures whose members may be used in the expression.
+	int root; /// Index of the top node of the compiled expression.
+	bool elementwise; /// Set to true if vector members without an index refer to the current element.
+	int element; /// The current element of vector members without an index.
+
+	size_t position; /// Current position of the parser in the expression.
+	std::string error; /// Description of the last parsing error.
+
+	unsigned long long numAccepted; /// Total number of accepted events.
+	unsigned long long numRejected; /// Total number of rejected events.
+
+	/// Skip any whitespace at the current position of the parser.
+	void SkipSpace();
+
+	/** Check for a token at the current position of the parser and step past it if found.
+	  * \param[in]  token_ The token to check for.
+	  * \return True if the token was found and false otherwise.
+	  */
+	bool Match(const char *token_);
+
+	/** Add a node to the compiled expression.
+	  * \param[in]  type_  Operation of the node.
+	  * \param[in]  left_  Index of the left operand node.
+	  * \param[in]  right_ Index of the right operand node.
+	  * \return The index of the new node.
+	  */
+	int AddNode(const FilterNode::NodeType &type_, const int &left_=-1, const int &right_=-1);
+
+	/// Parse a logical or of and-expressions. Returns the index of the node or -1 on error.
+	int ParseOr();
+
+	/// Parse a logical and of comparisons. Returns the index of the node or -1 on error.
+	int ParseAnd();
+
+	/// Parse a comparison of two sums. Returns the index of the node or -1 on error.
+	int ParseComparison();
+
+	/// Parse a sum of products. Returns the index of the node or -1 on error.
+	int ParseSum();
+
+	/// Parse a product of unary expressions. Returns the index of the node or -1 on error.
+	int ParseProduct();
+
+	/// Parse a negation, logical not, number, field, or parenthesized expression. Returns the index of the node or -1 on error.
+	int ParseUnary();
+
+	/** Parse a structure member of the form "<structure>.<member>" or "<structure>.<member>[<index>]".
+	  * \return The index of the node or -1 on error.
+	  */
+	int ParseField();
+
+	/** Evaluate a node of the compiled expression.
+	  * \param[in]  index_ Index of the node.
+	  * \return The value of the node.
+	  */
+	double Evaluate(const int &index_) const;
+
+  public:
+	/// Default constructor.
+	EventFilter() : root(-1), elementwise(false), element(0), position(0), numAccepted(0), numRejected(0) { }
+
+	/** Add a structure whose members may be used in the expression. Must be called before Compile().
+	  * \param[in]  name_   Name of the structure (i.e. the processor type).
+	  * \param[in]  object_ Pointer to the structure. Must remain valid while the filter is used.
+	  * \return True if the structure was added and false otherwise.
+	  */
+	bool AddStructure(const std::string &name_, TObject *object_);
+
+	/** Parse a filter expression into a tree of nodes. Members of the structures are looked up once so
+	  * that evaluating the filter only reads values from the structures.
+	  * \param[in]  expression_  The filter expression (e.g. "vandle.mult>0 && trigger.mult>0").
+	  * \param[in]  elementwise_ If true, vector members without an index refer to the current element (see GetValue()).
+	  *                          Otherwise, vector members must be indexed.
+	  * \return True if the expression was compiled successfully and false otherwise.
+	  */
+	bool Compile(const std::string &expression_, const bool &elementwise_=false);
+
+	/** Evaluate the expression for the current values of all structures.
+	  * \param[in]  element_ The element of vector members without an index (elementwise expressions only).
+	  * \return The value of the expression.
+	  */
+	double GetValue(const int &element_=0);
+
+	/** Get the number of elements of an elementwise expression, i.e. the smallest size of all vector members without an index.
+	  * \return The number of elements or -1 if the expression has no such members.
+	  */
+	long GetLength() const;
+
+	/** Evaluate the filter for the current values of all structures and count the result.
+	  * \return True if the event passes the filter and false otherwise.
+	  */
+	bool Accept();
+
+	/// Return the filter expression.
+	std::string GetExpression() const { return expression; }
+
+	/// Return the description of the last parsing error.
+	std::string GetError() const { return error; }
+
+	/// Return the total number of accepted events.
+	unsigned long long GetNumAccepted() const { return numAccepted; }
+
+	/// Return the total number of rejected events.
+	unsigned long long GetNumRejected() const { return numRejected; }
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef EVENTINDEX_HPP
+#define EVENTINDEX_HPP
+
+#include <vector>
+#include <string>
+
+class TObject;
+class TTree;
+class AsyncWriter;
+class EventFilter;
+
+///////////////////////////////////////////////////////////////////////////////
+// class EventIndex
+///////////////////////////////////////////////////////////////////////////////
+
+class EventIndex{
+  private:
+	std::vector<std::string> names; /// Names of all indexed structures (i.e. the processor types).
+	std::vector<EventFilter*> values; /// Compiled multiplicity expression of each structure.
+
+	double time; /// Time of the current event since the first start event (in s).
+	unsigned long long mask; /// Bit i is set if structure i has a non-zero multiplicity.
+	std::vector<unsigned short> mult; /// Multiplicity of each structure.
+
+  public:
+	/// Default constructor.
+	EventIndex() : time(0), mask(0) { }
+
+	/// Destructor.
+	~EventIndex();
+
+	/// Return the number of indexed structures.
+	size_t GetNumStructures() const { return names.size(); }
+
+	/** Add a structure to the index. The structure must have a "mult" member. At most 64 structures may be added.
+	  * \param[in]  name_   Name of the structure (i.e. the processor type).
+	  * \param[in]  object_ Pointer to the structure. Must remain valid while the index is filled.
+	  * \return True if the structure was added and false otherwise.
+	  */
+	bool AddStructure(const std::string &name_, TObject *object_);
+
+	/** Add the index branches to a tree. The tree has a "time" and "mask" branch and one "<type>_mult"
+	  * branch per structure, in the same order as the bits of the mask. Must be called after all structures are added.
+	  * \param[in]  tree_   Pointer to the output index tree.
+	  * \param[in]  writer_ Pointer to the asynchronous writer filling the tree (if any).
+	  * \return True if the branches were added successfully and false otherwise.
+	  */
+	bool Branch(TTree *tree_, AsyncWriter *writer_=NULL);
+
+	/** Update the index values from the current values of all structures. Must be called before the index tree is filled.
+	  * \param[in]  time_ Time of the current event since the first start event (in s).
+	  * \return Nothing.
+	  */
+	void Update(const double &time_);
+};
+
+#endif
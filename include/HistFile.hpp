@@ -0,0 +1,99 @@
+#ifndef HISTFILE_HPP
+#define HISTFILE_HPP
+
+#include <vector>
+#include <string>
+
+#include "EventFilter.hpp"
+
+class TObject;
+class TFile;
+class Plotter;
+
+///////////////////////////////////////////////////////////////////////////////
+// class HistEntry
+///////////////////////////////////////////////////////////////////////////////
+
+class HistEntry{
+  public:
+	std::string name; /// Name of the histogram.
+	std::string expressions[3]; /// The x, y, and gate expressions (empty if not used).
+	int bins[2]; /// Number of x and y bins.
+	double low[2]; /// Lower edges of the x and y axes.
+	double high[2]; /// Upper edges of the x and y axes.
+
+	EventFilter values[3]; /// Compiled x, y, and gate expressions.
+	Plotter *hist; /// The output histogram.
+
+	/// Default constructor.
+	HistEntry() : hist(NULL) { bins[0] = bins[1] = 0; low[0] = low[1] = high[0] = high[1] = 0; }
+
+	/// Destructor.
+	~HistEntry();
+
+	/// Return true if this is a two-dimensional histogram.
+	bool Is2D() const { return !expressions[1].empty(); }
+
+	/// Fill the histogram with the current values of all structures.
+	void Fill();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class HistFile
+///////////////////////////////////////////////////////////////////////////////
+
+class HistFile{
+  private:
+	bool init;
+
+	std::vector<HistEntry*> entries; /// All histogram definitions.
+
+	void clear_entries();
+
+  public:
+	HistFile();
+
+	HistFile(const char *filename_);
+
+	~HistFile(){ clear_entries(); }
+
+	bool IsInit(){ return init; }
+
+	size_t GetNumHists(){ return entries.size(); }
+
+	/** Load histogram definitions from a file. Each line defines one histogram as
+	  *  <name> <x-expression> <x-bins> <x-low> <x-high> [<y-expression> <y-bins> <y-low> <y-high>] [if <gate-expression>]
+	  * where expressions are written over structure members (e.g. "vandle.ctof"). Expressions may
+	  * not contain spaces, except for the gate expression which takes up the rest of the line.
+	  * \param[in]  filename_ Path to the histogram definition file.
+	  * \return True if the file was loaded successfully and false otherwise.
+	  */
+	bool Load(const char *filename_);
+
+	/** Add a structure whose members may be used in the histogram expressions. Must be called before Compile().
+	  * \param[in]  name_   Name of the structure (i.e. the processor type).
+	  * \param[in]  object_ Pointer to the structure. Must remain valid while histograms are filled.
+	  * \return True if the structure was added and false otherwise.
+	  */
+	bool AddStructure(const std::string &name_, TObject *object_);
+
+	/** Compile all histogram expressions and create the histograms. Vector members without an index
+	  * are filled element by element.
+	  * \return True if all expressions were compiled successfully and false otherwise.
+	  */
+	bool Compile();
+
+	/// Fill all histograms with the current values of all structures.
+	void Fill();
+
+	/// Reset the contents of all histograms.
+	void Zero();
+
+	/** Write all histograms to a root file.
+	  * \param[in]  f_ Pointer to the output root file.
+	  * \return The number of histograms written.
+	  */
+	int Write(TFile *f_);
+};
+
+#endif
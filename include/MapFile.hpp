@@ -7,6 +7,7 @@
 double absdiff(const double &v1, const double &v2);
 
 class XiaData;
+class ChannelEvent;
 class TFile;
 
 class MapEntry{
@@ -16,12 +17,14 @@ class MapEntry{
 	std::string subtype;
 	std::string tag;
 	std::vector<float> args;
+	int roiPre; /// Number of trace samples to keep before the maximum (-1 if the whole trace is kept).
+	int roiPost; /// Number of trace samples to keep after the maximum.
 	
 	MapEntry(){ clear(); }
 
-	MapEntry(const std::string &input_, const char delimiter_=':'){ set(input_, delimiter_); }
+	MapEntry(const std::string &input_, const char delimiter_=':') : roiPre(-1), roiPost(0) { set(input_, delimiter_); }
 	
-	MapEntry(const std::string &type_, const std::string &subtype_, const std::string &tag_){ set(type_, subtype_, tag_); }
+	MapEntry(const std::string &type_, const std::string &subtype_, const std::string &tag_) : roiPre(-1), roiPost(0) { set(type_, subtype_, tag_); }
 	
 	MapEntry(const MapEntry &other);
 
@@ -34,6 +37,25 @@ class MapEntry{
 	void set(const std::string &type_, const std::string &subtype_, const std::string &tag_);
 	
 	void pushArg(const float &arg_){ args.push_back(arg_); }
+
+	/** Add an argument from the map file. Arguments of the form "roi:<pre>:<post>" set the trace
+	  * region of interest and all other arguments are added to the list of numerical arguments.
+	  * \param[in]  arg_ The argument string.
+	  * \return False if the argument is an invalid region of interest and true otherwise.
+	  */
+	bool pushArg(const std::string &arg_);
+
+	/// Return true if only a region of interest of the trace is to be written.
+	bool hasROI() const { return (roiPre >= 0); }
+
+	/** Get the region of interest of the trace of an event. The region starts roiPre samples before the
+	  * maximum of the trace and is shifted to stay within the trace. Computes the baseline of the event.
+	  * \param[in]  event_  The channel event.
+	  * \param[out] offset_ Index of the first sample of the region.
+	  * \param[out] length_ Number of samples in the region.
+	  * \return True if the region is shorter than the trace and false if the whole trace should be written.
+	  */
+	bool getROI(ChannelEvent *event_, size_t &offset_, size_t &length_);
 	
 	void clear();
 	
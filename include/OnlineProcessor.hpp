@@ -83,6 +83,9 @@ class OnlineProcessor{
 	  *  return True if the histogram exists and false otherwise.
 	  */
 	bool Zero(const unsigned int &hist_id_);
+
+	/// Zero all diagnostic histograms.
+	void ZeroAll();
 	
 	/// Add a processor's histograms to the list of plottable items.
 	void AddHists(Processor *proc_);
@@ -0,0 +1,102 @@
+#ifndef PRESORTREADER_HPP
+#define PRESORTREADER_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+
+#include "SpillIndex.hpp"
+
+class XiaData;
+class Unpacker;
+
+///////////////////////////////////////////////////////////////////////////////
+// class PresortReader
+///////////////////////////////////////////////////////////////////////////////
+
+class PresortReader{
+  private:
+	std::string filename; /// Path to the input presort file.
+
+	char *data; /// Pointer to the start of the memory-mapped file.
+	size_t length; /// Length of the file (in bytes).
+
+	SpillIndex index; /// Index of all spills in the file.
+
+	std::vector<bool> traceMask; /// Set to true for each channel (16*mod+chan) whose ADC trace is kept.
+	bool keepAllTraces; /// Set to true if the ADC traces of all channels are kept.
+
+	double windowLow; /// Lower edge of the raw event time window (in pixie clock ticks).
+	double windowHigh; /// Upper edge of the raw event time window (in pixie clock ticks).
+
+	unsigned long long numEvents; /// Total number of channel events decoded.
+	unsigned long long numRawEvents; /// Total number of raw events decoded.
+	unsigned long long skippedTraceBytes; /// Total number of ADC trace bytes which were not copied.
+
+	/** Check whether or not a raw event falls inside the time window.
+	  * \param[in]  rawEvent_ The channel events of the raw event.
+	  * \return True if the earliest channel event is inside the window and false otherwise.
+	  */
+	bool InTimeWindow(const std::deque<XiaData*> &rawEvent_) const;
+
+  public:
+	/// Default constructor.
+	PresortReader();
+
+	/// Destructor.
+	~PresortReader();
+
+	/** Map a presort file into memory and build its spill index. The index is read from the
+	  * footer of the file if one exists. Otherwise, all spills in the file are walked.
+	  * \param[in]  fname_ Path to the input presort file.
+	  * \return True if the file was mapped and at least one spill was found and false otherwise.
+	  */
+	bool Open(const std::string &fname_);
+
+	/// Unmap the input file.
+	void Close();
+
+	/** Set whether or not the ADC trace of a channel is copied into its channel event.
+	  * \param[in]  mod_   Pixie module number.
+	  * \param[in]  chan_  Pixie channel number.
+	  * \param[in]  state_ Set to true if the trace is required.
+	  * \return Nothing.
+	  */
+	void SetTraceFlag(const unsigned int &mod_, const unsigned int &chan_, const bool &state_=true);
+
+	/// Copy the ADC traces of all channels.
+	void KeepAllTraces(const bool &state_=true){ keepAllTraces = state_; }
+
+	/** Only decode raw events whose earliest channel event falls inside a time window. Spills
+	  * whose time range lies entirely outside the window are skipped using the spill index.
+	  * \param[in]  tmin_ Lower edge of the window in pixie clock ticks. A negative value leaves the window open below.
+	  * \param[in]  tmax_ Upper edge of the window (exclusive) in pixie clock ticks. A negative value leaves the window open above.
+	  * \return Nothing.
+	  */
+	void SetTimeWindow(const double &tmin_, const double &tmax_){ windowLow = tmin_; windowHigh = tmax_; }
+
+	/** Decode all raw events of a spill directly from the mapped file.
+	  * \param[in]  index_ Index of the spill in the file.
+	  * \param[in]  core_  Pointer to the unpacker used to allocate new channel events.
+	  * \param[out] block_ Deque of raw events, each of which is a deque of channel events. Decoded raw events are appended.
+	  * \return The number of raw events appended to the block.
+	  */
+	size_t ReadSpill(const size_t &index_, Unpacker *core_, std::deque<std::deque<XiaData*> > &block_);
+
+	/// Return the number of spills in the file.
+	size_t GetNumSpills() const { return index.size(); }
+
+	/// Return the length of the file (in bytes).
+	size_t GetLength() const { return length; }
+
+	/// Return the total number of channel events decoded.
+	unsigned long long GetNumEvents() const { return numEvents; }
+
+	/// Return the total number of raw events decoded.
+	unsigned long long GetNumRawEvents() const { return numRawEvents; }
+
+	/// Return the total number of ADC trace bytes which were not copied.
+	unsigned long long GetSkippedTraceBytes() const { return skippedTraceBytes; }
+};
+
+#endif
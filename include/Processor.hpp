@@ -3,8 +3,10 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 
 #include "XiaData.hpp"
+#include "AsyncWriter.hpp"
 
 #include "TF1.h"
 #include "TFitResultPtr.h"
@@ -13,6 +15,10 @@ class CalibEntry;
 class MapEntry;
 class MapFile;
 class Plotter;
+class ColumnWriter;
+class HistFile;
+class TraceCache;
+class TraceCodec;
 
 class TTree;
 class TBranch;
@@ -74,6 +80,7 @@ class FittingFunction{
 class Processor{
   private:
 	std::deque<ChannelEventPair*> events;	  
+	std::deque<ChannelEventPair*> blockEvents; /// Events from a whole block of raw events awaiting preprocessing.
 
 	std::string name;
 	std::string type;
@@ -81,6 +88,11 @@ class Processor{
 	bool use_color_terminal;
 	bool presortData; /// True if data is being read in from a presort file.
 
+	TraceCache *trace_cache; /// Cache of trace analysis results (if any).
+	std::vector<unsigned long long> cacheHashes; /// Hash of the analysis parameters of each channel (16*mod+chan).
+
+	TraceCodec *trace_codec; /// Codec used to compress traces before they are written (if any).
+
 	clock_t start_time;
 	unsigned long total_time;
 	
@@ -99,6 +111,15 @@ class Processor{
 	Trace *root_waveform; /// Root data structure for storing traces.
 	Trace *root_waveformR; /// Root data structure for storing right detector traces.
 
+	std::vector<unsigned char> packed_waveform; /// Compressed traces of the current event (see TraceCodec).
+
+	std::vector<unsigned short> roi_offset; /// Index of the first sample of each written trace region.
+	std::vector<float> roi_baseline; /// Baseline of each written trace region.
+	bool write_roi; /// Set to true if any channel of this processor writes only a region of interest of its traces.
+	bool flat_output; /// Set to true if the structure is written using the flat output layout.
+
+	BufferBase *structure_buffer; /// Typed snapshot buffer of root_structure for asynchronous output.
+
 	float defaultCFD[3]; /// Default CFD parameters (F, D, L)
 
 	bool use_trace; /// Force the use of the ADC trace. Any events without a trace will be rejected.
@@ -118,6 +139,20 @@ class Processor{
 	TF1 *fitting_func;
 	FittingFunction *actual_func;
   
+	/// Return the number of channels of this processor's type in the map file.
+	size_t GetNumMappedChannels();
+
+	/// Set the root data structure and create a snapshot buffer of its concrete type.
+	template <class T>
+	void SetRootStructure(T *structure_){
+		root_structure = (Structure*)structure_;
+		delete structure_buffer;
+		structure_buffer = new StructureBuffer<T>(structure_);
+
+		// Reserve room for one event from every channel so that filling never reallocates.
+		structure_->Reserve(GetNumMappedChannels());
+	}
+
 	/// Start the process timer
 	void StartProcess(){ start_time = clock(); }
 	
@@ -138,7 +173,26 @@ class Processor{
 	
 	TF1 *SetFitFunction();
 
+	/** Copy the ADC trace of an event to the output. If a trace codec is set, the trace is compressed
+	  * and appended to the packed trace buffer instead. Only the region of interest is copied for
+	  * channels which define one in the map file.
+	  * \param[in]  event_  The channel event whose trace to copy.
+	  * \param[in]  entry_  The map entry of the channel.
+	  * \param[out] trace_  The trace structure to append the trace to (when not compressing).
+	  * \return Nothing.
+	  */
+	void AppendTrace(ChanEvent *event_, MapEntry *entry_, Trace *trace_);
+
 	bool HandleSingleEndedEvents();
+
+	/// Compute the baseline, integral, and phase of a trace. Return true if the analysis succeeded.
+	bool AnalyzeTrace(ChanEvent *event_, MapEntry *entry_);
+
+	/// Return the hash of all parameters which affect the trace analysis of a channel.
+	unsigned long long GetParameterHash(ChannelEventPair *pair_);
+
+	/// Compute the high resolution time and energy of a single event.
+	void PreProcessEvent(ChannelEventPair *pair_);
 	
 	bool HandleDoubleEndedEvents();
 
@@ -167,6 +221,9 @@ class Processor{
 	std::string GetType(){ return type; }
 	
 	std::string GetName(){ return name; }
+
+	/// Return a pointer to the output data structure of this processor.
+	Structure *GetStructure(){ return root_structure; }
 	
 	TF1 *GetFunction(){ return fitting_func; }
 	
@@ -175,21 +232,45 @@ class Processor{
 	bool ToggleFitting(){ return (use_fitting = !use_fitting); }
 	
 	bool ToggleTraces(){ return (write_waveform = !write_waveform); }
+
+	/// Enable or disable filling of the trace structure.
+	bool SetWriteTraces(const bool &state_=true){ return (write_waveform = state_); }
 	
 	bool SetPresortMode(bool state_=true){ return (presortData = state_); }
 
+	/// Read trace analysis results from a cache instead of recomputing them.
+	void SetTraceCache(TraceCache *cache_){ trace_cache = cache_; }
+
+	/// Compress traces with a codec and write them to a "<type>_packed" branch instead of the trace structure.
+	void SetTraceCodec(TraceCodec *codec_){ trace_codec = codec_; }
+
+	/// Write the structure as a multiplicity leaf and one fixed-size array leaf per member instead of a single object branch.
+	bool SetFlatOutput(const bool &state_=true){ return (flat_output = state_); }
+
 	void SetDefaultCfdParameters(const float &F_, const float &D_=1, const float &L_=1){ defaultCFD[0] = F_; defaultCFD[1] = D_; defaultCFD[2] = L_; }
 	
-	bool Initialize(TTree *tree_);
+	bool Initialize(TTree *tree_, const int &splitLevel_=99, AsyncWriter *writer_=NULL);
 	
-	bool InitializeTraces(TTree *tree_);
+	bool InitializeTraces(TTree *tree_, const int &splitLevel_=99, AsyncWriter *writer_=NULL);
+
+	/// Add the data structure of this processor to a columnar output.
+	bool InitializeColumns(ColumnWriter *writer_);
+
+	/// Add the data structure of this processor to a list of histograms. Used in place of an output tree.
+	bool InitializeHists(HistFile *hists_);
 
 	float Status(unsigned long global_events_);
 
 	void AddEvent(ChannelEventPair *event_){ events.push_back(event_); }
+
+	/// Add an event to the list of events which will be preprocessed by PreProcessBlock().
+	void AddBlockEvent(ChannelEventPair *event_){ blockEvents.push_back(event_); }
 	
 	void PreProcess();
 
+	/// Preprocess all events from a block of raw events in a single pass and clear the block list.
+	void PreProcessBlock();
+
 	bool Process(ChannelEventPair *start_);
 	
 	/// Finish processing of events by clearing the event list.
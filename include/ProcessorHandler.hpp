@@ -4,6 +4,14 @@
 #include <vector>
 
 class TTree;
+class AsyncWriter;
+class ColumnWriter;
+class EventFilter;
+class EventIndex;
+class HistFile;
+class SkimStream;
+class TraceCache;
+class TraceCodec;
 
 class ChannelEventPair;
 class MapEntry;
@@ -42,10 +50,34 @@ class ProcessorHandler{
 	bool ToggleTraces();
 	
 	bool SetPresortMode(bool state_=true);
+
+	/// Set the cache of trace analysis results used by all processors.
+	void SetTraceCache(TraceCache *cache_);
+
+	/// Set the codec used by all processors to compress ADC traces.
+	void SetTraceCodec(TraceCodec *codec_);
+
+	/// Write the structures of all processors using the flat output layout.
+	void SetFlatOutput(const bool &state_=true);
 	
-	bool InitRootOutput(TTree *tree_);
+	bool InitRootOutput(TTree *tree_, const int &splitLevel_=99, AsyncWriter *writer_=NULL);
 	
-	bool InitTraceOutput(TTree *tree_);
+	bool InitTraceOutput(TTree *tree_, const int &splitLevel_=99, AsyncWriter *writer_=NULL);
+
+	/// Add the data structure of each processor to a columnar output.
+	bool InitColumnOutput(ColumnWriter *writer_);
+
+	/// Add the data structure of each processor to an output event filter.
+	bool InitEventFilter(EventFilter *filter_);
+
+	/// Add the data structure of each processor to a list of histograms. Used in place of an output tree.
+	bool InitHistOutput(HistFile *hists_);
+
+	/// Add the data structure of each processor to a skim output stream.
+	bool InitSkimOutput(SkimStream *skim_, const int &splitLevel_=99);
+
+	/// Add the data structure of each processor to an event index.
+	bool InitEventIndex(EventIndex *index_);
 	
 	bool CheckProcessor(std::string type_);
 	
@@ -55,9 +87,20 @@ class ProcessorHandler{
 	
 	bool AddStart(ChannelEventPair *pair_);
 
+	/// Add an event to its processor's list of events for block preprocessing.
+	bool AddBlockEvent(ChannelEventPair *pair_);
+
 	bool PreProcess();
-	
-	bool Process();
+
+	/// Preprocess all events added with AddBlockEvent() in a single pass for each processor.
+	bool PreProcessBlock();
+	
+	/** Process all events in the current raw event.
+	  * \param[in]  preprocess_ Call each processor's preprocess routine before processing. Set to false if 
+	  *                         the events have already been preprocessed by PreProcessBlock().
+	  * \return True if at least one processor found a valid signal and false otherwise.
+	  */
+	bool Process(const bool &preprocess_=true);
 	
 	unsigned long GetTotalEvents(){ return total_events; }
 	
@@ -2,7 +2,10 @@
 #define SCANNER_HPP
 
 #include <string>
+#include <vector>
 #include <fstream>
+#include <chrono>
+#include <mutex>
 
 // PixieCore libraries
 #include "Unpacker.hpp"
@@ -12,8 +15,10 @@
 #include "TTree.h"
 
 #include "Structures.h"
+#include "SpillIndex.hpp"
 
 class ChannelEventPair;
+class ChannelEvent;
 
 class MapFile;
 class ConfigFile;
@@ -22,6 +27,16 @@ class ProcessorHandler;
 class OnlineProcessor;
 class Plotter;
 
+class AsyncWriter;
+class ColumnWriter;
+class SpillWriter;
+class TraceCache;
+class TraceCodec;
+class EventFilter;
+class EventIndex;
+class HistFile;
+class SkimStream;
+
 class TFile;
 class TCanvas;
 
@@ -38,6 +53,12 @@ class extTree : public TTree {
 
 	TCanvas *canvas; /// Canvas for plotting histograms.
 
+	bool fillTiming; /// Set to true if the time spent in TTree::Fill() is to be recorded.
+	double fillWallTime; /// Total wall time spent in TTree::Fill() (in seconds).
+	double fillCpuTime; /// Total process CPU time spent in TTree::Fill() by all threads (in seconds).
+
+	static std::mutex outputLock; /// Lock shared by all tree fills and by all drawing to canvases.
+
 	/** Open a TCanvas if this tree has not already done so.
 	  * \return Pointer to an open TCanvas.
 	  */
@@ -62,9 +83,27 @@ class extTree : public TTree {
 	bool SafeDraw(const std::string &expr_, const std::string &gate_="", const std::string &opt_="");
 	
 	/** Safely fill the tree and draw a histogram using TTree::Draw() if required.
-	  * \return The return value from TTree::Draw().
+	  * \param[in]  writer_ Pointer to an asynchronous writer which fills the tree on its own thread. If NULL, the tree is filled directly.
+	  * \return The return value from TTree::Fill() or AsyncWriter::Fill().
 	  */
-	int SafeFill();
+	int SafeFill(AsyncWriter *writer_=NULL);
+
+	/** Fill the tree while holding the output lock. Records the time spent filling if timing is enabled.
+	  * \return The return value from TTree::Fill().
+	  */
+	virtual int Fill();
+
+	/// Enable or disable recording of the time spent in TTree::Fill().
+	void SetFillTiming(const bool &state_=true){ fillTiming = state_; }
+
+	/// Return the total wall time spent in TTree::Fill() (in seconds).
+	double GetFillWallTime() const { return fillWallTime; }
+
+	/// Return the total process CPU time spent in TTree::Fill() (in seconds).
+	double GetFillCpuTime() const { return fillCpuTime; }
+
+	/// Return the lock which must be held while drawing to any canvas while output trees are being filled.
+	static std::mutex &GetOutputLock(){ return outputLock; }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -77,19 +116,91 @@ class simpleUnpacker : public Unpacker {
 	simpleUnpacker();
 	
 	/// Destructor.
-	~simpleUnpacker(){  }
+	~simpleUnpacker();
 	
 	extTree *GetTree(){ return stat_tree; }
 
 	/** Initialize the raw event statistics tree.
+	  * \param[in]  writer_ Pointer to an asynchronous writer to use for filling the tree. If NULL, the tree is filled directly.
 	  * \return Pointer to the TTree.
 	  */
-	extTree *InitTree();
+	extTree *InitTree(AsyncWriter *writer_=NULL);
+
+	/** Flag a channel so that its events are dropped before being passed to the scan.
+	  * \param[in]  mod_  Pixie module number.
+	  * \param[in]  chan_ Pixie channel number.
+	  * \return Nothing.
+	  */
+	void RejectChannel(const unsigned int &mod_, const unsigned int &chan_);
+
+	/** Check whether or not a channel has been flagged for early rejection.
+	  * \param[in]  mod_  Pixie module number.
+	  * \param[in]  chan_ Pixie channel number.
+	  * \return True if events from this channel are dropped and false otherwise.
+	  */
+	bool IsRejected(const unsigned int &mod_, const unsigned int &chan_) const;
+
+	/** Get the number of events which were dropped for a single channel.
+	  * \param[in]  mod_  Pixie module number.
+	  * \param[in]  chan_ Pixie channel number.
+	  * \return The number of rejected events for the specified channel.
+	  */
+	unsigned long GetRejectedCount(const unsigned int &mod_, const unsigned int &chan_) const;
+
+	/// Return the total number of events which were dropped from all channels.
+	unsigned long GetTotalRejected() const { return totalRejected; }
+
+	/// Return the number of channels in the rejection bitmap.
+	size_t GetMaskSize() const { return rejectMask.size(); }
+
+	/** Set the number of raw events to collect before handing them to the scan as a single block.
+	  * \param[in]  size_ The number of raw events per block. A value of 1 disables block processing.
+	  * \return The new block size.
+	  */
+	unsigned int SetBlockSize(const unsigned int &size_){ return (blockSize = (size_ > 0 ? size_ : 1)); }
+
+	/// Return the number of raw events per block.
+	unsigned int GetBlockSize() const { return blockSize; }
+
+	/** Send all raw events in the current block to the scan for processing.
+	  * \param[in]  addr_ Pointer to a simpleScanner object.
+	  * \return The number of raw events in the block.
+	  */
+	size_t FlushBlock(ScanInterface *addr_);
+
+	/** Only pass raw events whose earliest channel event falls inside a time window to the scan.
+	  * \param[in]  tmin_ Lower edge of the window in pixie clock ticks. A negative value leaves the window open below.
+	  * \param[in]  tmax_ Upper edge of the window (exclusive) in pixie clock ticks. A negative value leaves the window open above.
+	  * \return Nothing.
+	  */
+	void SetTimeWindow(const double &tmin_, const double &tmax_);
+
+	/// Return the number of raw events which were dropped for falling outside of the time window.
+	unsigned long GetWindowRejected() const { return windowRejected; }
 	
   private:
 	extTree *stat_tree; /// Output TTree for storing low-level statistics.
+	AsyncWriter *writer; /// Asynchronous writer used to fill the statistics tree (if any).
+
+	std::vector<bool> rejectMask; /// Bitmap of channels (ID = 16*mod + chan) whose events are dropped by the unpacker.
+	std::vector<unsigned long> rejectCounts; /// Number of events dropped for each channel ID.
+	unsigned long totalRejected; /// Total number of events dropped by the unpacker.
+
+	std::deque<std::deque<XiaData*> > eventBlock; /// Block of raw events waiting to be sent to the scan.
+	unsigned int blockSize; /// The number of raw events to collect before sending them to the scan.
+
+	double windowLow; /// Lower edge of the raw event time window (in pixie clock ticks).
+	double windowHigh; /// Upper edge of the raw event time window (in pixie clock ticks).
+	bool useTimeWindow; /// Set to true if raw events outside of the time window are to be dropped.
+	unsigned long windowRejected; /// Number of raw events dropped for falling outside of the time window.
+
+	/** Check whether or not the earliest channel event in the raw event falls inside the time window.
+	  * \return True if the raw event is inside the window and false otherwise.
+	  */
+	bool InTimeWindow() const;
 
-	/** Return a pointer to a new XiaData channel event.
+	/** Return a pointer to a new XiaData channel event. The event is allocated as
+	  * a ChanEvent so that the scanner may adopt it directly without copying it.
 	  * \return A pointer to a new XiaData.
 	  */
 	virtual XiaData *GetNewEvent();
@@ -199,6 +310,7 @@ class simpleScanner : public ScanInterface {
 
 	/** Add a channel event to the deque of events to send to the processors.
 	  * This method should only be called from Unpacker::ProcessRawEvent().
+	  * The scanner takes ownership of the event, which must be a ChanEvent.
 	  * \param[in]  event_ The raw XiaData to add.
 	  * \return True if the event is added to the processor handler, and false otherwise.
 	  */
@@ -210,6 +322,26 @@ class simpleScanner : public ScanInterface {
 	  */
 	virtual bool ProcessEvents();
 
+	/** Process a block of raw events. All channel events in the block are preprocessed
+	  * in a single pass by each processor before the raw events are processed and written
+	  * to the output one at a time. This method should only be called from simpleUnpacker::FlushBlock()
+	  * or ScanPresortFile().
+	  * \param[in]  block_ Deque of raw events, each of which is a deque of channel events.
+	  * \return The number of raw events in which at least one valid signal was found.
+	  */
+	unsigned int ProcessBlock(std::deque<std::deque<XiaData*> > &block_);
+
+	/** Scan a presort file using the memory-mapped presort reader instead of the generic input path.
+	  * Each spill is decoded directly into a block of raw events, and ADC traces are only copied for
+	  * channels which require them.
+	  * \param[in]  fname_ Path to the input presort file.
+	  * \return True if the file was scanned successfully and false otherwise.
+	  */
+	bool ScanPresortFile(const std::string &fname_);
+
+	/// Return the path to the presort file to scan with the memory-mapped reader (empty if not used).
+	std::string GetMmapInput() const { return mmap_input; }
+
 	/** Write pixie events in the raw event to the output presort file.
 	  * \param[in]  forceWrite Close the raw event spill even if the threshold has not been reached.
 	  */
@@ -223,27 +355,79 @@ class simpleScanner : public ScanInterface {
 	OnlineProcessor *online; /// Pointer to the online processor to use for online plotting.
 	
 	std::deque<ChannelEventPair*> chanEventList;
+	std::vector<std::vector<ChannelEventPair*> > blockPairs; /// Channel event pairs for each raw event in the current block.
 	
-	std::streampos spillLengthIndex;
 	unsigned int spillThreshold;
 	unsigned int currSpillLength;
 	unsigned int maxSpillLength;
 	std::ofstream psort_file;
+
+	std::vector<char> spillBuffer; /// Buffer used to assemble the current presort spill in memory.
+	size_t spillBufferUsed; /// The number of bytes of the current presort spill in the spill buffer.
+	SpillWriter *spill_writer; /// Writer used to write complete presort spills to the output file.
+	size_t spill_flush_size; /// The number of bytes of complete spills to collect before writing to the presort file.
+	bool async_presort; /// Set to true if presort spills are written on a background thread.
+
+	SpillIndex presortIndex; /// Index of all spills written to the current presort output file.
+	SpillEntry presortSpill; /// Index entry of the spill currently being written to the presort output file.
 	
 	TFile *root_file; /// Output root file for storing data.
 	extTree *root_tree; /// Output TTree for storing processed data.
 	extTree *trace_tree; /// Output TTree for storing raw ADC traces.
+	TFile *trace_file; /// Separate output file for the trace tree (if any).
+	std::string trace_filename; /// Path to the separate output file for the trace tree.
+	unsigned long long data_entries; /// The number of entries written to the data tree (or columnar output) of the current chunk.
+	unsigned long long trace_entry; /// Index of the data tree entry of the current trace tree entry (within the current output file).
+	unsigned int trace_chunk; /// Output chunk of the data tree entry of the current trace tree entry.
+	TraceCodec *trace_codec; /// Codec used to compress ADC traces (if any).
 	extTree *raw_tree; /// Output TTree for storing raw pixie data.
+	extTree *index_tree; /// Output TTree for storing the event index of the data tree.
+	EventIndex *event_index; /// Time, detector mask, and multiplicities of each data tree entry (if any).
 	extTree *stat_tree; /// Output TTree for storing low-level statistics.
+
+	AsyncWriter *writer; /// Background thread for filling the output trees.
+	unsigned int async_slots; /// The number of snapshots queued by the asynchronous writer.
+	unsigned int io_threads; /// The number of threads used by root for implicit multithreading of output (0 for disabled).
+
+	ColumnWriter *columns; /// Columnar output used in place of the data tree (if any).
+	EventFilter *event_filter; /// Filter which events must pass to be written to the output (if any).
+	std::vector<SkimStream*> skims; /// Skim outputs written alongside the data tree in the same pass.
+
+	HistFile *hist_file; /// Histograms filled in place of the output trees (if any).
+	std::string hist_filename; /// Path to the histogram definition file.
+	std::string column_directory; /// Output directory for columnar data.
+
+	std::string mmap_input; /// Presort file to scan with the memory-mapped reader.
+
+	TraceCache *trace_cache; /// Cache of trace analysis results (if any).
+	std::string trace_cache_dir; /// Directory containing the trace analysis cache files.
 	
 	Plotter *chanCounts; /// 2d root histogram to store number of total channel counts found.
 	Plotter *chanMaxADC; /// 2d root histogram to store the energy spectra from all channels.
 	Plotter *chanEnergy; /// 2d histogram to store filter energy from all channels.
+
+	std::chrono::steady_clock::time_point output_start; /// Time at which the root output file was opened.
 	
 	int events_since_last_update; /// The number of processed events since the last online histogram update.
 	int events_between_updates; /// The number of events to process before updating online histograms.
 	
 	int loaded_files; /// The number of files which have been processed.
+
+	unsigned long long rotate_size; /// Start a new output chunk when the current file reaches this size (in bytes, 0 disables).
+	double rotate_time; /// Start a new output chunk after this much wall-clock time (in seconds, 0 disables).
+	unsigned int rotate_files; /// Start a new output chunk after this many input files (0 disables).
+
+	unsigned int chunk_number; /// Index of the current output chunk.
+	unsigned int chunk_files; /// The number of input files written to the current output chunk.
+	double chunk_start_time; /// Total data time at the start of the current output chunk (in seconds).
+	double rotated_events; /// Total number of channel events written to all previous output chunks.
+	unsigned long long rotated_bytes; /// Total number of bytes written to all previous output chunks.
+	std::chrono::steady_clock::time_point chunk_start; /// Time at which the current output chunk was opened.
+	
+	unsigned int block_size; /// The number of raw events to process as a single block.
+
+	double window_low; /// Lower edge of the user specified raw event time window (in pixie clock ticks).
+	double window_high; /// Upper edge of the user specified raw event time window (in pixie clock ticks).
 	
 	unsigned short xia_data_location; /// ID = (16*mod + chan); taken from the channel event.
 	unsigned short xia_data_energy; /// Raw pixie energy taken directly from the module (a.u.).
@@ -262,11 +446,133 @@ class simpleScanner : public ScanInterface {
 	bool online_mode; /// Set to true if online mode is to be used.
 	bool use_root_fitting; /// Set to true if root TF1 fitting is to be used for trace analysis.
 	bool write_traces; /// Set to true if ADC traces are to be written to the output file.
+	bool compress_traces; /// Set to true if ADC traces are to be compressed with the trace codec.
 	bool write_raw; /// Set to true if raw pixie module data is to be written to the output file.
+	bool write_index; /// Set to true if an event index of the data tree is to be written to the output file.
+	bool flat_output; /// Set to true if the data tree is to be written using the flat output layout.
 	bool write_stats; /// Set to true if event builder information is to be written to the output file.
+	bool async_output; /// Set to true if the output trees are to be filled on a background thread.
 	bool init; /// Set to true when the initialization process successfully completes.
 	
 	std::string head_path;
+
+	/** Map a channel event and link it to its map and calibration entries.
+	  * \param[in]  event_ The raw XiaData to map. Deleted if the channel is not mapped.
+	  * \return Pointer to the new ChannelEventPair or NULL if the event was rejected.
+	  */
+	ChannelEventPair *BuildPair(XiaData *event_);
+
+	/** Pass a channel event pair to the processor handler and add it to the current raw event.
+	  * \param[in]  pair_ The pair to add. Deleted if no processor accepts the event.
+	  * \return True if the pair is added to the processor handler, and false otherwise.
+	  */
+	bool AddPair(ChannelEventPair *pair_);
+
+	/** Process all channel events in the current raw event and clear the event list.
+	  * \param[in]  preprocessed_ Set to true if the events have already been preprocessed.
+	  * \return True if at least one valid signal was found, and false otherwise.
+	  */
+	bool ProcessCurrentEvent(const bool &preprocessed_=false);
+
+	/** Update the online canvas if enough raw events have been processed since the last update.
+	  * \param[in]  count_ The number of raw events which were processed since the last call.
+	  * \return Nothing.
+	  */
+	void CheckOnlineUpdate(const int &count_=1);
+
+	/** Get the name used to identify the current input file in the trace analysis cache.
+	  * \return The input filename if it is available (from the file information or the memory-mapped input), or the run number, or the output filename.
+	  */
+	std::string GetCacheRunName();
+
+	/** Reserve space at the end of the presort spill buffer.
+	  * \param[in]  size_ The number of bytes to reserve.
+	  * \return Pointer to the start of the reserved space. The spill buffer length is not changed.
+	  */
+	char *ReserveSpillBuffer(const size_t &size_);
+
+	/** Write a pixie event to a buffer keeping only a region of interest of its trace. The offset of the region and
+	  * the baseline of the trace are stored in two extra header words, in place of the external timestamp words.
+	  * \param[in]  event_  The channel event to write.
+	  * \param[out] ptr_    Buffer to write the event to.
+	  * \param[in]  offset_ Index of the first sample of the region.
+	  * \param[in]  length_ Number of samples in the region.
+	  * \return The number of bytes written to the buffer.
+	  */
+	int WriteEventROI(ChannelEvent *event_, char *ptr_, const size_t &offset_, const size_t &length_);
+
+	/** Print the uncompressed size, compressed size, and compression ratio of an output tree.
+	  * \param[in]  tree_ Pointer to the output tree.
+	  * \return Nothing.
+	  */
+	void PrintTreeStats(TTree *tree_);
+
+	/** Print the time spent filling an output tree and the speedup from parallel basket compression.
+	  * \param[in]  tree_ Pointer to the output tree.
+	  * \return Nothing.
+	  */
+	void PrintFillStats(extTree *tree_);
+
+	/// Return true if the output is to be split into chunks.
+	bool RotationEnabled() const { return (rotate_size > 0 || rotate_time > 0 || rotate_files > 0); }
+
+	/** Get the filename of the current output chunk. If rotation is disabled, this is the output filename.
+	  * Otherwise, the chunk number is appended to the output filename (e.g. run_003.root).
+	  * \return The filename of the current output chunk.
+	  */
+	std::string GetChunkFilename();
+
+	/** Get the filename of a skim output. The name of the skim is appended to the output filename (e.g. run_vandle.root).
+	  * \param[in]  name_ Name of the skim.
+	  * \return The filename of the skim output.
+	  */
+	std::string GetSkimFilename(const std::string &name_);
+
+	/** Open a new root output file.
+	  * \param[in]  fname_ Path to the output file.
+	  * \return Pointer to the open file or NULL if the file could not be opened.
+	  */
+	TFile *OpenRootFile(const std::string &fname_);
+
+	/** Write the head directory and the map, config, and calibration entries to the root output file.
+	  * \return Nothing.
+	  */
+	void WriteSetupInfo();
+
+	/** Write the information of the current input file to the head directory of the root output file
+	  * or write a header to the presort output file.
+	  * \return Nothing.
+	  */
+	void WriteFileInfo();
+
+	/** Set up the output for a new input file. Must be called once for each input file before it is scanned.
+	  * \return Nothing.
+	  */
+	void StartInputFile();
+
+	/** Write the data time, all output trees, and all histograms of the current chunk to the root output file.
+	  * \param[in]  verbose_ Print the number of entries written to each tree.
+	  * \return Nothing.
+	  */
+	void WriteRootOutput(const bool &verbose_);
+
+	/** Write the footer of the presort output file, update its header, and close it.
+	  * \param[in]  runTime_ The total data time of the file (in seconds).
+	  * \return Nothing.
+	  */
+	void ClosePresortFile(const double &runTime_);
+
+	/** Start a new output chunk if the current chunk has reached the size or time limit.
+	  * \return True if a new chunk was started and false otherwise.
+	  */
+	bool CheckRotation();
+
+	/** Close the current output chunk and start a new one. The new chunk is a complete output file
+	  * with its own head, map, config, and calib directories.
+	  * \param[in]  copyFileInfo_ Write the information of the current input file to the new chunk.
+	  * \return True if the new chunk was opened successfully and false otherwise.
+	  */
+	bool RotateOutput(const bool &copyFileInfo_);
 };
 
 #endif
@@ -0,0 +1,88 @@
+#ifndef SKIMSTREAM_HPP
+#define SKIMSTREAM_HPP
+
+#include <string>
+#include <vector>
+
+#include "ConfigFile.hpp"
+#include "EventFilter.hpp"
+
+class TObject;
+class TFile;
+class TTree;
+
+///////////////////////////////////////////////////////////////////////////////
+// class SkimStream
+///////////////////////////////////////////////////////////////////////////////
+
+class SkimStream{
+  private:
+	SkimConfig config; /// Name, branch list, and filter of the skim.
+
+	std::string filename; /// Path to the output file of the skim.
+
+	TFile *file; /// Output file of the skim.
+	TTree *tree; /// Output tree of the skim.
+
+	EventFilter filter; /// Compiled filter expression.
+	std::vector<std::string> structures; /// Names of all structures added to the skim.
+	int numBranches; /// Number of structures written to the output tree.
+
+	unsigned long long numFilled; /// Total number of entries written to the skim.
+
+  public:
+	/** Default constructor.
+	  * \param[in]  config_ Name, branch list, and filter of the skim.
+	  * \param[in]  file_   The open output file of the skim. The skim takes ownership of the file.
+	  */
+	SkimStream(const SkimConfig &config_, TFile *file_);
+
+	/// Destructor. Closes the output file.
+	~SkimStream();
+
+	/// Return the name of the skim.
+	std::string GetName() const { return config.name; }
+
+	/// Return the path to the output file of the skim.
+	std::string GetFilename() const { return filename; }
+
+	/// Return the description of the last filter parsing error.
+	std::string GetError() const { return filter.GetError(); }
+
+	/// Return the output tree of the skim.
+	TTree *GetTree(){ return tree; }
+
+	/// Return the number of structures written to the output tree.
+	int GetNumBranches() const { return numBranches; }
+
+	/// Return the total number of entries written to the skim.
+	unsigned long long GetNumFilled() const { return numFilled; }
+
+	/// Return the total number of events checked by the skim filter.
+	unsigned long long GetNumEvents() const { return filter.GetNumAccepted() + filter.GetNumRejected(); }
+
+	/** Add the data structure of a processor. The structure is branched to the output tree if its type
+	  * is in the branch list of the skim, and it may always be used in the filter expression.
+	  * \param[in]  name_       Name of the structure (i.e. the processor type).
+	  * \param[in]  object_     Pointer to the structure. Must remain valid until Close() is called.
+	  * \param[in]  splitLevel_ Split level of the branch.
+	  * \return True if the structure was added successfully and false otherwise.
+	  */
+	bool AddStructure(const std::string &name_, TObject *object_, const int &splitLevel_=99);
+
+	/** Compile the filter expression of the skim. Must be called after all structures are added.
+	  * Prints a warning for each type in the branch list which does not match any structure.
+	  * \return True if the filter was compiled successfully and false otherwise.
+	  */
+	bool Compile();
+
+	/** Fill the output tree if the current event passes the filter of the skim.
+	  * \return True if the event was written and false otherwise.
+	  */
+	bool Fill();
+
+	/// Write the output tree and close the output file.
+	void Close();
+};
+
+#endif
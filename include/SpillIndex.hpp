@@ -0,0 +1,134 @@
+#ifndef SPILLINDEX_HPP
+#define SPILLINDEX_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+
+extern const unsigned int fileFooterWord; /// "EOF "
+extern const unsigned int fileHeaderWord; /// "HEAD"
+extern const unsigned int dataHeaderWord; /// "DATA"
+extern const unsigned int endBufferWord; /// Raw event and spill delimiter.
+extern const unsigned int indexHeaderWord; /// "INDX"
+extern const unsigned int roiHeaderTag; /// "RO" tag in the upper half of the trace region of interest header word.
+
+///////////////////////////////////////////////////////////////////////////////
+// class SpillEntry
+///////////////////////////////////////////////////////////////////////////////
+
+class SpillEntry{
+  public:
+	unsigned long long offset; /// Byte offset of the spill's DATA word from the start of the file.
+	unsigned int length; /// Length of the spill in 4-byte words (not including the DATA word and the length word).
+	unsigned int numEvents; /// Number of pixie events found in the spill.
+	double firstTime; /// Earliest pixie event time in the spill (in pixie clock ticks).
+	double lastTime; /// Latest pixie event time in the spill (in pixie clock ticks).
+
+	/// Default constructor.
+	SpillEntry() : offset(0), length(0), numEvents(0), firstTime(-1), lastTime(-1) { }
+
+	/// Offset constructor.
+	SpillEntry(const unsigned long long &offset_, const unsigned int &length_) : offset(offset_), length(length_), numEvents(0), firstTime(-1), lastTime(-1) { }
+
+	/// Return the size of the spill on disk (in bytes) including the DATA word and the length word.
+	unsigned long long GetSize() const { return 4*((unsigned long long)length + 2); }
+
+	/// Return true if a valid time range was found for this spill.
+	bool HasTime() const { return (firstTime >= 0 && lastTime >= 0); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class SpillIndex
+///////////////////////////////////////////////////////////////////////////////
+
+class SpillIndex{
+  private:
+	std::vector<SpillEntry> spills; /// List of all spills found in the file.
+
+	unsigned long long headerLength; /// Length of the file header in bytes (i.e. the offset of the first spill).
+	unsigned long long fileLength; /// Total length of the file in bytes.
+
+	bool init; /// Set to true when the index has been built successfully.
+
+	/** Search the start of the file for the first DATA spill. A candidate is accepted
+	  * only if it is followed directly by another DATA spill or by the end of the file.
+	  * \param[in]  file_ Input file stream.
+	  * \return True if the first spill was found and false otherwise.
+	  */
+	bool FindFirstSpill(std::ifstream &file_);
+
+	/** Read the spill index from the footer of a presorted pld file.
+	  * \param[in]  file_ Input file stream.
+	  * \return True if a valid footer index was found and false otherwise.
+	  */
+	bool ReadFooter(std::ifstream &file_);
+
+  public:
+	/// Default constructor.
+	SpillIndex();
+
+	/** Build the spill index of a pld (or presorted pld) file. If the file ends with a spill index
+	  * footer, the index is read from the footer. Otherwise, all DATA spills in the file are walked.
+	  * \param[in]  filename_   Path to the input file.
+	  * \param[in]  parseTimes_ Decode the pixie event headers in each spill to find the event count and time range.
+	  * \param[in]  useFooter_  Read the index from the footer of the file, if present.
+	  * \return True if at least one spill was found and false otherwise.
+	  */
+	bool Build(const char *filename_, const bool &parseTimes_=true, const bool &useFooter_=true);
+
+	/** Write the index as a footer following the EOF words of a presorted pld file. Readers which
+	  * stop at the EOF words are unaffected. The footer is laid out as
+	  *  INDX, version, number of spills, header length (8 B), one 32 B record per spill, footer offset (8 B), INDX
+	  * where each record holds the offset (8 B), length (4 B), event count (4 B), and first and last time (8 B each).
+	  * \param[in]  file_ Output file stream, positioned directly after the EOF words.
+	  * \return True if the footer was written successfully and false otherwise.
+	  */
+	bool WriteFooter(std::ostream *file_) const;
+
+	/** Find the number of pixie events and the time range of a spill of raw pixie module data.
+	  * \param[in]  data_   Pointer to the first word of the spill (after the length word).
+	  * \param[in]  nWords_ Length of the spill in 4-byte words.
+	  * \param[out] entry_  Spill entry to update.
+	  * \return The number of events found in the spill.
+	  */
+	static unsigned int ParseSpill(unsigned int *data_, const unsigned int &nWords_, SpillEntry &entry_);
+
+	/// Remove all entries from the index.
+	void Clear();
+
+	/// Add an entry to the end of the index.
+	void Add(const SpillEntry &entry_){ spills.push_back(entry_); }
+
+	/// Set the length of the file header in bytes.
+	void SetHeaderLength(const unsigned long long &length_){ headerLength = length_; }
+
+	/// Return true if the index has been built successfully.
+	bool IsInit() const { return init; }
+
+	/// Return the number of spills in the index.
+	size_t size() const { return spills.size(); }
+
+	/// Return true if the index contains no spills.
+	bool empty() const { return spills.empty(); }
+
+	/// Return a reference to a spill entry.
+	SpillEntry &at(const size_t &index_){ return spills.at(index_); }
+
+	/// Return the length of the file header in bytes.
+	unsigned long long GetHeaderLength() const { return headerLength; }
+
+	/// Return the total length of the file in bytes.
+	unsigned long long GetFileLength() const { return fileLength; }
+
+	/** Find the first spill which may contain events at or after a given time.
+	  * \param[in]  time_ Pixie clock time to search for.
+	  * \return The index of the spill or size() if no such spill exists.
+	  */
+	size_t FindSpill(const double &time_) const;
+
+	/// Print the index to the screen.
+	void Print() const;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SPILLWRITER_HPP
+#define SPILLWRITER_HPP
+
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+///////////////////////////////////////////////////////////////////////////////
+// class SpillWriter
+///////////////////////////////////////////////////////////////////////////////
+
+class SpillWriter{
+  private:
+	std::ofstream *file; /// Output file stream.
+
+	std::vector<char> pending; /// Completed spills waiting to be written.
+	std::vector<char> writing; /// Spills currently being written by the background thread.
+
+	size_t flushSize; /// The number of pending bytes at which the pending spills are written to file.
+
+	unsigned long long position; /// File position following all data passed to the writer (in bytes).
+	unsigned long long numWrites; /// Number of calls to std::ofstream::write().
+
+	bool async; /// Set to true if spills are written on a background thread.
+	bool busy; /// Set to true while the background thread is writing.
+	bool stopping; /// Set to true when the background thread has been asked to finish.
+
+	std::thread writerThread; /// Thread used for writing spills to file.
+	std::mutex writeMutex; /// Lock for the write buffers.
+	std::condition_variable dataReady; /// Signals the background thread that spills are ready to be written.
+	std::condition_variable writeDone; /// Signals the scan thread that the background thread is idle.
+
+	/// Main loop of the background thread.
+	void Run();
+
+	/// Write all pending spills to file (or pass them to the background thread).
+	void WritePending();
+
+  public:
+	/** Default constructor.
+	  * \param[in]  file_      Pointer to the output file stream.
+	  * \param[in]  flushSize_ The number of bytes of completed spills to collect before writing them to file.
+	  * \param[in]  async_     Write spills to file on a background thread.
+	  */
+	SpillWriter(std::ofstream *file_, const size_t &flushSize_=1048576, const bool &async_=false);
+
+	/// Destructor. Writes all pending spills and stops the background thread.
+	~SpillWriter();
+
+	/** Add a complete spill to the output. The spill is copied, so the caller may reuse its buffer.
+	  * \param[in]  data_   Pointer to the start of the spill (including the DATA word and the length word).
+	  * \param[in]  length_ Length of the spill (in bytes).
+	  * \return The file position of the start of the spill (in bytes).
+	  */
+	unsigned long long Write(const char *data_, const size_t &length_);
+
+	/// Write all pending spills and wait until they are on file. Must be called before writing to the file directly.
+	void Flush();
+
+	/// Flush all pending spills and set the current position from the file. Must be called after writing to the file directly.
+	void Sync();
+
+	/// Return the file position following all data passed to the writer (in bytes).
+	unsigned long long Tell() const { return position; }
+
+	/// Return the number of writes made to the output file.
+	unsigned long long GetNumWrites() const { return numWrites; }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef TRACECACHE_HPP
+#define TRACECACHE_HPP
+
+#include <string>
+#include <fstream>
+#include <map>
+
+#include "XiaData.hpp"
+
+typedef ChannelEvent ChanEvent;
+
+extern const unsigned int cacheHeaderWord; /// "TRCC"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CacheRecord
+///////////////////////////////////////////////////////////////////////////////
+
+class CacheRecord{
+  public:
+	double time; /// Pixie time of the hit, used to check that the cache matches the input data.
+	float baseline; /// Baseline of the trace.
+	float phase; /// Phase of the trace (in ADC clock ticks).
+	float qdc; /// Uncalibrated integral of the pulse.
+	float qdc2; /// Uncalibrated integral of the pulse in the second integration window.
+	float stddev; /// Standard deviation of the baseline.
+	float maximum; /// Baseline-corrected maximum of the trace.
+	unsigned int max_index; /// Index of the maximum ADC value in the trace.
+	unsigned short max_ADC; /// Maximum ADC value in the trace.
+	unsigned short valid; /// Set to 1 if the trace analysis succeeded.
+
+	/// Default constructor.
+	CacheRecord() : time(0), baseline(0), phase(0), qdc(0), qdc2(0), stddev(0), maximum(0), max_index(0), max_ADC(0), valid(0) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CacheChannel
+///////////////////////////////////////////////////////////////////////////////
+
+class CacheChannel{
+  public:
+	enum CacheMode {READ, WRITE, STALE};
+
+	CacheMode mode; /// READ if results are read from the cache, WRITE if results are computed and stored, and STALE if the cache does not match the data.
+	unsigned long long hash; /// Hash of the analysis parameters of the channel.
+	std::string filename; /// Path to the cache file of the channel.
+	std::ifstream input; /// Input cache file (READ mode).
+	std::ofstream output; /// Temporary output cache file (WRITE mode).
+
+	/// Default constructor.
+	CacheChannel() : mode(WRITE), hash(0) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class TraceCache
+///////////////////////////////////////////////////////////////////////////////
+
+class TraceCache{
+  private:
+	std::string directory; /// Directory containing the cache files.
+	std::string run; /// Name of the current run.
+
+	std::map<unsigned int, CacheChannel*> channels; /// Cache state of each channel (16*mod+chan) of the current run.
+
+	unsigned long long numRead; /// Total number of hits whose results were read from the cache.
+	unsigned long long numWritten; /// Total number of hits whose results were computed and stored.
+	unsigned int numReused; /// Total number of channels whose cache was reused.
+	unsigned int numRecomputed; /// Total number of channels which were recomputed.
+	unsigned int numStale; /// Total number of channels whose cache did not match the input data.
+
+	/** Open the cache of a channel for the current run. If a cache file exists and was written with the same
+	  * analysis parameters, it is opened for reading. Otherwise, a new cache file is started.
+	  * \param[in]  chanID_ Channel ID (16*mod+chan).
+	  * \param[in]  hash_   Hash of the analysis parameters of the channel.
+	  * \return Pointer to the cache state of the channel.
+	  */
+	CacheChannel *OpenChannel(const unsigned int &chanID_, const unsigned long long &hash_);
+
+  public:
+	/** Default constructor.
+	  * \param[in]  directory_ Directory containing the cache files.
+	  */
+	TraceCache(const std::string &directory_);
+
+	/// Destructor. Closes the cache files of the current run.
+	~TraceCache();
+
+	/** Set the name of the current run. The cache files of the previous run are closed.
+	  * \param[in]  run_ Name of the run (used as a prefix for all cache files).
+	  * \return Nothing.
+	  */
+	void SetRun(const std::string &run_);
+
+	/** Read the trace analysis results of the next hit of a channel from the cache.
+	  * \param[in]  chanID_ Channel ID (16*mod+chan).
+	  * \param[in]  hash_   Hash of the analysis parameters of the channel.
+	  * \param[out] event_  The channel event to update.
+	  * \return True if the results were read from the cache and false if they must be computed.
+	  */
+	bool Read(const unsigned int &chanID_, const unsigned long long &hash_, ChanEvent *event_);
+
+	/** Store the trace analysis results of a hit. Results are only stored for channels which are
+	  * not being read from the cache.
+	  * \param[in]  chanID_ Channel ID (16*mod+chan).
+	  * \param[in]  event_  The analyzed channel event.
+	  * \return Nothing.
+	  */
+	void Write(const unsigned int &chanID_, ChanEvent *event_);
+
+	/// Close all cache files of the current run. New cache files replace the old ones and stale cache files are removed.
+	void Close();
+
+	/// Print statistics about cache usage.
+	void Print() const;
+
+	/** Compute the 64-bit FNV-1a hash of a string.
+	  * \param[in]  str_ The string to hash.
+	  * \return The hash of the string.
+	  */
+	static unsigned long long Hash(const std::string &str_);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef TRACECODEC_HPP
+#define TRACECODEC_HPP
+
+#include <vector>
+#include <map>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+// class TraceCodecStats
+///////////////////////////////////////////////////////////////////////////////
+
+class TraceCodecStats{
+  public:
+	unsigned long long numTraces; /// Number of traces encoded.
+	unsigned long long rawBytes; /// Size of the uncompressed traces (in bytes).
+	unsigned long long packedBytes; /// Size of the encoded traces (in bytes).
+	double encodeTime; /// Total time spent encoding (in seconds).
+
+	/// Default constructor.
+	TraceCodecStats() : numTraces(0), rawBytes(0), packedBytes(0), encodeTime(0) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class TraceCodec
+///////////////////////////////////////////////////////////////////////////////
+
+class TraceCodec{
+  private:
+	std::vector<int> residuals; /// Buffer for the zigzag encoded sample differences of a trace.
+
+	std::map<unsigned short, TraceCodecStats> stats; /// Encoding statistics for each channel (16*mod+chan).
+
+  public:
+	/// Default constructor.
+	TraceCodec(){ }
+
+	/** Encode a single ADC trace and append it to an output buffer. Each encoded trace is laid out as
+	  * channel ID (2 B), number of samples (2 B), first sample (2 B), the full number of samples (4 B, only
+	  * if the 2 B field holds 0xFFFF), blocks
+	  * where each block of up to 32 samples holds its bit width (1 B) followed by the bit-packed, zigzag
+	  * encoded differences between neighboring samples. Baseline regions need only a few bits per sample.
+	  * \param[in]  trace_  Pointer to the first ADC sample.
+	  * \param[in]  length_ Number of samples in the trace.
+	  * \param[in]  chanID_ Channel ID (16*mod+chan).
+	  * \param[out] output_ Buffer to append the encoded trace to.
+	  * \return The number of bytes appended to the output buffer.
+	  */
+	size_t Encode(const unsigned short *trace_, const size_t &length_, const unsigned short &chanID_, std::vector<unsigned char> &output_);
+
+	/** Decode a single encoded trace.
+	  * \param[in]  data_   Pointer to the start of the encoded trace.
+	  * \param[in]  size_   Number of bytes available.
+	  * \param[out] output_ Vector to append the decoded samples to.
+	  * \param[out] chanID_ Channel ID of the trace (optional).
+	  * \return The number of bytes read or 0 if the trace is invalid.
+	  */
+	static size_t Decode(const unsigned char *data_, const size_t &size_, std::vector<unsigned short> &output_, unsigned short *chanID_=NULL);
+
+	/** Decode all traces in a buffer.
+	  * \param[in]  data_   Buffer of encoded traces.
+	  * \param[out] output_ Vector to append the decoded samples of all traces to.
+	  * \return The number of traces decoded.
+	  */
+	static unsigned int DecodeAll(const std::vector<unsigned char> &data_, std::vector<unsigned short> &output_);
+
+	/// Print the compression ratio and encoding throughput of each channel.
+	void Print() const;
+};
+
+#endif
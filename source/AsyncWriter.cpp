@@ -0,0 +1,139 @@
+#include <iostream>
+
+// Local files
+#include "AsyncWriter.hpp"
+
+/// Main loop of the writer thread.
+void AsyncWriter::Run(){
+	while(true){
+		size_t slot;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			while(count == 0 && !stopping)
+				dataReady.wait(lock);
+			if(count == 0){ break; } // Stopping with nothing left to write.
+			slot = tail;
+		}
+
+		// The scan thread does not touch this slot until it is released below.
+		TTree *tree = slotTrees[slot];
+		std::vector<BufferBase*> *buffers = &branches.find(tree)->second;
+		{
+			std::lock_guard<std::mutex> lock(fillMutex);
+			for(std::vector<BufferBase*>::iterator iter = buffers->begin(); iter != buffers->end(); ++iter){
+				(*iter)->Load(slot);
+			}
+			tree->Fill();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			tail = (tail + 1) % numSlots;
+			count--;
+			numFills++;
+		}
+		slotFree.notify_all();
+	}
+}
+
+/** Default constructor.
+  * \param[in]  numSlots_ The number of snapshots which may be queued before the scan thread must wait.
+  */
+AsyncWriter::AsyncWriter(const size_t &numSlots_/*=64*/){
+	numSlots = (numSlots_ > 0 ? numSlots_ : 1);
+	slotTrees.assign(numSlots, NULL);
+	head = 0;
+	tail = 0;
+	count = 0;
+	numFills = 0;
+	numWaits = 0;
+	running = false;
+	stopping = false;
+}
+
+/// Destructor. Stops the writer thread.
+AsyncWriter::~AsyncWriter(){
+	Stop();
+	for(std::vector<BufferBase*>::iterator iter = owned.begin(); iter != owned.end(); ++iter){
+		delete (*iter);
+	}
+}
+
+/** Register a buffer with the writer and create a branch which reads from it. The buffer is not owned by the writer.
+  * \param[in]  tree_       Pointer to the output tree.
+  * \param[in]  name_       Name of the new branch.
+  * \param[in]  buffer_     Pointer to the buffer for the new branch.
+  * \param[in]  bufsize_    Basket size of the new branch.
+  * \param[in]  splitLevel_ Split level of the new branch.
+  * \return Pointer to the new branch.
+  */
+TBranch *AsyncWriter::AddBranch(TTree *tree_, const char *name_, BufferBase *buffer_, const int &bufsize_/*=32000*/, const int &splitLevel_/*=99*/){
+	if(!tree_ || !buffer_ || running){ return NULL; }
+	buffer_->Resize(numSlots);
+	branches[tree_].push_back(buffer_);
+	return buffer_->MakeBranch(tree_, name_, bufsize_, splitLevel_);
+}
+
+/// Start the writer thread.
+bool AsyncWriter::Start(){
+	if(running){ return false; }
+	stopping = false;
+	writerThread = std::thread(&AsyncWriter::Run, this);
+	return (running = true);
+}
+
+/** Take a snapshot of all objects in a tree and queue it to be filled by the writer thread.
+  * Waits for a free slot if the queue is full.
+  * \param[in]  tree_ Pointer to the output tree.
+  * \return The number of queued snapshots or -1 if the tree is not handled by the writer.
+  */
+int AsyncWriter::Fill(TTree *tree_){
+	std::map<TTree*, std::vector<BufferBase*> >::iterator tree = branches.find(tree_);
+	if(!running || tree == branches.end()){ return -1; }
+
+	size_t slot;
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		if(count >= numSlots){
+			numWaits++;
+			while(count >= numSlots)
+				slotFree.wait(lock);
+		}
+		slot = head;
+	}
+
+	// The head slot is not in use by the writer thread, so it may be filled without holding the lock.
+	for(std::vector<BufferBase*>::iterator iter = tree->second.begin(); iter != tree->second.end(); ++iter){
+		(*iter)->Store(slot);
+	}
+	slotTrees[slot] = tree_;
+
+	int retval;
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		head = (head + 1) % numSlots;
+		retval = ++count;
+	}
+	dataReady.notify_one();
+
+	return retval;
+}
+
+/// Wait until all queued snapshots have been written.
+void AsyncWriter::Flush(){
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while(running && count > 0)
+		slotFree.wait(lock);
+}
+
+/// Write all queued snapshots and stop the writer thread.
+void AsyncWriter::Stop(){
+	if(!running){ return; }
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	dataReady.notify_all();
+	writerThread.join();
+	running = false;
+}
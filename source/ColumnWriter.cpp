@@ -0,0 +1,345 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/stat.h>
+
+// Local files
+#include "ColumnWriter.hpp"
+
+// Root libraries
+#include "TObject.h"
+#include "TClass.h"
+#include "TList.h"
+#include "TDataMember.h"
+
+/// Return the size and data pointer of a std::vector<T> member.
+template <class T>
+size_t vectorData(const void *ptr_, const char **data_){
+	const std::vector<T> *vec = (const std::vector<T>*)ptr_;
+	*data_ = (const char*)vec->data();
+	return vec->size();
+}
+
+/// Return a JSON string with all special characters escaped.
+std::string jsonString(const std::string &str_){
+	std::string retval = "\"";
+	for(std::string::const_iterator iter = str_.begin(); iter != str_.end(); iter++){
+		if(*iter == '\"' || *iter == '\\'){ retval += '\\'; retval += *iter; }
+		else if(*iter == '\n'){ retval += "\\n"; }
+		else if(*iter == '\t'){ retval += "\\t"; }
+		else{ retval += *iter; }
+	}
+	return retval + "\"";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class ColumnField
+///////////////////////////////////////////////////////////////////////////////
+
+/** Set the schema type, element width, and vector accessor of this field from a C++ type name.
+  * \param[in]  typeName_ The true type name of the member (e.g. "vector<double>").
+  * \return True if the type is supported and false otherwise.
+  */
+bool ColumnField::SetType(const std::string &typeName_){
+	std::string elementType = typeName_;
+	isVector = false;
+	if(typeName_.find("vector<") == 0){
+		isVector = true;
+		elementType = typeName_.substr(7, typeName_.find_last_of('>') - 7);
+		elementType.erase(elementType.find_last_not_of(' ') + 1); // Older compilers write "vector<T >".
+	}
+
+	if(elementType == "char" || elementType == "signed char"){ type = "int8"; width = 1; getVector = vectorData<char>; }
+	else if(elementType == "unsigned char"){ type = "uint8"; width = 1; getVector = vectorData<unsigned char>; }
+	else if(elementType == "short"){ type = "int16"; width = 2; getVector = vectorData<short>; }
+	else if(elementType == "unsigned short"){ type = "uint16"; width = 2; getVector = vectorData<unsigned short>; }
+	else if(elementType == "int"){ type = "int32"; width = 4; getVector = vectorData<int>; }
+	else if(elementType == "unsigned int"){ type = "uint32"; width = 4; getVector = vectorData<unsigned int>; }
+	else if(elementType == "long"){ type = "int64"; width = 8; getVector = vectorData<long>; }
+	else if(elementType == "unsigned long"){ type = "uint64"; width = 8; getVector = vectorData<unsigned long>; }
+	else if(elementType == "long long"){ type = "int64"; width = 8; getVector = vectorData<long long>; }
+	else if(elementType == "unsigned long long"){ type = "uint64"; width = 8; getVector = vectorData<unsigned long long>; }
+	else if(elementType == "float" || elementType == "Float16_t"){ type = "float32"; width = 4; getVector = vectorData<float>; }
+	else if(elementType == "double" || elementType == "Double32_t"){ type = "float64"; width = 8; getVector = vectorData<double>; }
+	else if(elementType == "bool" && !isVector){ type = "bool"; width = 1; } // std::vector<bool> has no contiguous storage.
+	else{ return false; }
+
+	// Only fixed-width types are supported, so check that long has the expected size.
+	if((elementType == "long" || elementType == "unsigned long") && sizeof(long) != 8){ return false; }
+
+	if(!isVector) getVector = NULL;
+
+	return true;
+}
+
+/** Add data to the buffer and write the buffer to the column file if it is full.
+  * \param[in]  data_   Pointer to the data to write.
+  * \param[in]  length_ Number of bytes to write.
+  * \param[in]  limit_  The buffer size at which the buffer is written to file (in bytes).
+  * \return Nothing.
+  */
+void ColumnField::Write(const char *data_, const size_t &length_, const size_t &limit_){
+	buffer.insert(buffer.end(), data_, data_ + length_);
+	if(buffer.size() >= limit_) Flush();
+}
+
+/// Write any buffered data to the column file.
+void ColumnField::Flush(){
+	if(!file || buffer.empty()) return;
+	file->write(buffer.data(), buffer.size());
+	bytesWritten += buffer.size();
+	buffer.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class ColumnWriter
+///////////////////////////////////////////////////////////////////////////////
+
+/** Open an output column file.
+  * \param[in]  field_ The field to open a file for.
+  * \return True if the file was opened successfully and false otherwise.
+  */
+bool ColumnWriter::OpenColumn(ColumnField &field_){
+	field_.file = new std::ofstream((directory + "/" + field_.filename).c_str(), std::ios::binary | std::ios::trunc);
+	if(!field_.file->good()){
+		std::cout << " ColumnWriter: Error! Failed to open column file \"" << directory << "/" << field_.filename << "\".\n";
+		delete field_.file;
+		field_.file = NULL;
+		return false;
+	}
+	return true;
+}
+
+/** Write the JSON schema describing all columns to the output directory.
+  * \return True if the schema was written successfully and false otherwise.
+  */
+bool ColumnWriter::WriteSchema(){
+	std::ofstream schema((directory + "/schema.json").c_str());
+	if(!schema.good()){
+		std::cout << " ColumnWriter: Error! Failed to open schema file \"" << directory << "/schema.json\".\n";
+		return false;
+	}
+
+	unsigned short endianTest = 1;
+	bool littleEndian = (*(unsigned char*)&endianTest == 1);
+
+	schema << "{\n";
+	schema << "  \"format\": \"simpleScan columns\",\n";
+	schema << "  \"version\": 1,\n";
+	schema << "  \"byteOrder\": " << (littleEndian ? "\"little\"" : "\"big\"") << ",\n";
+	schema << "  \"entries\": " << entries << ",\n";
+	schema << "  \"structures\": [\n";
+	for(std::vector<ColumnGroup*>::iterator iter = groups.begin(); iter != groups.end(); iter++){
+		ColumnGroup *group = (*iter);
+		schema << "    {\n";
+		schema << "      \"name\": " << jsonString(group->name) << ",\n";
+		schema << "      \"class\": " << jsonString(group->className) << ",\n";
+		schema << "      \"offsets\": " << jsonString(group->offsets.filename) << ",\n";
+		schema << "      \"elements\": " << group->elements << ",\n";
+		schema << "      \"fields\": [\n";
+		for(std::vector<ColumnField>::iterator iter2 = group->fields.begin(); iter2 != group->fields.end(); iter2++){
+			schema << "        { \"name\": " << jsonString(iter2->name) << ", \"type\": " << jsonString(iter2->type);
+			schema << ", \"bytes\": " << iter2->width << ", \"vector\": " << (iter2->isVector ? "true" : "false");
+			schema << ", \"file\": " << jsonString(iter2->filename) << ", \"description\": " << jsonString(iter2->description) << " }";
+			schema << (iter2 + 1 != group->fields.end() ? ",\n" : "\n");
+		}
+		schema << "      ]\n";
+		schema << "    }" << (iter + 1 != groups.end() ? ",\n" : "\n");
+	}
+	schema << "  ]\n";
+	schema << "}\n";
+
+	return schema.good();
+}
+
+/** Default constructor.
+  * \param[in]  bufferSize_ Size of the write buffer of each column (in bytes).
+  */
+ColumnWriter::ColumnWriter(const size_t &bufferSize_/*=1048576*/){
+	bufferSize = bufferSize_;
+	entries = 0;
+	isOpen = false;
+}
+
+/// Destructor. Closes all open column files.
+ColumnWriter::~ColumnWriter(){
+	if(isOpen) Close();
+	for(std::vector<ColumnGroup*>::iterator iter = groups.begin(); iter != groups.end(); iter++){
+		delete (*iter);
+	}
+}
+
+/** Create the output directory. Existing column files in the directory are overwritten.
+  * \param[in]  directory_ Path to the output directory.
+  * \return True if the directory is ready for writing and false otherwise.
+  */
+bool ColumnWriter::Open(const std::string &directory_){
+	if(isOpen){
+		std::cout << " ColumnWriter: Error! Output directory \"" << directory << "\" is already open.\n";
+		return false;
+	}
+
+	directory = directory_;
+	while(directory.size() > 1 && directory.back() == '/') directory.erase(directory.size() - 1);
+
+	if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST){
+		std::cout << " ColumnWriter: Error! Failed to create output directory \"" << directory << "\" (" << strerror(errno) << ").\n";
+		return false;
+	}
+
+	entries = 0;
+
+	return (isOpen = true);
+}
+
+/** Add a structure to the output. One column is created for each persistent member of the structure
+  * using the root dictionary of the structure class. Must be called before the first call to Fill().
+  * \param[in]  name_   Name of the structure (used as the column file prefix).
+  * \param[in]  object_ Pointer to the structure. Must remain valid until Close() is called.
+  * \return True if the structure was added successfully and false otherwise.
+  */
+bool ColumnWriter::AddStructure(const std::string &name_, TObject *object_){
+	if(!isOpen || !object_ || entries > 0) return false;
+
+	TClass *cl = object_->IsA();
+	if(!cl || !cl->GetListOfDataMembers()){
+		std::cout << " ColumnWriter: Error! No dictionary found for structure \"" << name_ << "\".\n";
+		return false;
+	}
+
+	ColumnGroup *group = new ColumnGroup();
+	group->name = name_;
+	group->className = cl->GetName();
+	group->object = (const char*)object_;
+
+	// The offsets column starts with a zero so that the elements of entry i are [offsets[i], offsets[i+1]).
+	group->offsets.name = "offsets";
+	group->offsets.filename = name_ + ".offsets.col";
+	group->offsets.SetType("unsigned long long");
+	if(!OpenColumn(group->offsets)){
+		delete group;
+		return false;
+	}
+	group->offsets.Write((const char*)&group->elements, 8, bufferSize);
+
+	TIter next(cl->GetListOfDataMembers());
+	TDataMember *member;
+	while((member = (TDataMember*)next())){
+		if(!member->IsPersistent()) continue;
+
+		ColumnField field;
+		field.name = member->GetName();
+		field.description = member->GetTitle();
+		field.offset = cl->GetDataMemberOffset(member->GetName());
+		field.filename = name_ + "." + field.name + ".col";
+
+		if(member->GetArrayDim() > 0 || !field.SetType(member->GetTrueTypeName())){
+			std::cout << " ColumnWriter: Warning! Skipping member \"" << name_ << "." << field.name << "\" of unsupported type \"" << member->GetTrueTypeName() << "\".\n";
+			continue;
+		}
+		if(!OpenColumn(field)) continue;
+		if(field.isVector && field.width > padding.size()) padding.assign(field.width, 0);
+
+		group->fields.push_back(field);
+	}
+
+	groups.push_back(group);
+
+	return true;
+}
+
+/** Append the current values of all structures to their columns.
+  * \return The total number of entries written.
+  */
+unsigned long long ColumnWriter::Fill(){
+	if(!isOpen) return entries;
+
+	for(std::vector<ColumnGroup*>::iterator iter = groups.begin(); iter != groups.end(); iter++){
+		ColumnGroup *group = (*iter);
+
+		// The multiplicity of the entry is the length of the first vector member.
+		size_t mult = 0;
+		bool foundVector = false;
+		bool mismatch = false;
+		for(std::vector<ColumnField>::iterator iter2 = group->fields.begin(); iter2 != group->fields.end(); iter2++){
+			const char *member = group->object + iter2->offset;
+			if(!iter2->isVector){
+				iter2->Write(member, iter2->width, bufferSize);
+				continue;
+			}
+
+			const char *data;
+			size_t size = iter2->getVector(member, &data);
+			if(!foundVector){
+				mult = size;
+				foundVector = true;
+			}
+			else if(size != mult){ // Truncate or zero-pad the member so all columns stay aligned with the offsets.
+				mismatch = true;
+				if(size > mult) size = mult;
+			}
+
+			iter2->Write(data, size * iter2->width, bufferSize);
+			for(size_t i = size; i < mult; i++) iter2->Write(padding.data(), iter2->width, bufferSize);
+		}
+
+		if(mismatch) group->mismatches++;
+		group->elements += mult;
+		group->offsets.Write((const char*)&group->elements, 8, bufferSize);
+	}
+
+	return (++entries);
+}
+
+/** Write all buffered data, close all column files, and write the schema.
+  * \return True if the schema was written successfully and false otherwise.
+  */
+bool ColumnWriter::Close(){
+	if(!isOpen) return false;
+
+	for(std::vector<ColumnGroup*>::iterator iter = groups.begin(); iter != groups.end(); iter++){
+		ColumnGroup *group = (*iter);
+		for(std::vector<ColumnField>::iterator iter2 = group->fields.begin(); iter2 != group->fields.end(); iter2++){
+			iter2->Flush();
+			iter2->file->close();
+			delete iter2->file;
+			iter2->file = NULL;
+		}
+		group->offsets.Flush();
+		group->offsets.file->close();
+		delete group->offsets.file;
+		group->offsets.file = NULL;
+
+		if(group->mismatches > 0)
+			std::cout << " ColumnWriter: Warning! Vector members of \"" << group->name << "\" had different lengths in " << group->mismatches << " entries.\n";
+	}
+
+	isOpen = false;
+
+	return WriteSchema();
+}
+
+/// Return the total number of bytes written to all column files.
+unsigned long long ColumnWriter::GetBytesWritten() const {
+	unsigned long long total = 0;
+	for(std::vector<ColumnGroup*>::const_iterator iter = groups.begin(); iter != groups.end(); iter++){
+		for(std::vector<ColumnField>::const_iterator iter2 = (*iter)->fields.begin(); iter2 != (*iter)->fields.end(); iter2++){
+			total += iter2->bytesWritten + iter2->buffer.size();
+		}
+		total += (*iter)->offsets.bytesWritten + (*iter)->offsets.buffer.size();
+	}
+	return total;
+}
+
+/// Print the number of elements and bytes written for each structure.
+void ColumnWriter::Print() const {
+	for(std::vector<ColumnGroup*>::const_iterator iter = groups.begin(); iter != groups.end(); iter++){
+		unsigned long long bytes = (*iter)->offsets.bytesWritten + (*iter)->offsets.buffer.size();
+		for(std::vector<ColumnField>::const_iterator iter2 = (*iter)->fields.begin(); iter2 != (*iter)->fields.end(); iter2++){
+			bytes += iter2->bytesWritten + iter2->buffer.size();
+		}
+		std::cout << "  " << (*iter)->name << " (" << (*iter)->className << "): " << (*iter)->fields.size() << " columns, ";
+		std::cout << (*iter)->elements << " elements, " << bytes / 1048576.0 << " MB\n";
+	}
+}
@@ -3,18 +3,118 @@
 #include <iostream>
 
 #include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
 #include "TObjString.h"
 
 #include "ConfigFile.hpp"
 
-ConfigFile::ConfigFile(){ 
+TreeConfig::TreeConfig(const std::string &name_/*=""*/){
+	name = name_;
+	compressAlgorithm = -1;
+	compressLevel = 0;
+	basketSize = 0;
+	autoFlush = 0;
+	splitLevel = 99;
+}
+
+bool TreeConfig::Set(const std::string &key_, const std::string &value_){
+	if(key_ == "Compression"){ // Expects algorithm[:level] e.g. LZ4:4 or ZSTD:5.
+		size_t index = value_.find(':');
+		std::string alg = value_.substr(0, index);
+		if(alg == "ZLIB" || alg == "zlib"){ compressAlgorithm = 1; compressLevel = 1; }
+		else if(alg == "LZMA" || alg == "lzma"){ compressAlgorithm = 2; compressLevel = 8; }
+		else if(alg == "LZ4" || alg == "lz4"){ compressAlgorithm = 4; compressLevel = 4; }
+		else if(alg == "ZSTD" || alg == "zstd"){ compressAlgorithm = 5; compressLevel = 5; }
+		else if(alg == "none" || alg == "NONE"){ compressAlgorithm = 0; compressLevel = 0; return true; }
+		else{
+			std::cout << "ConfigFile: \033[1;33mWARNING! Unknown compression algorithm (" << alg << ") for tree \"" << name << "\"!\033[0m\n";
+			return false;
+		}
+		if(index != std::string::npos){
+			compressLevel = atoi(value_.substr(index+1).c_str());
+			if(compressLevel < 0) compressLevel = 0;
+			else if(compressLevel > 9) compressLevel = 9;
+		}
+	}
+	else if(key_ == "BasketSize"){ basketSize = atoi(value_.c_str()); }
+	else if(key_ == "AutoFlush"){ autoFlush = strtoll(value_.c_str(), NULL, 0); }
+	else if(key_ == "SplitLevel"){ splitLevel = atoi(value_.c_str()); }
+	else{
+		std::cout << "ConfigFile: \033[1;33mWARNING! Unknown setting (" << key_ << ") for tree \"" << name << "\"!\033[0m\n";
+		return false;
+	}
+	return true;
+}
+
+std::string TreeConfig::GetAlgorithmName() const {
+	switch(compressAlgorithm){
+		case 0: return "none";
+		case 1: return "ZLIB";
+		case 2: return "LZMA";
+		case 4: return "LZ4";
+		case 5: return "ZSTD";
+	}
+	return "default";
+}
+
+bool TreeConfig::Apply(TTree *tree_) const {
+	if(!tree_)
+		return false;
+
+	// Set the compression of all branches (and their sub-branches). Zero disables compression.
+	if(compressAlgorithm >= 0){
+		TIter next(tree_->GetListOfBranches());
+		TBranch *branch;
+		while((branch = (TBranch*)next())){
+			branch->SetCompressionSettings(GetCompressionSettings());
+		}
+	}
+
+	if(basketSize > 0) tree_->SetBasketSize("*", basketSize);
+	if(autoFlush != 0) tree_->SetAutoFlush(autoFlush);
+	
+	return true;
+}
+
+std::string TreeConfig::Print() const {
+	std::stringstream stream;
+	stream << name << ": compression=" << GetAlgorithmName();
+	if(compressAlgorithm > 0) stream << ":" << compressLevel;
+	stream << ", basketSize=";
+	if(basketSize > 0) stream << basketSize;
+	else stream << "default";
+	stream << ", autoFlush=";
+	if(autoFlush != 0) stream << autoFlush;
+	else stream << "default";
+	stream << ", splitLevel=" << splitLevel;
+	return stream.str();
+}
+
+bool SkimConfig::HasBranch(const std::string &type_) const {
+	for(std::vector<std::string>::const_iterator iter = branches.begin(); iter != branches.end(); iter++){
+		if(*iter == "*" || *iter == type_) return true;
+	}
+	return false;
+}
+
+std::string SkimConfig::Print() const {
+	std::stringstream stream;
+	stream << "skim " << name << " ";
+	for(std::vector<std::string>::const_iterator iter = branches.begin(); iter != branches.end(); iter++)
+		stream << (iter != branches.begin() ? "," : "") << *iter;
+	if(!filter.empty()) stream << " " << filter;
+	return stream.str();
+}
+
+ConfigFile::ConfigFile() : dataTree("data"), traceTree("trace"), rawTree("raw"), statsTree("stats") { 
 	eventWidth = 0.5; // Default value of 500 ns
 	eventDelay = 0.0; // Default value of 0 ns
 	buildMethod = 0;
 	init = false;	
 }
 
-ConfigFile::ConfigFile(const char *filename_){ 
+ConfigFile::ConfigFile(const char *filename_) : dataTree("data"), traceTree("trace"), rawTree("raw"), statsTree("stats") { 
 	eventWidth = 0.5; // Default value of 500 ns
 	eventDelay = 0.0; // Default value of 0 ns
 	buildMethod = 0;
@@ -58,9 +158,54 @@ bool ConfigFile::Load(const char *filename_){
 			values[current_value] += line[index];
 		}
 		
-		if(values[0] == "eventWidth"){ eventWidth = atof(values[1].c_str()); }
+		if(values[0] == "configVersion"){ } // Version of the file format, not used.
+		else if(values[0] == "eventWidth"){ eventWidth = atof(values[1].c_str()); }
 		else if(values[0] == "eventDelay"){ eventDelay = atof(values[1].c_str()); }
 		else if(values[0] == "buildMethod"){ buildMethod = atoi(values[1].c_str()); }
+		else if(values[0] == "outputFilter"){ // The expression may contain spaces, so use the rest of the line.
+			size_t start = line.find("outputFilter") + 12;
+			size_t stop = line.find('#', start);
+			outputFilter = line.substr(start, stop == std::string::npos ? std::string::npos : stop - start);
+			outputFilter.erase(0, outputFilter.find_first_not_of(" \t"));
+			outputFilter.erase(outputFilter.find_last_not_of(" \t\r") + 1);
+		}
+		else if(values[0] == "skim"){ // skim <name> <type1,type2,...> [filter expression]
+			std::stringstream stream(line.substr(0, line.find('#')));
+			std::string key, branchList;
+			SkimConfig skim;
+			stream >> key >> skim.name >> branchList;
+			if(skim.name.empty() || branchList.empty()){
+				std::cout << "ConfigFile: \033[1;33mWARNING! On line " << line_num << ", expected a skim name and a list of branches. Ignoring.\033[0m\n";
+				continue;
+			}
+
+			size_t start = 0;
+			while(start <= branchList.size()){
+				size_t stop = branchList.find(',', start);
+				if(stop == std::string::npos) stop = branchList.size();
+				if(stop > start) skim.branches.push_back(branchList.substr(start, stop - start));
+				start = stop + 1;
+			}
+
+			// The filter expression may contain spaces, so use the rest of the line.
+			std::getline(stream, skim.filter);
+			skim.filter.erase(0, skim.filter.find_first_not_of(" \t"));
+			skim.filter.erase(skim.filter.find_last_not_of(" \t\r") + 1);
+
+			skims.push_back(skim);
+		}
+		else if(!values[0].empty()){ // Output tree settings e.g. dataCompression, traceBasketSize, rawAutoFlush, statsSplitLevel.
+			TreeConfig *trees[4] = {&dataTree, &traceTree, &rawTree, &statsTree};
+			bool found = false;
+			for(int i = 0; i < 4 && !found; i++){
+				if(values[0].compare(0, trees[i]->name.size(), trees[i]->name) == 0){
+					trees[i]->Set(values[0].substr(trees[i]->name.size()), values[1]);
+					found = true;
+				}
+			}
+			if(!found)
+				std::cout << "ConfigFile: \033[1;33mWARNING! On line " << line_num << ", unknown configuration key (" << values[0] << "). Ignoring.\033[0m\n";
+		}
 	}
 	
 	return true;
@@ -83,6 +228,22 @@ bool ConfigFile::Write(TFile *f_){
 	str1.Write();
 	str2.Write();
 	str3.Write();
+
+	if(!outputFilter.empty()){
+		TObjString str(("outputFilter " + outputFilter).c_str());
+		str.Write();
+	}
+
+	for(std::vector<SkimConfig>::iterator iter = skims.begin(); iter != skims.end(); iter++){
+		TObjString str(iter->Print().c_str());
+		str.Write();
+	}
+
+	TreeConfig *trees[4] = {&dataTree, &traceTree, &rawTree, &statsTree};
+	for(int i = 0; i < 4; i++){
+		TObjString str(trees[i]->Print().c_str());
+		str.Write();
+	}
 	
 	return true;
 }
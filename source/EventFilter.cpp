@@ -0,0 +1,385 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+// Local files
+#include "EventFilter.hpp"
+
+// Root libraries
+#include "TObject.h"
+#include "TClass.h"
+#include "TDataMember.h"
+
+/// Return the value of a scalar structure member.
+template <class T>
+double scalarValue(const char *ptr_, const int &index_){
+	return (double)(*(const T*)ptr_);
+}
+
+/// Return an element of a std::vector<T> structure member (zero if out of range), or the number of elements if the index is negative.
+template <class T>
+double vectorValue(const char *ptr_, const int &index_){
+	const std::vector<T> *vec = (const std::vector<T>*)ptr_;
+	if(index_ < 0) return (double)vec->size();
+	return ((size_t)index_ < vec->size() ? (double)(*vec)[index_] : 0);
+}
+
+/** Get the member accessor for a C++ type name.
+  * \param[in]  typeName_ The true type name of the member (e.g. "vector<double>").
+  * \param[out] isVector_ Set to true if the member is a std::vector.
+  * \return Pointer to the accessor or NULL if the type is not supported.
+  */
+double (*getAccessor(const std::string &typeName_, bool &isVector_))(const char *, const int &){
+	std::string elementType = typeName_;
+	isVector_ = false;
+	if(typeName_.find("vector<") == 0){
+		isVector_ = true;
+		elementType = typeName_.substr(7, typeName_.find_last_of('>') - 7);
+		elementType.erase(elementType.find_last_not_of(' ') + 1); // Older compilers write "vector<T >".
+	}
+
+	if(elementType == "char" || elementType == "signed char"){ return (isVector_ ? vectorValue<char> : scalarValue<char>); }
+	else if(elementType == "unsigned char"){ return (isVector_ ? vectorValue<unsigned char> : scalarValue<unsigned char>); }
+	else if(elementType == "short"){ return (isVector_ ? vectorValue<short> : scalarValue<short>); }
+	else if(elementType == "unsigned short"){ return (isVector_ ? vectorValue<unsigned short> : scalarValue<unsigned short>); }
+	else if(elementType == "int"){ return (isVector_ ? vectorValue<int> : scalarValue<int>); }
+	else if(elementType == "unsigned int"){ return (isVector_ ? vectorValue<unsigned int> : scalarValue<unsigned int>); }
+	else if(elementType == "long"){ return (isVector_ ? vectorValue<long> : scalarValue<long>); }
+	else if(elementType == "unsigned long"){ return (isVector_ ? vectorValue<unsigned long> : scalarValue<unsigned long>); }
+	else if(elementType == "long long"){ return (isVector_ ? vectorValue<long long> : scalarValue<long long>); }
+	else if(elementType == "unsigned long long"){ return (isVector_ ? vectorValue<unsigned long long> : scalarValue<unsigned long long>); }
+	else if(elementType == "float" || elementType == "Float16_t"){ return (isVector_ ? vectorValue<float> : scalarValue<float>); }
+	else if(elementType == "double" || elementType == "Double32_t"){ return (isVector_ ? vectorValue<double> : scalarValue<double>); }
+	else if(elementType == "bool" && !isVector_){ return scalarValue<bool>; }
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class EventFilter
+///////////////////////////////////////////////////////////////////////////////
+
+/// Skip any whitespace at the current position of the parser.
+void EventFilter::SkipSpace(){
+	while(position < expression.size() && isspace(expression[position])) position++;
+}
+
+/** Check for a token at the current position of the parser and step past it if found.
+  * \param[in]  token_ The token to check for.
+  * \return True if the token was found and false otherwise.
+  */
+bool EventFilter::Match(const char *token_){
+	SkipSpace();
+	size_t length = strlen(token_);
+	if(expression.compare(position, length, token_) != 0) return false;
+	position += length;
+	return true;
+}
+
+/** Add a node to the compiled expression.
+  * \param[in]  type_  Operation of the node.
+  * \param[in]  left_  Index of the left operand node.
+  * \param[in]  right_ Index of the right operand node.
+  * \return The index of the new node.
+  */
+int EventFilter::AddNode(const FilterNode::NodeType &type_, const int &left_/*=-1*/, const int &right_/*=-1*/){
+	FilterNode node;
+	node.type = type_;
+	node.left = left_;
+	node.right = right_;
+	nodes.push_back(node);
+	return (int)nodes.size()-1;
+}
+
+/// Parse a logical or of and-expressions. Returns the index of the node or -1 on error.
+int EventFilter::ParseOr(){
+	int left = ParseAnd();
+	while(left >= 0 && Match("||")){
+		int right = ParseAnd();
+		if(right < 0) return -1;
+		left = AddNode(FilterNode::OR, left, right);
+	}
+	return left;
+}
+
+/// Parse a logical and of comparisons. Returns the index of the node or -1 on error.
+int EventFilter::ParseAnd(){
+	int left = ParseComparison();
+	while(left >= 0 && Match("&&")){
+		int right = ParseComparison();
+		if(right < 0) return -1;
+		left = AddNode(FilterNode::AND, left, right);
+	}
+	return left;
+}
+
+/// Parse a comparison of two sums. Returns the index of the node or -1 on error.
+int EventFilter::ParseComparison(){
+	int left = ParseSum();
+	if(left < 0) return -1;
+
+	// Two-character operators must be checked first.
+	FilterNode::NodeType type;
+	if(Match("==")) type = FilterNode::EQUAL;
+	else if(Match("!=")) type = FilterNode::NOTEQUAL;
+	else if(Match("<=")) type = FilterNode::LESSEQUAL;
+	else if(Match(">=")) type = FilterNode::GREATEREQUAL;
+	else if(Match("<")) type = FilterNode::LESS;
+	else if(Match(">")) type = FilterNode::GREATER;
+	else return left;
+
+	int right = ParseSum();
+	if(right < 0) return -1;
+	return AddNode(type, left, right);
+}
+
+/// Parse a sum of products. Returns the index of the node or -1 on error.
+int EventFilter::ParseSum(){
+	int left = ParseProduct();
+	while(left >= 0){
+		FilterNode::NodeType type;
+		if(Match("+")) type = FilterNode::ADD;
+		else if(Match("-")) type = FilterNode::SUBTRACT;
+		else break;
+		int right = ParseProduct();
+		if(right < 0) return -1;
+		left = AddNode(type, left, right);
+	}
+	return left;
+}
+
+/// Parse a product of unary expressions. Returns the index of the node or -1 on error.
+int EventFilter::ParseProduct(){
+	int left = ParseUnary();
+	while(left >= 0){
+		FilterNode::NodeType type;
+		if(Match("*")) type = FilterNode::MULTIPLY;
+		else if(Match("/")) type = FilterNode::DIVIDE;
+		else break;
+		int right = ParseUnary();
+		if(right < 0) return -1;
+		left = AddNode(type, left, right);
+	}
+	return left;
+}
+
+/// Parse a negation, logical not, number, field, or parenthesized expression. Returns the index of the node or -1 on error.
+int EventFilter::ParseUnary(){
+	if(Match("-")){
+		int operand = ParseUnary();
+		return (operand >= 0 ? AddNode(FilterNode::NEGATE, operand) : -1);
+	}
+	if(Match("!")){
+		int operand = ParseUnary();
+		return (operand >= 0 ? AddNode(FilterNode::NOT, operand) : -1);
+	}
+	if(Match("(")){
+		int operand = ParseOr();
+		if(operand < 0) return -1;
+		if(!Match(")")){
+			error = "Expected ')'";
+			return -1;
+		}
+		return operand;
+	}
+
+	SkipSpace();
+	if(position >= expression.size()){
+		error = "Unexpected end of expression";
+		return -1;
+	}
+
+	// Numerical constant.
+	if(isdigit(expression[position]) || expression[position] == '.'){
+		const char *start = expression.c_str() + position;
+		char *stop;
+		double value = strtod(start, &stop);
+		position += (stop - start);
+		int index = AddNode(FilterNode::CONSTANT);
+		nodes[index].value = value;
+		return index;
+	}
+
+	return ParseField();
+}
+
+/** Parse a structure member of the form "<structure>.<member>" or "<structure>.<member>[<index>]".
+  * \return The index of the node or -1 on error.
+  */
+int EventFilter::ParseField(){
+	std::string names[2];
+	for(int i = 0; i < 2; i++){
+		if(i == 1 && !Match(".")){
+			error = "Expected '.' after structure name \"" + names[0] + "\"";
+			return -1;
+		}
+		SkipSpace();
+		while(position < expression.size() && (isalnum(expression[position]) || expression[position] == '_'))
+			names[i] += expression[position++];
+		if(names[i].empty()){
+			error = (i == 0 ? "Expected a number or structure member" : "Expected a member name");
+			return -1;
+		}
+	}
+
+	FilterStructure *structure = NULL;
+	for(std::vector<FilterStructure>::iterator iter = structures.begin(); iter != structures.end(); iter++){
+		if(iter->name == names[0]){
+			structure = &(*iter);
+			break;
+		}
+	}
+	if(!structure){
+		error = "Unknown structure \"" + names[0] + "\"";
+		return -1;
+	}
+
+	// Look up the member once using the root dictionary of the structure.
+	TClass *cl = structure->object->IsA();
+	TDataMember *member = (cl ? cl->GetDataMember(names[1].c_str()) : NULL);
+	if(!member || member->GetArrayDim() > 0){
+		error = "Unknown member \"" + names[0] + "." + names[1] + "\"";
+		return -1;
+	}
+
+	bool isVector;
+	int index = AddNode(FilterNode::FIELD);
+	nodes[index].field = (const char*)structure->object + cl->GetDataMemberOffset(names[1].c_str());
+	nodes[index].get = getAccessor(member->GetTrueTypeName(), isVector);
+	if(!nodes[index].get){
+		error = "Member \"" + names[0] + "." + names[1] + "\" has unsupported type \"" + member->GetTrueTypeName() + "\"";
+		return -1;
+	}
+
+	// Vector members without an index refer to the current element of an elementwise expression.
+	if(isVector && elementwise) nodes[index].index = -2;
+	if(Match("[")){
+		if(!isVector){
+			error = "Member \"" + names[0] + "." + names[1] + "\" is not a vector";
+			return -1;
+		}
+		SkipSpace();
+		const char *start = expression.c_str() + position;
+		char *stop;
+		long element = strtol(start, &stop, 10);
+		position += (stop - start);
+		if(stop == start || element < 0 || !Match("]")){
+			error = "Expected a non-negative integer index followed by ']'";
+			return -1;
+		}
+		nodes[index].index = (int)element;
+	}
+	else if(isVector && !elementwise){
+		error = "Vector member \"" + names[0] + "." + names[1] + "\" requires an index (use \"" + names[0] + ".mult\" for the multiplicity or \"" + names[0] + "." + names[1] + "[i]\" for an element)";
+		return -1;
+	}
+
+	return index;
+}
+
+/** Evaluate a node of the compiled expression.
+  * \param[in]  index_ Index of the node.
+  * \return The value of the node.
+  */
+double EventFilter::Evaluate(const int &index_) const {
+	const FilterNode &node = nodes[index_];
+	switch(node.type){
+		case FilterNode::CONSTANT: return node.value;
+		case FilterNode::FIELD: return node.get(node.field, (node.index == -2 ? element : node.index));
+		case FilterNode::NEGATE: return -Evaluate(node.left);
+		case FilterNode::NOT: return (Evaluate(node.left) == 0);
+		case FilterNode::ADD: return Evaluate(node.left) + Evaluate(node.right);
+		case FilterNode::SUBTRACT: return Evaluate(node.left) - Evaluate(node.right);
+		case FilterNode::MULTIPLY: return Evaluate(node.left) * Evaluate(node.right);
+		case FilterNode::DIVIDE: return Evaluate(node.left) / Evaluate(node.right);
+		case FilterNode::EQUAL: return (Evaluate(node.left) == Evaluate(node.right));
+		case FilterNode::NOTEQUAL: return (Evaluate(node.left) != Evaluate(node.right));
+		case FilterNode::LESS: return (Evaluate(node.left) < Evaluate(node.right));
+		case FilterNode::LESSEQUAL: return (Evaluate(node.left) <= Evaluate(node.right));
+		case FilterNode::GREATER: return (Evaluate(node.left) > Evaluate(node.right));
+		case FilterNode::GREATEREQUAL: return (Evaluate(node.left) >= Evaluate(node.right));
+		case FilterNode::AND: return (Evaluate(node.left) != 0 && Evaluate(node.right) != 0);
+		case FilterNode::OR: return (Evaluate(node.left) != 0 || Evaluate(node.right) != 0);
+	}
+	return 0;
+}
+
+/** Add a structure whose members may be used in the expression. Must be called before Compile().
+  * \param[in]  name_   Name of the structure (i.e. the processor type).
+  * \param[in]  object_ Pointer to the structure. Must remain valid while the filter is used.
+  * \return True if the structure was added and false otherwise.
+  */
+bool EventFilter::AddStructure(const std::string &name_, TObject *object_){
+	if(!object_ || root >= 0) return false;
+	structures.push_back(FilterStructure(name_, object_));
+	return true;
+}
+
+/** Parse a filter expression into a tree of nodes. Members of the structures are looked up once so
+  * that evaluating the filter only reads values from the structures.
+  * \param[in]  expression_  The filter expression (e.g. "vandle.mult>0 && trigger.mult>0").
+  * \param[in]  elementwise_ If true, vector members without an index refer to the current element (see GetValue()).
+  *                          Otherwise, vector members must be indexed.
+  * \return True if the expression was compiled successfully and false otherwise.
+  */
+bool EventFilter::Compile(const std::string &expression_, const bool &elementwise_/*=false*/){
+	expression = expression_;
+	elementwise = elementwise_;
+	nodes.clear();
+	position = 0;
+	error = "";
+
+	root = ParseOr();
+	SkipSpace();
+	if(root >= 0 && position < expression.size()){
+		error = "Unexpected character '" + expression.substr(position, 1) + "'";
+		root = -1;
+	}
+
+	if(root < 0){
+		std::stringstream stream;
+		stream << error << " at position " << position;
+		error = stream.str();
+		nodes.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/** Evaluate the expression for the current values of all structures.
+  * \param[in]  element_ The element of vector members without an index (elementwise expressions only).
+  * \return The value of the expression.
+  */
+double EventFilter::GetValue(const int &element_/*=0*/){
+	if(root < 0) return 0;
+	element = element_;
+	return Evaluate(root);
+}
+
+/** Get the number of elements of an elementwise expression, i.e. the smallest size of all vector members without an index.
+  * \return The number of elements or -1 if the expression has no such members.
+  */
+long EventFilter::GetLength() const {
+	long length = -1;
+	for(std::vector<FilterNode>::const_iterator iter = nodes.begin(); iter != nodes.end(); iter++){
+		if(iter->type != FilterNode::FIELD || iter->index != -2) continue;
+		long size = (long)iter->get(iter->field, -1);
+		if(length < 0 || size < length) length = size;
+	}
+	return length;
+}
+
+/** Evaluate the filter for the current values of all structures and count the result.
+  * \return True if the event passes the filter and false otherwise.
+  */
+bool EventFilter::Accept(){
+	if(root < 0 || Evaluate(root) != 0){
+		numAccepted++;
+		return true;
+	}
+	numRejected++;
+	return false;
+}
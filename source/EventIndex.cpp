@@ -0,0 +1,76 @@
+#include "TTree.h"
+
+#include "EventIndex.hpp"
+#include "EventFilter.hpp"
+#include "AsyncWriter.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// class EventIndex
+///////////////////////////////////////////////////////////////////////////////
+
+/// Destructor.
+EventIndex::~EventIndex(){
+	for(std::vector<EventFilter*>::iterator iter = values.begin(); iter != values.end(); iter++)
+		delete (*iter);
+}
+
+/** Add a structure to the index. The structure must have a "mult" member. At most 64 structures may be added.
+  * \param[in]  name_   Name of the structure (i.e. the processor type).
+  * \param[in]  object_ Pointer to the structure. Must remain valid while the index is filled.
+  * \return True if the structure was added and false otherwise.
+  */
+bool EventIndex::AddStructure(const std::string &name_, TObject *object_){
+	if(names.size() >= 64) return false;
+
+	EventFilter *value = new EventFilter();
+	if(!value->AddStructure(name_, object_) || !value->Compile(name_ + ".mult")){
+		delete value;
+		return false;
+	}
+
+	names.push_back(name_);
+	values.push_back(value);
+
+	return true;
+}
+
+/** Add the index branches to a tree. The tree has a "time" and "mask" branch and one "<type>_mult"
+  * branch per structure, in the same order as the bits of the mask. Must be called after all structures are added.
+  * \param[in]  tree_   Pointer to the output index tree.
+  * \param[in]  writer_ Pointer to the asynchronous writer filling the tree (if any).
+  * \return True if the branches were added successfully and false otherwise.
+  */
+bool EventIndex::Branch(TTree *tree_, AsyncWriter *writer_/*=NULL*/){
+	if(!tree_) return false;
+
+	// The multiplicities must not be moved once they are branched.
+	mult.assign(names.size(), 0);
+
+	if(writer_){
+		writer_->Branch(tree_, "time", &time);
+		writer_->Branch(tree_, "mask", &mask);
+		for(size_t i = 0; i < names.size(); i++)
+			writer_->Branch(tree_, (names[i] + "_mult").c_str(), &mult[i]);
+	}
+	else{
+		tree_->Branch("time", &time);
+		tree_->Branch("mask", &mask);
+		for(size_t i = 0; i < names.size(); i++)
+			tree_->Branch((names[i] + "_mult").c_str(), &mult[i]);
+	}
+
+	return true;
+}
+
+/** Update the index values from the current values of all structures. Must be called before the index tree is filled.
+  * \param[in]  time_ Time of the current event since the first start event (in s).
+  * \return Nothing.
+  */
+void EventIndex::Update(const double &time_){
+	time = time_;
+	mask = 0;
+	for(size_t i = 0; i < values.size(); i++){
+		mult[i] = (unsigned short)values[i]->GetValue();
+		if(mult[i] > 0) mask |= (1ULL << i);
+	}
+}
@@ -23,7 +23,7 @@ bool GenericBarProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair
 }
 
 GenericBarProcessor::GenericBarProcessor(MapFile *map_) : Processor("GenericBar", "genericbar", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &L_waveform;
 	
 	// Set the detector type to a bar.
@@ -43,7 +43,7 @@ bool GenericProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair *ch
 }
 
 GenericProcessor::GenericProcessor(MapFile *map_) : Processor("Generic", "generic", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 
 	// Do not force the use of a trace. By setting this flag to false,
@@ -34,7 +34,7 @@ bool HagridProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair *chE
 }
 
 HagridProcessor::HagridProcessor(MapFile *map_) : Processor("Hagrid", "hagrid", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 
 	// Set the processor to not use the trace QDC for calibrations.
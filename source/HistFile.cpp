@@ -0,0 +1,210 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include "TFile.h"
+
+#include "HistFile.hpp"
+#include "Plotter.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// class HistEntry
+///////////////////////////////////////////////////////////////////////////////
+
+/// Destructor.
+HistEntry::~HistEntry(){
+	if(hist) delete hist;
+}
+
+/// Fill the histogram with the current values of all structures.
+void HistEntry::Fill(){
+	if(!hist) return;
+
+	// Fill one entry for each element of the unindexed vector members (or a single entry if there are none).
+	long length = -1;
+	for(int i = 0; i < 3; i++){
+		if(expressions[i].empty()) continue;
+		long size = values[i].GetLength();
+		if(size >= 0 && (length < 0 || size < length)) length = size;
+	}
+	if(length < 0) length = 1;
+
+	for(long element = 0; element < length; element++){
+		if(!expressions[2].empty() && values[2].GetValue(element) == 0) continue;
+		if(Is2D()) hist->Fill(values[0].GetValue(element), values[1].GetValue(element));
+		else hist->Fill(values[0].GetValue(element));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class HistFile
+///////////////////////////////////////////////////////////////////////////////
+
+void HistFile::clear_entries(){
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++)
+		delete (*iter);
+	entries.clear();
+}
+
+HistFile::HistFile(){
+	init = false;
+}
+
+HistFile::HistFile(const char *filename_){
+	Load(filename_);
+}
+
+/** Load histogram definitions from a file. Each line defines one histogram as
+  *  <name> <x-expression> <x-bins> <x-low> <x-high> [<y-expression> <y-bins> <y-low> <y-high>] [if <gate-expression>]
+  * where expressions are written over structure members (e.g. "vandle.ctof"). Expressions may
+  * not contain spaces, except for the gate expression which takes up the rest of the line.
+  * \param[in]  filename_ Path to the histogram definition file.
+  * \return True if the file was loaded successfully and false otherwise.
+  */
+bool HistFile::Load(const char *filename_){
+	clear_entries();
+
+	std::ifstream histfile(filename_);
+	if(!histfile.good()){
+		std::cout << "HistFile: \033[1;31mERROR! Failed to open input histogram file!\033[0m\n";
+		return (init = false);
+	}
+
+	init = true;
+
+	std::string line;
+	int line_num = 0;
+	while(true){
+		std::getline(histfile, line);
+		if(histfile.eof() || !histfile.good()){ break; }
+		line_num++;
+
+		// Strip comments.
+		size_t comment = line.find('#');
+		if(comment != std::string::npos) line.erase(comment);
+
+		// The gate expression takes up the rest of the line.
+		std::string gate;
+		std::stringstream stream(line);
+		std::vector<std::string> values;
+		std::string value;
+		while(stream >> value){
+			if(value == "if"){
+				std::getline(stream, gate);
+				gate.erase(0, gate.find_first_not_of(" \t"));
+				gate.erase(gate.find_last_not_of(" \t\r") + 1);
+				break;
+			}
+			values.push_back(value);
+		}
+
+		if(values.empty()){ continue; }
+		else if(values.size() != 5 && values.size() != 9){
+			std::cout << "HistFile: \033[1;33mWARNING! On line " << line_num << ", expected 5 (1d) or 9 (2d) parameters but received " << values.size() << ". Ignoring.\033[0m\n";
+			continue;
+		}
+
+		HistEntry *entry = new HistEntry();
+		entry->name = values.at(0);
+		entry->expressions[2] = gate;
+		for(size_t axis = 0; 4*axis+4 < values.size(); axis++){
+			entry->expressions[axis] = values.at(4*axis+1);
+			entry->bins[axis] = atoi(values.at(4*axis+2).c_str());
+			entry->low[axis] = atof(values.at(4*axis+3).c_str());
+			entry->high[axis] = atof(values.at(4*axis+4).c_str());
+		}
+
+		if(entry->bins[0] <= 0 || (entry->Is2D() && entry->bins[1] <= 0)){
+			std::cout << "HistFile: \033[1;33mWARNING! On line " << line_num << ", invalid number of bins for histogram \"" << entry->name << "\". Ignoring.\033[0m\n";
+			delete entry;
+			continue;
+		}
+
+		entries.push_back(entry);
+	}
+
+	histfile.close();
+
+	return init;
+}
+
+/** Add a structure whose members may be used in the histogram expressions. Must be called before Compile().
+  * \param[in]  name_   Name of the structure (i.e. the processor type).
+  * \param[in]  object_ Pointer to the structure. Must remain valid while histograms are filled.
+  * \return True if the structure was added and false otherwise.
+  */
+bool HistFile::AddStructure(const std::string &name_, TObject *object_){
+	bool retval = true;
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++){
+		for(int i = 0; i < 3; i++)
+			retval = (*iter)->values[i].AddStructure(name_, object_) && retval;
+	}
+	return retval;
+}
+
+/** Compile all histogram expressions and create the histograms. Vector members without an index
+  * are filled element by element.
+  * \return True if all expressions were compiled successfully and false otherwise.
+  */
+bool HistFile::Compile(){
+	bool retval = true;
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++){
+		HistEntry *entry = (*iter);
+
+		bool compiled = true;
+		for(int i = 0; i < 3; i++){
+			if(entry->expressions[i].empty()) continue;
+			if(!entry->values[i].Compile(entry->expressions[i], true)){
+				std::cout << "HistFile: \033[1;31mERROR! Failed to compile expression \"" << entry->expressions[i] << "\" of histogram \"" << entry->name << "\": " << entry->values[i].GetError() << ".\033[0m\n";
+				compiled = false;
+			}
+		}
+		if(!compiled){
+			retval = false;
+			continue;
+		}
+
+		std::string title = (entry->Is2D() ? entry->expressions[1] + ":" + entry->expressions[0] : entry->expressions[0]);
+		if(!entry->expressions[2].empty()) title += " {" + entry->expressions[2] + "}";
+
+		if(entry->Is2D())
+			entry->hist = new Plotter(entry->name, title, "COLZ", entry->expressions[0], entry->bins[0], entry->low[0], entry->high[0],
+			                          entry->expressions[1], entry->bins[1], entry->low[1], entry->high[1]);
+		else
+			entry->hist = new Plotter(entry->name, title, "", entry->expressions[0], entry->bins[0], entry->low[0], entry->high[0]);
+	}
+	return retval;
+}
+
+/// Fill all histograms with the current values of all structures.
+void HistFile::Fill(){
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++)
+		(*iter)->Fill();
+}
+
+/// Reset the contents of all histograms.
+void HistFile::Zero(){
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++){
+		if((*iter)->hist) (*iter)->hist->Zero();
+	}
+}
+
+/** Write all histograms to a root file.
+  * \param[in]  f_ Pointer to the output root file.
+  * \return The number of histograms written.
+  */
+int HistFile::Write(TFile *f_){
+	if(!f_ || !f_->IsOpen()) return 0;
+
+	f_->cd();
+
+	int numHists = 0;
+	for(std::vector<HistEntry*>::iterator iter = entries.begin(); iter != entries.end(); iter++){
+		if(!(*iter)->hist) continue;
+		(*iter)->hist->Write();
+		numHists++;
+	}
+
+	return numHists;
+}
@@ -89,7 +89,7 @@ LiquidBarProcessor::LiquidBarProcessor(MapFile *map_) : Processor("LiquidBar", "
 	fitting_low2 = 7; // 28 ns
 	fitting_high2 = 50; // 200 ns
 
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &L_waveform;
 	
 	// Set the detector type to a bar.
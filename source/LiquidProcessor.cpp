@@ -62,7 +62,7 @@ LiquidProcessor::LiquidProcessor(MapFile *map_) : Processor("Liquid", "liquid",
 	fitting_low2 = 7; // -28 ns
 	fitting_high2 = 50; // 200 ns
 
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 }
 
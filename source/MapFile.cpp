@@ -23,6 +23,8 @@ MapEntry::MapEntry(const MapEntry &other){
 	tag = other.tag; 
 	location = other.location;
 	args = other.args;
+	roiPre = other.roiPre;
+	roiPost = other.roiPost;
 }
 
 bool MapEntry::operator == (const MapEntry &other){
@@ -62,6 +64,58 @@ void MapEntry::clear(){
 	type = "ignore"; 
 	subtype = ""; 
 	tag = "";
+	roiPre = -1;
+	roiPost = 0;
+}
+
+/** Add an argument from the map file. Arguments of the form "roi:<pre>:<post>" set the trace
+  * region of interest and all other arguments are added to the list of numerical arguments.
+  * \param[in]  arg_ The argument string.
+  * \return False if the argument is an invalid region of interest and true otherwise.
+  */
+bool MapEntry::pushArg(const std::string &arg_){
+	if(arg_.compare(0, 4, "roi:") != 0){
+		args.push_back(atof(arg_.c_str()));
+		return true;
+	}
+
+	size_t split = arg_.find(':', 4);
+	if(split == std::string::npos){ return false; }
+
+	int pre = atoi(arg_.substr(4, split-4).c_str());
+	int post = atoi(arg_.substr(split+1).c_str());
+	if(pre < 0 || post < 0){ return false; }
+
+	roiPre = pre;
+	roiPost = post;
+
+	return true;
+}
+
+/** Get the region of interest of the trace of an event. The region starts roiPre samples before the
+  * maximum of the trace and is shifted to stay within the trace. Computes the baseline of the event.
+  * \param[in]  event_  The channel event.
+  * \param[out] offset_ Index of the first sample of the region.
+  * \param[out] length_ Number of samples in the region.
+  * \return True if the region is shorter than the trace and false if the whole trace should be written.
+  */
+bool MapEntry::getROI(ChannelEvent *event_, size_t &offset_, size_t &length_){
+	if(roiPre < 0 || event_->traceLength == 0){ return false; }
+
+	// All regions of a channel have the same length so that traces may still be stacked.
+	size_t length = roiPre + roiPost + 1;
+	if(length >= event_->traceLength){ return false; }
+
+	// Find the maximum of the trace.
+	if(event_->ComputeBaseline() < 0){ return false; }
+
+	size_t maxIndex = (size_t)event_->max_index;
+	offset_ = (maxIndex > (size_t)roiPre ? maxIndex - roiPre : 0);
+	if(offset_ + length > event_->traceLength)
+		offset_ = event_->traceLength - length;
+	length_ = length;
+
+	return true;
 }
 
 bool MapEntry::getArg(const size_t &index_, float &arg){
@@ -83,6 +137,8 @@ std::string MapEntry::print(){
 	output << type << ":" << subtype << ":" << tag;
 	for(std::vector<float>::iterator iter = args.begin(); iter != args.end(); ++iter)
 		output << " " << *iter;
+	if(hasROI())
+		output << " roi:" << roiPre << ":" << roiPost;
 	return output.str();
 }
 
@@ -302,7 +358,8 @@ bool MapFile::Load(const char *filename_){
 				}
 				detectors[mod][*iter].set(values.at(2));
 				for(size_t arg_index = 3; arg_index < values.size(); arg_index++){
-					detectors[mod][*iter].pushArg(atof(values.at(arg_index).c_str()));
+					if(!detectors[mod][*iter].pushArg(values.at(arg_index)))
+						std::cout << "MapFile: \033[1;33mWARNING! On line " << line_num << ", invalid trace region of interest (" << values.at(arg_index) << "). Ignoring.\033[0m\n";
 				}
 				
 				bool in_list = false;
@@ -325,7 +382,8 @@ bool MapFile::Load(const char *filename_){
 			}
 			detectors[mod][chan].set(values.at(2));
 			for(size_t arg_index = 3; arg_index < values.size(); arg_index++){
-				detectors[mod][chan].pushArg(atof(values.at(arg_index).c_str()));
+				if(!detectors[mod][chan].pushArg(values.at(arg_index)))
+					std::cout << "MapFile: \033[1;33mWARNING! On line " << line_num << ", invalid trace region of interest (" << values.at(arg_index) << "). Ignoring.\033[0m\n";
 			}
 			
 			bool in_list = false;
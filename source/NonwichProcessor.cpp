@@ -38,7 +38,7 @@ bool NonwichProcessor::HandleEvents(){
 }
 
 NonwichProcessor::NonwichProcessor(MapFile *map_) : Processor("Nonwich", "nonwich", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = (Waveform*)&waveform;
 	
 	dE_energy_1d = new Plotter("nonwich_h1", "Nonwich dE LR", "", "Light Response (a.u.)", 200, 0, 20000);
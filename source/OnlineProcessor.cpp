@@ -180,6 +180,13 @@ bool OnlineProcessor::Zero(const unsigned int &hist_id_){
 	return true;
 }
 
+/// Zero all diagnostic histograms.
+void OnlineProcessor::ZeroAll(){
+	for(std::vector<Plotter*>::iterator iter = plottable_hists.begin(); iter != plottable_hists.end(); iter++){
+		(*iter)->Zero();
+	}
+}
+
 /// Add a processor's histograms to the list of plottable items.
 void OnlineProcessor::AddHists(Processor *proc){
 	std::vector<Plotter*> processor_hists;
@@ -82,7 +82,7 @@ PhoswichProcessor::PhoswichProcessor(MapFile *map_) : Processor("Phoswich", "pho
 	fitting_low2 = 5;
 	fitting_high2 = 20;
 	
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 }
 
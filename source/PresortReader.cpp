@@ -0,0 +1,213 @@
+#include <iostream>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// PixieCore libraries
+#include "Unpacker.hpp"
+#include "XiaData.hpp"
+
+// Local files
+#include "PresortReader.hpp"
+
+/** Check whether or not a raw event falls inside the time window.
+  * \param[in]  rawEvent_ The channel events of the raw event.
+  * \return True if the earliest channel event is inside the window and false otherwise.
+  */
+bool PresortReader::InTimeWindow(const std::deque<XiaData*> &rawEvent_) const {
+	if(windowLow < 0 && windowHigh < 0){ return true; }
+	double startTime = -1;
+	for(std::deque<XiaData*>::const_iterator iter = rawEvent_.begin(); iter != rawEvent_.end(); ++iter){
+		if(startTime < 0 || (*iter)->time < startTime)
+			startTime = (*iter)->time;
+	}
+	if(windowLow >= 0 && startTime < windowLow){ return false; }
+	if(windowHigh >= 0 && startTime >= windowHigh){ return false; }
+	return true;
+}
+
+/// Default constructor.
+PresortReader::PresortReader() : data(NULL), length(0), keepAllTraces(false), windowLow(-1), windowHigh(-1), numEvents(0), numRawEvents(0), skippedTraceBytes(0) { }
+
+/// Destructor.
+PresortReader::~PresortReader(){
+	Close();
+}
+
+/** Map a presort file into memory and build its spill index. The index is read from the
+  * footer of the file if one exists. Otherwise, all spills in the file are walked.
+  * \param[in]  fname_ Path to the input presort file.
+  * \return True if the file was mapped and at least one spill was found and false otherwise.
+  */
+bool PresortReader::Open(const std::string &fname_){
+	Close();
+
+	filename = fname_;
+
+	// Presort spills do not contain module buffers, so the event times are only known if the file has an index footer.
+	if(!index.Build(filename.c_str(), false)){
+		std::cout << " PresortReader: Error! Failed to find any spills in \"" << filename << "\".\n";
+		return false;
+	}
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0){
+		std::cout << " PresortReader: Error! Failed to open \"" << filename << "\".\n";
+		return false;
+	}
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size <= 0){
+		close(fd);
+		return false;
+	}
+
+	length = info.st_size;
+	void *ptr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+
+	// The mapping remains valid after the file descriptor is closed.
+	close(fd);
+
+	if(ptr == MAP_FAILED){
+		std::cout << " PresortReader: Error! Failed to map \"" << filename << "\" into memory.\n";
+		length = 0;
+		return false;
+	}
+
+	data = (char*)ptr;
+	madvise(ptr, length, MADV_SEQUENTIAL);
+
+	return true;
+}
+
+/// Unmap the input file.
+void PresortReader::Close(){
+	if(data) munmap(data, length);
+	data = NULL;
+	length = 0;
+	index.Clear();
+}
+
+/** Set whether or not the ADC trace of a channel is copied into its channel event.
+  * \param[in]  mod_   Pixie module number.
+  * \param[in]  chan_  Pixie channel number.
+  * \param[in]  state_ Set to true if the trace is required.
+  * \return Nothing.
+  */
+void PresortReader::SetTraceFlag(const unsigned int &mod_, const unsigned int &chan_, const bool &state_/*=true*/){
+	size_t chanID = 16*mod_ + chan_;
+	if(chanID >= traceMask.size())
+		traceMask.resize(chanID+1, false);
+	traceMask[chanID] = state_;
+}
+
+/** Decode all raw events of a spill directly from the mapped file.
+  * \param[in]  index_ Index of the spill in the file.
+  * \param[in]  core_  Pointer to the unpacker used to allocate new channel events.
+  * \param[out] block_ Deque of raw events, each of which is a deque of channel events. Decoded raw events are appended.
+  * \return The number of raw events appended to the block.
+  */
+size_t PresortReader::ReadSpill(const size_t &index_, Unpacker *core_, std::deque<std::deque<XiaData*> > &block_){
+	if(!data || index_ >= index.size()){ return 0; }
+
+	SpillEntry &entry = index.at(index_);
+	if(entry.offset + entry.GetSize() > length){ return 0; }
+
+	// Skip spills which lie entirely outside of the time window.
+	if(entry.HasTime()){
+		if(windowLow >= 0 && entry.lastTime < windowLow){ return 0; }
+		if(windowHigh >= 0 && entry.firstTime >= windowHigh){ return 0; }
+	}
+
+	// Skip the DATA word and the length word.
+	const unsigned int *words = (const unsigned int*)(data + entry.offset + 8);
+	const unsigned int nWords = entry.length;
+
+	size_t numAdded = 0;
+	std::deque<XiaData*> rawEvent;
+
+	unsigned int position = 0;
+	while(position < nWords){
+		// Each raw event is closed by a delimiter. The spill ends with an extra delimiter.
+		if(words[position] == endBufferWord){
+			if(!rawEvent.empty()){
+				if(InTimeWindow(rawEvent)){
+					block_.push_back(std::deque<XiaData*>());
+					block_.back().swap(rawEvent);
+					numAdded++;
+				}
+				else{
+					for(std::deque<XiaData*>::iterator iter = rawEvent.begin(); iter != rawEvent.end(); ++iter)
+						delete (*iter);
+					rawEvent.clear();
+				}
+			}
+			position++;
+			continue;
+		}
+
+		unsigned int headerLength = (words[position] & 0x0001F000) >> 12;
+		unsigned int eventLength = (words[position] & 0x7FFE0000) >> 17;
+		if(headerLength < 4 || eventLength < headerLength || position + eventLength > nWords){
+			std::cout << " PresortReader: Warning! Invalid pixie event header in spill " << index_ << " (word " << position << ").\n";
+			break;
+		}
+
+		XiaData *event = core_->GetNewEvent();
+
+		// The module field holds the pixie slot number (the first module is in slot 2).
+		unsigned int slotNum = (words[position] & 0x000000F0) >> 4;
+		event->chanNum = (words[position] & 0x0000000F);
+		event->modNum = (slotNum >= 2 ? slotNum - 2 : 0);
+		event->eventTimeLo = words[position+1];
+		event->eventTimeHi = (words[position+2] & 0x0000FFFF);
+		event->time = event->eventTimeLo + event->eventTimeHi * 4294967296.0;
+		event->energy = (words[position+3] & 0x0000FFFF);
+
+		// Copy the ADC trace only if it is required for this channel.
+		unsigned int traceWords = eventLength - headerLength;
+		unsigned int traceLength = (words[position+3] & 0x7FFF0000) >> 16;
+		if(traceLength > 2*traceWords)
+			traceLength = 2*traceWords;
+		if(traceLength > 0){
+			size_t chanID = 16*event->modNum + event->chanNum;
+			if(keepAllTraces || (chanID < traceMask.size() && traceMask[chanID])){
+				// Traces trimmed to a region of interest carry the offset of the region and the trace baseline in the
+				// external timestamp words. Samples before the region are filled with the baseline so that the trace
+				// keeps its original sample positions.
+				unsigned int roiOffset = 0;
+				unsigned short roiBaseline = 0;
+				unsigned int roiWord = headerLength - 2;
+				if((headerLength == 6 || headerLength == 10 || headerLength == 14 || headerLength == 18) && (words[position+roiWord] & 0xFFFF0000) == roiHeaderTag){
+					float baseline;
+					memcpy((char*)&baseline, (const char*)&words[position+roiWord+1], 4);
+					roiOffset = (words[position+roiWord] & 0x0000FFFF);
+					roiBaseline = (baseline > 0 ? (unsigned short)(baseline + 0.5) : 0);
+				}
+
+				event->adcTrace = new unsigned short[roiOffset + traceLength];
+				for(unsigned int i = 0; i < roiOffset; i++)
+					event->adcTrace[i] = roiBaseline;
+				memcpy((char*)&event->adcTrace[roiOffset], (const char*)&words[position+headerLength], 2*traceLength);
+				event->traceLength = roiOffset + traceLength;
+			}
+			else{ skippedTraceBytes += 4*traceWords; }
+		}
+
+		rawEvent.push_back(event);
+		numEvents++;
+
+		position += eventLength;
+	}
+
+	// Drop any channel events which were not closed by a delimiter.
+	for(std::deque<XiaData*>::iterator iter = rawEvent.begin(); iter != rawEvent.end(); ++iter)
+		delete (*iter);
+
+	numRawEvents += numAdded;
+
+	return numAdded;
+}
@@ -2,11 +2,16 @@
 #include <cmath>
 #include <time.h>
 #include <algorithm>
+#include <sstream>
 
 #include "Processor.hpp"
 #include "Structures.h"
 #include "MapFile.hpp"
 #include "CalibFile.hpp"
+#include "ColumnWriter.hpp"
+#include "TraceCache.hpp"
+#include "TraceCodec.hpp"
+#include "HistFile.hpp"
 
 #include "TTree.h"
 #include "TGraph.h"
@@ -112,6 +117,31 @@ TF1 *Processor::SetFitFunction(){
 	return fitting_func;
 }
 
+/** Copy the ADC trace of an event to the output. If a trace codec is set, the trace is compressed
+  * and appended to the packed trace buffer instead. Only the region of interest is copied for
+  * channels which define one in the map file.
+  * \param[in]  event_  The channel event whose trace to copy.
+  * \param[in]  entry_  The map entry of the channel.
+  * \param[out] trace_  The trace structure to append the trace to (when not compressing).
+  * \return Nothing.
+  */
+void Processor::AppendTrace(ChanEvent *event_, MapEntry *entry_, Trace *trace_){
+	size_t offset = 0;
+	size_t length = event_->traceLength;
+	entry_->getROI(event_, offset, length);
+
+	// Store the position and baseline of the region so that the full trace timing may be recovered.
+	if(write_roi){
+		roi_offset.push_back((unsigned short)offset);
+		roi_baseline.push_back(event_->baseline);
+	}
+
+	if(trace_codec)
+		trace_codec->Encode(event_->adcTrace+offset, length, (unsigned short)(16*event_->modNum+event_->chanNum), packed_waveform);
+	else
+		trace_->Append(event_->adcTrace+offset, length);
+}
+
 bool Processor::HandleSingleEndedEvents(){
 	if(!init){ return false; }
 
@@ -125,7 +155,7 @@ bool Processor::HandleSingleEndedEvents(){
 			
 		// Copy the trace to the output file.
 		if(write_waveform)
-			root_waveform->Append((*iter)->channelEvent->adcTrace, (*iter)->channelEvent->traceLength);
+			AppendTrace((*iter)->channelEvent, (*iter)->entry, root_waveform);
 	}
 
 	return true;
@@ -168,8 +198,8 @@ bool Processor::HandleDoubleEndedEvents(){
 
 		// Copy the trace to the output file.
 		if(write_waveform){
-			root_waveform->Append(current_event_L->adcTrace, current_event_L->traceLength);
-			root_waveformR->Append(current_event_R->adcTrace, current_event_R->traceLength);
+			AppendTrace(current_event_L, (*iter_L)->entry, root_waveform);
+			AppendTrace(current_event_R, (*iter_R)->entry, root_waveformR);
 		}
 	}
 	
@@ -259,6 +289,10 @@ Processor::Processor(std::string name_, std::string type_, MapFile *map_){
 	isSingleEnded = true;
 	histsEnabled = false;
 	presortData = false;
+	trace_cache = NULL;
+	trace_codec = NULL;
+	write_roi = false;
+	flat_output = false;
 	
 	total_time = 0;
 	start_time = clock();
@@ -269,6 +303,8 @@ Processor::Processor(std::string name_, std::string type_, MapFile *map_){
 	root_structure = &dummyStructure;
 	root_waveform = &dummyTrace;
 	root_waveformR = &dummyTrace;
+
+	structure_buffer = new StructureBuffer<Structure>(&dummyStructure);
 	
 	local_branch = NULL;
 	trace_branch = NULL;
@@ -299,9 +335,10 @@ Processor::~Processor(){
 	// Ensure there are no events left in the queue
 	if(fitting_func){ delete fitting_func; }
 	if(actual_func){ delete actual_func; }
+	delete structure_buffer;
 }
 
-bool Processor::Initialize(TTree *tree_){
+bool Processor::Initialize(TTree *tree_, const int &splitLevel_/*=99*/, AsyncWriter *writer_/*=NULL*/){
 	if(init || !tree_){ 
 		PrintMsg("Root output is already initialized!");
 		return false; 
@@ -309,17 +346,24 @@ bool Processor::Initialize(TTree *tree_){
 	
 	// Add a branch to the tree
 	PrintMsg("Adding branch to main TTree.");
-	local_branch = tree_->Branch(type.c_str(), root_structure);
-	
-	if(write_waveform){
-		PrintMsg("Writing raw waveforms to file.");
-		local_branch = tree_->Branch((type+"_trace").c_str(), root_waveform);
+	if(flat_output){ // Write one leaf per member from fixed-size arrays.
+		root_structure->BranchFlat(tree_, type);
+		if(GetNumMappedChannels() > (size_t)root_structure->GetMaxFlatMult()){
+			std::stringstream stream;
+			stream << "More channels are mapped (" << GetNumMappedChannels() << ") than fit in the flat output arrays (" << root_structure->GetMaxFlatMult() << "). Increase MAX_MULT in def.struct to avoid losing events.";
+			PrintWarning(stream.str());
+		}
 	}
+	else if(writer_) // Read from a snapshot of the structure on the writer thread.
+		local_branch = writer_->AddBranch(tree_, type.c_str(), structure_buffer, 32000, splitLevel_);
+	else
+		local_branch = tree_->Branch(type.c_str(), root_structure, 32000, splitLevel_);
 	
+	// Traces are only written to the trace tree (see InitializeTraces).
 	return (init = true);
 }
 
-bool Processor::InitializeTraces(TTree *tree_){
+bool Processor::InitializeTraces(TTree *tree_, const int &splitLevel_/*=99*/, AsyncWriter *writer_/*=NULL*/){
 	if(trace_branch || !tree_){ 
 		PrintMsg("Trace output is already initialized!");
 		return false; 
@@ -331,11 +375,71 @@ bool Processor::InitializeTraces(TTree *tree_){
 	
 	// Add a branch to the tree
 	PrintMsg("Adding branch to ADC trace TTree.");
-	trace_branch = tree_->Branch(type.c_str(), root_waveform);
+	if(trace_codec){
+		std::string branchName = type + "_packed";
+		if(writer_)
+			trace_branch = writer_->Branch(tree_, branchName.c_str(), &packed_waveform, 32000, splitLevel_);
+		else
+			trace_branch = tree_->Branch(branchName.c_str(), &packed_waveform, 32000, splitLevel_);
+	}
+	else if(writer_)
+		trace_branch = writer_->Branch(tree_, type.c_str(), root_waveform, 32000, splitLevel_);
+	else
+		trace_branch = tree_->Branch(type.c_str(), root_waveform, 32000, splitLevel_);
+
+	// Check for channels which only write the region of interest of their traces.
+	for(int mod = 0; mod < mapfile->GetMaxModules() && !write_roi; mod++){
+		for(int chan = 0; chan < mapfile->GetMaxChannels(); chan++){
+			MapEntry *entry = mapfile->GetMapEntry(mod, chan);
+			if(entry->type == type && entry->hasROI()){
+				write_roi = true;
+				break;
+			}
+		}
+	}
+
+	if(write_roi){
+		PrintMsg("Adding trace region of interest branches to ADC trace TTree.");
+		std::string offsetName = type + "_roi_offset";
+		std::string baselineName = type + "_roi_baseline";
+		if(writer_){
+			writer_->Branch(tree_, offsetName.c_str(), &roi_offset);
+			writer_->Branch(tree_, baselineName.c_str(), &roi_baseline);
+		}
+		else{
+			tree_->Branch(offsetName.c_str(), &roi_offset);
+			tree_->Branch(baselineName.c_str(), &roi_baseline);
+		}
+	}
 	
 	return (init = true);
 }
 
+bool Processor::InitializeColumns(ColumnWriter *writer_){
+	if(!writer_){ return false; }
+
+	PrintMsg("Adding structure to columnar output.");
+	if(!writer_->AddStructure(type, root_structure)){
+		PrintError("Failed to add structure to columnar output!");
+		return false;
+	}
+
+	return true;
+}
+
+bool Processor::InitializeHists(HistFile *hists_){
+	if(init || !hists_){ 
+		PrintMsg("Root output is already initialized!");
+		return false; 
+	}
+
+	PrintMsg("Adding structure to histogram output.");
+	hists_->AddStructure(type, root_structure);
+
+	// No output tree is used, but events must still be processed.
+	return (init = true);
+}
+
 float Processor::Status(unsigned long global_events_){
 	float time_taken = 0.0;
 	
@@ -346,78 +450,120 @@ float Processor::Status(unsigned long global_events_){
 		std::cout << " " << name << "Processor: " << total_events << " Total Events (" << 100.0*total_events/global_events_ << "%)\n";
 		if(init) std::cout << " " << name << "Processor: " << good_events << " Valid Events (" << 100.0*good_events/global_events_ << "%)\n";
 	}
+	if(flat_output && root_structure->GetNumTruncated() > 0){
+		std::cout << " " << name << "Processor: \033[1;33mWARNING! " << root_structure->GetNumTruncated() << " entries had more than " << root_structure->GetMaxFlatMult();
+		std::cout << " events and were truncated in the flat output. Increase MAX_MULT in def.struct to keep all events.\033[0m\n";
+	}
 	
 	return time_taken;
 }
 
+bool Processor::AnalyzeTrace(ChanEvent *event_, MapEntry *entry_){
+	// Calculate the baseline.
+	if(event_->ComputeBaseline() < 0){ return false; }
+
+	// Check for large SNR.
+	//if(event_->stddev > 3.0){ return false; }
+
+	// Compute the integral of the pulse within the integration window.
+	event_->IntegratePulse(event_->max_index - fitting_low, event_->max_index + fitting_high);
+	if(fitting_low2 != -9999 && fitting_high2 != -9999) 
+		event_->IntegratePulse(event_->max_index - fitting_low2, event_->max_index + fitting_high2, true);		
+
+	if(use_fitting) // Do root fitting for high resolution timing (very slow).
+		return FitPulse(event_, entry_);
+
+	// Do a more simplified CFD analysis to save time.
+	return CfdPulse(event_, entry_);
+}
+
+unsigned long long Processor::GetParameterHash(ChannelEventPair *pair_){
+	unsigned int chanID = 16*pair_->channelEvent->modNum + pair_->channelEvent->chanNum;
+	if(chanID < cacheHashes.size() && cacheHashes[chanID] != 0)
+		return cacheHashes[chanID];
+
+	// Everything which affects the trace analysis of this channel. Calibrations are applied afterwards.
+	std::stringstream stream;
+	stream.precision(9);
+	stream << type << ":" << use_fitting << ":" << fitting_low << "," << fitting_high << "," << fitting_low2 << "," << fitting_high2;
+	stream << ":" << defaultCFD[0] << "," << defaultCFD[1] << "," << defaultCFD[2];
+	if(actual_func) stream << ":" << actual_func->GetBeta() << "," << actual_func->GetGamma();
+	stream << ":" << pair_->entry->type << ":" << pair_->entry->subtype;
+	for(std::vector<float>::iterator iter = pair_->entry->args.begin(); iter != pair_->entry->args.end(); iter++)
+		stream << ":" << (*iter);
+
+	if(chanID >= cacheHashes.size())
+		cacheHashes.resize(chanID+1, 0);
+
+	return (cacheHashes[chanID] = TraceCache::Hash(stream.str()));
+}
+
+void Processor::PreProcessEvent(ChannelEventPair *pair_){
+	total_events++;
+	
+	ChanEvent *current_event = pair_->channelEvent;
+	
+	if(!presortData){
+		// Set the default values for high resolution energy and time.
+		current_event->hiresTime = current_event->time * filterClockInSeconds;
+	
+		// Check for trace with zero size.
+		if(current_event->traceLength == 0){
+			if(use_trace && !presortData){
+				// The trace is required by this processor, but does not exist.
+				return; 
+			}				
+			// The trace is not required by the processor. Set the channel event to valid.
+			current_event->valid_chan = true;
+		}
+		else{ // The trace exists.
+			// Read the results from the cache if the analysis parameters of this channel have not changed.
+			unsigned int chanID = 16*current_event->modNum + current_event->chanNum;
+			if(!trace_cache || !trace_cache->Read(chanID, GetParameterHash(pair_), current_event)){
+				current_event->valid_chan = AnalyzeTrace(current_event, pair_->entry);
+				if(trace_cache) trace_cache->Write(chanID, current_event);
+			}
+
+			if(!current_event->valid_chan){ return; }
+		
+			// Add the phase of the trace to the high resolution time.
+			current_event->hiresTime += current_event->phase * adcClockInSeconds;
+		}
+	}
+	
+	// Calibrate the energy, if applicable.
+	if(pair_->calib->Energy()){
+		if(use_integration)
+			current_event->qdc = pair_->calib->energyCal->GetCalEnergy(current_event->qdc);
+		else
+			current_event->energy = pair_->calib->energyCal->GetCalEnergy(current_event->energy);
+	}
+}
+
 void Processor::PreProcess(){
 	// Start the timer.
 	StartProcess(); 
 	
-	ChanEvent *current_event;
-
 	// Iterate over the list of channel events.
 	for(std::deque<ChannelEventPair*>::iterator iter = events.begin(); iter != events.end(); iter++){
-		total_events++;
-		
-		current_event = (*iter)->channelEvent;
-		
-		if(!presortData){
-			// Set the default values for high resolution energy and time.
-			current_event->hiresTime = current_event->time * filterClockInSeconds;
-		
-			// Check for trace with zero size.
-			if(current_event->traceLength == 0){
-				if(use_trace && !presortData){
-					// The trace is required by this processor, but does not exist.
-					continue; 
-				}				
-				// The trace is not required by the processor. Set the channel event to valid.
-				current_event->valid_chan = true;
-			}
-			else{ // The trace exists.
-				// Calculate the baseline.
-				if(current_event->ComputeBaseline() < 0){ continue; }
-		
-				// Check for large SNR.
-				//if(current_event->stddev > 3.0){ continue; }
+		PreProcessEvent(*iter);
+	}
 
-				// Compute the integral of the pulse within the integration window.
-				current_event->IntegratePulse(current_event->max_index - fitting_low, current_event->max_index + fitting_high);
-				if(fitting_low2 != -9999 && fitting_high2 != -9999) 
-					current_event->IntegratePulse(current_event->max_index - fitting_low2, current_event->max_index + fitting_high2, true);		
-		
-				// Set the channel event to valid.
-				current_event->valid_chan = true;
-		
-				if(use_fitting){ // Do root fitting for high resolution timing (very slow).
-					if(!FitPulse(current_event, (*iter)->entry)){
-						// Set the channel event to invalid.
-						current_event->valid_chan = false;
-						continue;
-					}
-				}
-				else{ // Do a more simplified CFD analysis to save time.
-					if(!CfdPulse(current_event, (*iter)->entry)){
-						// Set the channel event to invalid.
-						current_event->valid_chan = false;
-						continue;
-					}
-				}
-			
-				// Add the phase of the trace to the high resolution time.
-				current_event->hiresTime += current_event->phase * adcClockInSeconds;
-			}
-		}
-		
-		// Calibrate the energy, if applicable.
-		if((*iter)->calib->Energy()){
-			if(use_integration)
-				current_event->qdc = (*iter)->calib->energyCal->GetCalEnergy(current_event->qdc);
-			else
-				current_event->energy = (*iter)->calib->energyCal->GetCalEnergy(current_event->energy);
-		}
+	// Stop the timer.
+	StopProcess();
+}
+
+void Processor::PreProcessBlock(){
+	// Start the timer once for the entire block.
+	StartProcess(); 
+	
+	// Iterate over the list of channel events from all raw events in the block.
+	for(std::deque<ChannelEventPair*>::iterator iter = blockEvents.begin(); iter != blockEvents.end(); iter++){
+		PreProcessEvent(*iter);
 	}
+	
+	// The events are owned by the scanner. We only need to clear the list.
+	blockEvents.clear();
 
 	// Stop the timer.
 	StopProcess();
@@ -437,6 +583,9 @@ bool Processor::Process(ChannelEventPair *start_){
 	else
 		retval = HandleDoubleEndedEvents();
 	
+	// Copy the structure to the flat output arrays.
+	if(flat_output) root_structure->FillFlat();
+
 	// Stop the timer.
 	StopProcess(); 
 	
@@ -453,9 +602,25 @@ void Processor::WrapUp(){
 	events.clear();
 }
 
+size_t Processor::GetNumMappedChannels(){
+	if(!mapfile) return 0;
+	size_t numChannels = 0;
+	for(int mod = 0; mod < mapfile->GetMaxModules(); mod++){
+		for(int chan = 0; chan < mapfile->GetMaxChannels(); chan++){
+			if(mapfile->GetType(mod, chan) == type) numChannels++;
+		}
+	}
+	return numChannels;
+}
+
 void Processor::Zero(){
-	root_structure->Zero();
-	root_waveform->Zero();
+	// Only reset structures which were filled during this event.
+	if(root_structure->IsDirty()) root_structure->Zero();
+	if(root_waveform->IsDirty()) root_waveform->Zero();
+	if(root_waveformR->IsDirty()) root_waveformR->Zero();
+	packed_waveform.clear();
+	roi_offset.clear();
+	roi_baseline.clear();
 }
 
 void Processor::RemoveByTag(const std::string &tag_, const bool &withTag_/*=true*/){
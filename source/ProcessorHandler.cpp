@@ -14,6 +14,10 @@
 
 #include "MapFile.hpp"
 #include "CalibFile.hpp"
+#include "EventFilter.hpp"
+#include "EventIndex.hpp"
+#include "HistFile.hpp"
+#include "SkimStream.hpp"
 
 ChanEvent *dummyEvent = new ChanEvent();
 MapEntry dummyEntry;
@@ -59,23 +63,81 @@ bool ProcessorHandler::SetPresortMode(bool state_/*=true*/){
 	return state_;
 }
 
-bool ProcessorHandler::InitRootOutput(TTree *tree_){
+void ProcessorHandler::SetTraceCache(TraceCache *cache_){
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		iter->proc->SetTraceCache(cache_);
+	}
+}
+
+void ProcessorHandler::SetTraceCodec(TraceCodec *codec_){
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		iter->proc->SetTraceCodec(codec_);
+	}
+}
+
+void ProcessorHandler::SetFlatOutput(const bool &state_/*=true*/){
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		iter->proc->SetFlatOutput(state_);
+	}
+}
+
+bool ProcessorHandler::InitRootOutput(TTree *tree_, const int &splitLevel_/*=99*/, AsyncWriter *writer_/*=NULL*/){
 	bool retval = true;
 	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
-		retval = retval && iter->proc->Initialize(tree_);
+		retval = retval && iter->proc->Initialize(tree_, splitLevel_, writer_);
 	}
 	return true;
 }
 
-bool ProcessorHandler::InitTraceOutput(TTree *tree_){
+bool ProcessorHandler::InitTraceOutput(TTree *tree_, const int &splitLevel_/*=99*/, AsyncWriter *writer_/*=NULL*/){
 	bool retval = true;
 	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
-		iter->proc->ToggleTraces();
-		retval = retval && iter->proc->InitializeTraces(tree_);
+		iter->proc->SetWriteTraces(true);
+		retval = retval && iter->proc->InitializeTraces(tree_, splitLevel_, writer_);
 	}
 	return true;
 }
 
+bool ProcessorHandler::InitColumnOutput(ColumnWriter *writer_){
+	bool retval = true;
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		retval = iter->proc->InitializeColumns(writer_) && retval;
+	}
+	return retval;
+}
+
+bool ProcessorHandler::InitHistOutput(HistFile *hists_){
+	bool retval = true;
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		retval = iter->proc->InitializeHists(hists_) && retval;
+	}
+	return retval;
+}
+
+bool ProcessorHandler::InitEventFilter(EventFilter *filter_){
+	bool retval = true;
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		retval = filter_->AddStructure(iter->type, iter->proc->GetStructure()) && retval;
+	}
+	return retval;
+}
+
+bool ProcessorHandler::InitSkimOutput(SkimStream *skim_, const int &splitLevel_/*=99*/){
+	bool retval = true;
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		retval = skim_->AddStructure(iter->type, iter->proc->GetStructure(), splitLevel_) && retval;
+	}
+	return retval;
+}
+
+bool ProcessorHandler::InitEventIndex(EventIndex *index_){
+	bool retval = true;
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		retval = index_->AddStructure(iter->type, iter->proc->GetStructure()) && retval;
+	}
+	return retval;
+}
+
 bool ProcessorHandler::CheckProcessor(std::string type_){
 	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
 		if(iter->type == type_){ return false; }
@@ -135,6 +197,16 @@ bool ProcessorHandler::AddStart(ChannelEventPair *pair_){
 	return true;
 }
 
+bool ProcessorHandler::AddBlockEvent(ChannelEventPair *pair_){
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		if(pair_->entry->type == iter->type){ 
+			iter->proc->AddBlockEvent(pair_); 
+			return true;
+		}
+	}
+	return false;
+}
+
 bool ProcessorHandler::PreProcess(){
 	// First call the preprocessors. The preprocessor will calculate the phase of the trace
 	// by doing a CFD analysis or using the root fitting routine.
@@ -145,9 +217,19 @@ bool ProcessorHandler::PreProcess(){
 	return true;
 }
 
-bool ProcessorHandler::Process(){
+bool ProcessorHandler::PreProcessBlock(){
+	// Preprocess the events from all raw events in the block. Each processor
+	// loops over all of its events at once.
+	for(std::vector<ProcessorEntry>::iterator iter = procs.begin(); iter != procs.end(); iter++){
+		iter->proc->PreProcessBlock();
+	}
+	
+	return true;
+}
+
+bool ProcessorHandler::Process(const bool &preprocess_/*=true*/){
 	// Call all processor preprocess routines.
-	PreProcess();
+	if(preprocess_) PreProcess();
 
 	// Return false if there are no start events.
 	if(starts.empty()){
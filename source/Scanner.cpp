@@ -1,4 +1,8 @@
 #include <iostream>
+#include <ctime>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
 
 // Local files
 #include "Scanner.hpp"
@@ -9,6 +13,17 @@
 #include "ProcessorHandler.hpp"
 #include "OnlineProcessor.hpp"
 #include "Plotter.hpp"
+#include "SpillIndex.hpp"
+#include "AsyncWriter.hpp"
+#include "ColumnWriter.hpp"
+#include "SpillWriter.hpp"
+#include "PresortReader.hpp"
+#include "TraceCache.hpp"
+#include "TraceCodec.hpp"
+#include "EventFilter.hpp"
+#include "EventIndex.hpp"
+#include "HistFile.hpp"
+#include "SkimStream.hpp"
 
 #ifdef USE_HRIBF
 #include "ScanorInterface.hpp"
@@ -21,17 +36,13 @@
 #include "TCanvas.h"
 #include "TSystem.h"
 #include "TApplication.h"
+#include "TROOT.h"
 
 // Define the name of the program.
 #if not defined(PROG_NAME)
 #define PROG_NAME "Scanner"
 #endif
 
-const unsigned int fileFooterWord = 0x20464f45; // "EOF "
-const unsigned int fileHeaderWord = 0x44414548; // "HEAD"
-const unsigned int dataHeaderWord = 0x41544144; // "DATA"
-const unsigned int endBufferWord = 0xFFFFFFFF;
-
 void writeFileInfo(std::ofstream &file_, const std::string &str_){
 	unsigned short dummy1 = ((unsigned short)str_.size() + 2) + (str_.size() + 2) % 4;
 	unsigned short dummy2 = (str_.size() + 2) % 4;
@@ -43,6 +54,8 @@ void writeFileInfo(std::ofstream &file_, const std::string &str_){
 	}
 }
 
+std::mutex extTree::outputLock;
+
 /** Open a TCanvas if this tree has not already done so.
   * \return Pointer to an open TCanvas.
   */
@@ -66,6 +79,9 @@ extTree::extTree(const char *name_, const char *title_) : TTree(name_, title_){
 	opt = "";
 	doDraw = false;
 	canvas = NULL;
+	fillTiming = false;
+	fillWallTime = 0;
+	fillCpuTime = 0;
 }
 
 /// Destructor.
@@ -93,12 +109,17 @@ bool extTree::SafeDraw(const std::string &expr_, const std::string &gate_/*=""*/
 }
 
 /** Safely fill the tree and draw a histogram using TTree::Draw() if required.
-  * \return The return value from TTree::Draw().
+  * \param[in]  writer_ Pointer to an asynchronous writer which fills the tree on its own thread. If NULL, the tree is filled directly.
+  * \return The return value from TTree::Fill() or AsyncWriter::Fill().
   */
-int extTree::SafeFill(){
-	int retval = this->Fill();
+int extTree::SafeFill(AsyncWriter *writer_/*=NULL*/){
+	int retval = (writer_ ? writer_->Fill(this) : this->Fill());
 
 	if(doDraw){
+		// The tree may only be read once the writer has finished filling it.
+		if(writer_) writer_->Flush();
+
+		std::lock_guard<std::mutex> lock(outputLock);
 		OpenCanvas()->cd();
 		std::cout << " draw: " << this->Draw(expr.c_str(), gate.c_str(), opt.c_str()) << std::endl;
 		canvas->Update();
@@ -108,6 +129,24 @@ int extTree::SafeFill(){
 	return retval;
 }
 
+/** Fill the tree while holding the output lock. Records the time spent filling if timing is enabled.
+  * \return The return value from TTree::Fill().
+  */
+int extTree::Fill(){
+	std::lock_guard<std::mutex> lock(outputLock);
+	if(!fillTiming) return TTree::Fill();
+
+	std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+	clock_t cpuStart = clock();
+
+	int retval = TTree::Fill();
+
+	fillCpuTime += (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+	fillWallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+	return retval;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // class simpleUnpacker
 ///////////////////////////////////////////////////////////////////////////////
@@ -115,9 +154,27 @@ int extTree::SafeFill(){
 /// Default constructor.
 simpleUnpacker::simpleUnpacker() : Unpacker() {  
 	stat_tree = NULL;
+	writer = NULL;
+	totalRejected = 0;
+	blockSize = 1;
+	windowLow = -1;
+	windowHigh = -1;
+	useTimeWindow = false;
+	windowRejected = 0;
+}
+
+/// Destructor.
+simpleUnpacker::~simpleUnpacker(){
+	// Delete any events left over in an unprocessed block.
+	for(std::deque<std::deque<XiaData*> >::iterator iter = eventBlock.begin(); iter != eventBlock.end(); ++iter){
+		for(std::deque<XiaData*>::iterator iter2 = iter->begin(); iter2 != iter->end(); ++iter2){
+			delete (*iter2);
+		}
+	}
 }
 
-/** Return a pointer to a new XiaData channel event.
+/** Return a pointer to a new XiaData channel event. The event is allocated as
+  * a ChanEvent so that the scanner may adopt it directly without copying it.
   * \return A pointer to a new XiaData.
   */
 XiaData *simpleUnpacker::GetNewEvent(){ 
@@ -130,11 +187,26 @@ XiaData *simpleUnpacker::GetNewEvent(){
   */
 void simpleUnpacker::ProcessRawEvent(ScanInterface *addr_/*=NULL*/){
 	if(!addr_ || rawEvent.empty()){ return; }
+
+	// Drop raw events which start outside of the time window.
+	if(useTimeWindow && !InTimeWindow()){
+		while(!rawEvent.empty()){
+			delete rawEvent.front();
+			rawEvent.pop_front();
+		}
+		windowRejected++;
+		return;
+	}
 	
 	// Low-level raw event statistics information.
-	if(stat_tree) stat_tree->SafeFill();
+	if(stat_tree) stat_tree->SafeFill(writer);
 
 	XiaData *current_event = NULL;
+	unsigned int numAdded = 0;
+
+	// Start a new raw event in the current block.
+	if(blockSize > 1)
+		eventBlock.push_back(std::deque<XiaData*>());
 	
 	// Fill the processor event deques with events
 	while(!rawEvent.empty()){
@@ -144,32 +216,151 @@ void simpleUnpacker::ProcessRawEvent(ScanInterface *addr_/*=NULL*/){
 		// Check that this channel event exists.
 		if(!current_event){ continue; }
 
+		// Drop events from rejected channels before they are handed to the scan.
+		if(!rejectMask.empty()){
+			size_t chanID = 16*current_event->modNum + current_event->chanNum;
+			if(chanID < rejectMask.size() && rejectMask[chanID]){
+				rejectCounts[chanID]++;
+				totalRejected++;
+				delete current_event;
+				continue;
+			}
+		}
+
+		numAdded++;
+
+		// Hold the event until the block is full.
+		if(blockSize > 1){
+			eventBlock.back().push_back(current_event);
+			continue;
+		}
+
 		// Send the event to the scan interface object for processing.
 		addr_->AddEvent(current_event);
 	}
+
+	if(blockSize > 1){
+		// Drop raw events which are left empty after channel rejection.
+		if(numAdded == 0)
+			eventBlock.pop_back();
+		
+		// Send the block to the scan once it is full.
+		if(eventBlock.size() >= blockSize)
+			FlushBlock(addr_);
+		return;
+	}
 	
 	// Finish up with this raw event.
-	addr_->ProcessEvents();
+	if(numAdded > 0)
+		addr_->ProcessEvents();
+}
+
+/** Send all raw events in the current block to the scan for processing.
+  * \param[in]  addr_ Pointer to a simpleScanner object.
+  * \return The number of raw events in the block.
+  */
+size_t simpleUnpacker::FlushBlock(ScanInterface *addr_){
+	if(!addr_ || eventBlock.empty()){ return 0; }
+	
+	size_t numEvents = eventBlock.size();
+	
+	// The scanner takes ownership of all channel events in the block.
+	((simpleScanner*)addr_)->ProcessBlock(eventBlock);
+	eventBlock.clear();
+	
+	return numEvents;
+}
+
+/** Only pass raw events whose earliest channel event falls inside a time window to the scan.
+  * \param[in]  tmin_ Lower edge of the window in pixie clock ticks. A negative value leaves the window open below.
+  * \param[in]  tmax_ Upper edge of the window (exclusive) in pixie clock ticks. A negative value leaves the window open above.
+  * \return Nothing.
+  */
+void simpleUnpacker::SetTimeWindow(const double &tmin_, const double &tmax_){
+	windowLow = tmin_;
+	windowHigh = tmax_;
+	useTimeWindow = (windowLow >= 0 || windowHigh >= 0);
+}
+
+/** Check whether or not the earliest channel event in the raw event falls inside the time window.
+  * \return True if the raw event is inside the window and false otherwise.
+  */
+bool simpleUnpacker::InTimeWindow() const {
+	double startTime = -1;
+	for(std::deque<XiaData*>::const_iterator iter = rawEvent.begin(); iter != rawEvent.end(); ++iter){
+		if(!(*iter)){ continue; }
+		if(startTime < 0 || (*iter)->time < startTime)
+			startTime = (*iter)->time;
+	}
+	if(windowLow >= 0 && startTime < windowLow){ return false; }
+	if(windowHigh >= 0 && startTime >= windowHigh){ return false; }
+	return true;
 }
 
 /** Initialize the raw event statistics tree.
+  * \param[in]  writer_ Pointer to an asynchronous writer to use for filling the tree. If NULL, the tree is filled directly.
   * \return Pointer to the TTree.
   */
-extTree *simpleUnpacker::InitTree(){
+extTree *simpleUnpacker::InitTree(AsyncWriter *writer_/*=NULL*/){
 	// Setup the stats tree for data output.
 	stat_tree = new extTree("stats", "Low-level statistics tree");
+	writer = writer_;
 
 	// Add branches to the stats tree.
-	stat_tree->Branch("trig", GetStartEventTime());
-	stat_tree->Branch("start", GetRawEventStartTime());
-	stat_tree->Branch("stop", GetRawEventStopTime());
-	stat_tree->Branch("chanTime", GetRawEventChanTime());
-	stat_tree->Branch("chanID", GetRawEventChanID());
-	stat_tree->Branch("inEvent", GetRawEventFlag());
+	if(writer){
+		writer->Branch(stat_tree, "trig", GetStartEventTime());
+		writer->Branch(stat_tree, "start", GetRawEventStartTime());
+		writer->Branch(stat_tree, "stop", GetRawEventStopTime());
+		writer->Branch(stat_tree, "chanTime", GetRawEventChanTime());
+		writer->Branch(stat_tree, "chanID", GetRawEventChanID());
+		writer->Branch(stat_tree, "inEvent", GetRawEventFlag());
+	}
+	else{
+		stat_tree->Branch("trig", GetStartEventTime());
+		stat_tree->Branch("start", GetRawEventStartTime());
+		stat_tree->Branch("stop", GetRawEventStopTime());
+		stat_tree->Branch("chanTime", GetRawEventChanTime());
+		stat_tree->Branch("chanID", GetRawEventChanID());
+		stat_tree->Branch("inEvent", GetRawEventFlag());
+	}
 
 	return stat_tree;
 }
 
+/** Flag a channel so that its events are dropped before being passed to the scan.
+  * \param[in]  mod_  Pixie module number.
+  * \param[in]  chan_ Pixie channel number.
+  * \return Nothing.
+  */
+void simpleUnpacker::RejectChannel(const unsigned int &mod_, const unsigned int &chan_){
+	size_t chanID = 16*mod_ + chan_;
+	if(chanID >= rejectMask.size()){
+		rejectMask.resize(chanID+1, false);
+		rejectCounts.resize(chanID+1, 0);
+	}
+	rejectMask[chanID] = true;
+}
+
+/** Check whether or not a channel has been flagged for early rejection.
+  * \param[in]  mod_  Pixie module number.
+  * \param[in]  chan_ Pixie channel number.
+  * \return True if events from this channel are dropped and false otherwise.
+  */
+bool simpleUnpacker::IsRejected(const unsigned int &mod_, const unsigned int &chan_) const {
+	size_t chanID = 16*mod_ + chan_;
+	return (chanID < rejectMask.size() && rejectMask[chanID]);
+}
+
+/** Get the number of events which were dropped for a single channel.
+  * \param[in]  mod_  Pixie module number.
+  * \param[in]  chan_ Pixie channel number.
+  * \return The number of rejected events for the specified channel.
+  */
+unsigned long simpleUnpacker::GetRejectedCount(const unsigned int &mod_, const unsigned int &chan_) const {
+	size_t chanID = 16*mod_ + chan_;
+	return (chanID < rejectCounts.size() ? rejectCounts[chanID] : 0);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // class simpleScanner
 ///////////////////////////////////////////////////////////////////////////////
@@ -188,27 +379,76 @@ simpleScanner::simpleScanner() : ScanInterface() {
 	online_mode = false;
 	use_root_fitting = false;
 	write_traces = false;
+	compress_traces = false;
 	write_raw = false;
+	write_index = false;
+	flat_output = false;
 	write_stats = false;
+	async_output = false;
 	init = false;
 	mapfile = NULL;
 	configfile = NULL;
 	calibfile = NULL;
 	handler = NULL;
 	online = NULL;
+	writer = NULL;
+	async_slots = 64;
+	io_threads = 0;
+	columns = NULL;
+	event_filter = NULL;
+	hist_file = NULL;
+	index_tree = NULL;
+	event_index = NULL;
+	trace_file = NULL;
+	data_entries = 0;
+	trace_entry = 0;
+	trace_chunk = 0;
+	trace_cache = NULL;
+	trace_codec = NULL;
+	rotate_size = 0;
+	rotate_time = 0;
+	rotate_files = 0;
+	chunk_number = 0;
+	chunk_files = 0;
+	chunk_start_time = 0;
+	rotated_events = 0;
+	rotated_bytes = 0;
 	spillThreshold = 10000;
 	currSpillLength = 0;
+	spillBufferUsed = 0;
+	spill_writer = NULL;
+	spill_flush_size = 1048576;
+	async_presort = false;
 	maxSpillLength = 0;
 	events_since_last_update = 0;
 	events_between_updates = 5000;
 	loaded_files = 0;
+	block_size = 1;
+	window_low = -1;
+	window_high = -1;
 	defaultCFDparameter = -1;
 }
 
 /// Destructor.
 simpleScanner::~simpleScanner(){
 	if(init){
-		std::cout << msgHeader << "Found " << chanCounts->GetHist()->GetEntries() << " total events.\n";
+		// Process any raw events remaining in the unpacker's current block.
+		((simpleUnpacker*)GetCore())->FlushBlock(this);
+
+		// Finish filling the output trees before writing them to file.
+		if(writer){
+			writer->Stop();
+			std::cout << msgHeader << "Asynchronous writer filled " << writer->GetNumFills() << " tree entries (scan waited " << writer->GetNumWaits() << " times for a free buffer).\n";
+		}
+
+		// Write the remaining columnar data and the schema.
+		if(columns){
+			columns->Close();
+			std::cout << msgHeader << "Wrote " << columns->GetEntries() << " processed data entries (" << columns->GetBytesWritten() / 1048576.0 << " MB) to columnar output \"" << columns->GetDirectory() << "\".\n";
+			columns->Print();
+		}
+
+		std::cout << msgHeader << "Found " << rotated_events + chanCounts->GetHist()->GetEntries() << " total events.\n";
 
 		// Get the total acquisition time.
 		std::stringstream stream;
@@ -216,77 +456,457 @@ simpleScanner::~simpleScanner(){
 
 		// If the root file is open, write the tree and histogram.
 		if(!writePresort && root_file->IsOpen()){
-			if(online_mode) // Write all online diagnostic histograms to the output root file.
-				std::cout << msgHeader << "Writing " << online->WriteHists(root_file) << " histograms to root file.\n";
-
-			// Add total data time to the file.
-			root_file->cd(head_path.c_str());
-			TNamed named("Data time", stream.str().c_str());
-			named.Write();
-			
-			root_file->cd();
-
-			// Write root trees to output file.
-			std::cout << msgHeader << "Writing " << root_tree->GetEntries() << " processed data entries to root file.\n";
-			root_tree->Write();			
-			
-			if(write_raw){
-				std::cout << msgHeader << "Writing " << raw_tree->GetEntries() << " raw data entries to root file.\n";
-				raw_tree->Write();
+			// Write the data time, trees, and histograms to the output file.
+			WriteRootOutput(true);
+
+			// Report the compression of each output tree.
+			if(root_tree) std::cout << msgHeader << "Output tree compression" << (chunk_number > 0 ? " (last output chunk)" : "") << ":\n";
+			PrintTreeStats(root_tree);
+			if(write_raw) PrintTreeStats(raw_tree);
+			if(write_traces) PrintTreeStats(trace_tree);
+			if(write_stats) PrintTreeStats(stat_tree);
+
+			// Report the time spent filling each output tree.
+			if(io_threads > 0){
+				std::cout << msgHeader << "Output tree filling (" << ROOT::GetThreadPoolSize() << " implicit MT threads):\n";
+				PrintFillStats(root_tree);
+				if(write_raw) PrintFillStats(raw_tree);
+				if(write_traces) PrintFillStats(trace_tree);
+				if(write_stats) PrintFillStats(stat_tree);
 			}
 			
-			if(write_traces){
-				std::cout << msgHeader << "Writing " << trace_tree->GetEntries() << " raw ADC traces to root file.\n";
+			// Write the trace tree to its own file.
+			if(trace_file){
+				std::cout << msgHeader << "Writing " << trace_tree->GetEntries() << " raw ADC traces to trace file '" << trace_filename << "'.\n";
+				trace_file->cd();
 				trace_tree->Write();
+				trace_file->Close();
+				delete trace_file;
 			}
-			
-			if(write_stats){
-				std::cout << msgHeader << "Writing " << stat_tree->GetEntries() << " raw event stats entries to root file.\n";
-				stat_tree->Write();
-			}
-			
-			// Write debug histograms.
-			chanCounts->GetHist()->Write();
-			chanMaxADC->GetHist()->Write();
-			chanEnergy->GetHist()->Write();
-			
+
 			// Close the root file.
 			root_file->Close();
+
+			// Report the output throughput.
+			double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - output_start).count();
+			double totalMB = (rotated_bytes + root_file->GetBytesWritten()) / 1048576.0;
+			std::cout << msgHeader << "Wrote " << totalMB << " MB to " << chunk_number+1 << " root file(s) in " << totalTime << " s (" << (totalTime > 0 ? totalMB / totalTime : 0) << " MB/s).\n";
+
 			delete root_file;
 		}
 		else if(writePresort){
 			// Write the remaining sorted data to the output file.
 			HandlePresortOutput(true);
 
-			// Close the file.
-			psort_file.write((char *)&fileFooterWord, 4);
-			psort_file.write((char *)&endBufferWord, 4);
-		
-			// Write the maximum raw event spill length and the total time to the header.
-			PLD_header tempHeader;
-			tempHeader.SetMaxSpillSize(maxSpillLength);
-			tempHeader.SetRunTime(handler->GetDeltaEventTime());
-			tempHeader.OverwriteValues(&psort_file);
-		
-			std::cout << msgHeader << "Wrote " << psort_file.tellp() << " B to output file.\n";
-			
+			std::cout << msgHeader << "Wrote " << rotated_bytes + spill_writer->Tell() << " B to " << chunk_number+1 << " output file(s) using " << spill_writer->GetNumWrites() << " writes.\n";
+
 			// Close the presort file.
-			psort_file.close();
+			ClosePresortFile(handler->GetDeltaEventTime() - chunk_start_time);
+
+			delete spill_writer;
+		}
+
+		// Report the number of events dropped by the output filter.
+		if(event_filter){
+			unsigned long long numFiltered = event_filter->GetNumAccepted() + event_filter->GetNumRejected();
+			std::cout << msgHeader << "Output filter accepted " << event_filter->GetNumAccepted() << " and rejected " << event_filter->GetNumRejected() << " events";
+			if(numFiltered > 0) std::cout << " (" << 100.0*event_filter->GetNumAccepted()/numFiltered << "% accepted)";
+			std::cout << ".\n";
+			delete event_filter;
+		}
+
+		delete hist_file;
+		delete event_index;
+
+		// Close the skim outputs.
+		for(std::vector<SkimStream*>::iterator iter = skims.begin(); iter != skims.end(); iter++){
+			(*iter)->Close();
+			std::cout << msgHeader << "Skim '" << (*iter)->GetName() << "' wrote " << (*iter)->GetNumFilled() << " of " << (*iter)->GetNumEvents() << " events to '" << (*iter)->GetFilename() << "'.\n";
+			delete (*iter);
+		}
+
+		// Report the compression of each channel's traces.
+		if(trace_codec){
+			std::cout << msgHeader << "Trace compression per channel:\n";
+			trace_codec->Print();
+			delete trace_codec;
+		}
+
+		// Replace the cache files of recomputed channels.
+		if(trace_cache){
+			trace_cache->Close();
+			trace_cache->Print();
+			delete trace_cache;
 		}
 
 		std::cout << msgHeader << "Processed " << loaded_files << " files.\n";
 		std::cout << msgHeader << "Found " << handler->GetTotalEvents() << " events.\n";
 		if(!untriggered_mode) std::cout << msgHeader << "Found " << handler->GetStartEvents() << " start events.\n";
 		std::cout << msgHeader << "Total data time is " << stream.str() << std::endl;
+
+		// Report the number of events dropped from ignored channels.
+		simpleUnpacker *unpacker = (simpleUnpacker*)GetCore();
+		if(unpacker->GetTotalRejected() > 0){
+			std::cout << msgHeader << "Rejected " << unpacker->GetTotalRejected() << " events from ignored channels.\n";
+			for(size_t chanID = 0; chanID < unpacker->GetMaskSize(); chanID++){
+				unsigned long count = unpacker->GetRejectedCount(chanID/16, chanID%16);
+				if(count > 0) std::cout << msgHeader << " mod=" << chanID/16 << ", chan=" << chanID%16 << ": " << count << " events\n";
+			}
+		}
+		if(unpacker->GetWindowRejected() > 0)
+			std::cout << msgHeader << "Rejected " << unpacker->GetWindowRejected() << " raw events outside of the time window.\n";
 	
 		delete mapfile;
 		delete configfile;
 		delete calibfile;
 		delete handler;
 		delete online;
+		delete writer;
+		delete columns;
 	}
 }
 
+/** Print the uncompressed size, compressed size, and compression ratio of an output tree.
+  * \param[in]  tree_ Pointer to the output tree.
+  * \return Nothing.
+  */
+void simpleScanner::PrintTreeStats(TTree *tree_){
+	if(!tree_) return;
+	double totBytes = tree_->GetTotBytes() / 1048576.0;
+	double zipBytes = tree_->GetZipBytes() / 1048576.0;
+	std::cout << msgHeader << " " << tree_->GetName() << ": " << totBytes << " MB uncompressed, " << zipBytes << " MB compressed";
+	if(zipBytes > 0) std::cout << " (ratio " << totBytes / zipBytes << ")";
+	std::cout << std::endl;
+}
+
+/** Print the time spent filling an output tree and the speedup from parallel basket compression.
+  * \param[in]  tree_ Pointer to the output tree.
+  * \return Nothing.
+  */
+void simpleScanner::PrintFillStats(extTree *tree_){
+	if(!tree_) return;
+	double wallTime = tree_->GetFillWallTime();
+	double cpuTime = tree_->GetFillCpuTime();
+	std::cout << msgHeader << " " << tree_->GetName() << ": " << wallTime << " s wall, " << cpuTime << " s CPU";
+	if(wallTime > 0) std::cout << " (speedup " << cpuTime / wallTime << ")";
+	if(writer) std::cout << " (includes CPU time of the scan thread)";
+	std::cout << std::endl;
+}
+
+/** Get the filename of the current output chunk. If rotation is disabled, this is the output filename.
+  * Otherwise, the chunk number is appended to the output filename (e.g. run_003.root).
+  * \return The filename of the current output chunk.
+  */
+std::string simpleScanner::GetChunkFilename(){
+	std::string fname = GetOutputFilename();
+	if(!RotationEnabled()) return fname;
+
+	// Insert the chunk number before the file extension.
+	std::string extension;
+	size_t dot = fname.find_last_of('.');
+	size_t slash = fname.find_last_of('/');
+	if(dot != std::string::npos && (slash == std::string::npos || dot > slash)){
+		extension = fname.substr(dot);
+		fname = fname.substr(0, dot);
+	}
+
+	std::stringstream stream;
+	stream << fname << "_" << std::setw(3) << std::setfill('0') << chunk_number << extension;
+
+	return stream.str();
+}
+
+/** Get the filename of a skim output. The name of the skim is appended to the output filename (e.g. run_vandle.root).
+  * \param[in]  name_ Name of the skim.
+  * \return The filename of the skim output.
+  */
+std::string simpleScanner::GetSkimFilename(const std::string &name_){
+	std::string fname = GetOutputFilename();
+
+	// Insert the skim name before the file extension.
+	std::string extension;
+	size_t dot = fname.find_last_of('.');
+	size_t slash = fname.find_last_of('/');
+	if(dot != std::string::npos && (slash == std::string::npos || dot > slash)){
+		extension = fname.substr(dot);
+		fname = fname.substr(0, dot);
+	}
+
+	return fname + "_" + name_ + extension;
+}
+
+/** Open a new root output file.
+  * \param[in]  fname_ Path to the output file.
+  * \return Pointer to the open file or NULL if the file could not be opened.
+  */
+TFile *simpleScanner::OpenRootFile(const std::string &fname_){
+	TFile *file = new TFile(fname_.c_str(), (force_overwrite ? "RECREATE" : "CREATE"));
+	if(!file->IsOpen()){
+		file->Close();
+		delete file;
+		return NULL;
+	}
+	return file;
+}
+
+/** Write the head directory and the map, config, and calibration entries to the root output file.
+  * \return Nothing.
+  */
+void simpleScanner::WriteSetupInfo(){
+	// Add file header information to the output root file.
+	root_file->mkdir("head");
+
+	// Add map and config file entries to the file.	
+	mapfile->Write(root_file);
+	configfile->Write(root_file);
+
+	// Add calibration entries to the file.
+	calibfile->Write(root_file);
+}
+
+/** Write the information of the current input file to the head directory of the root output file
+  * or write a header to the presort output file.
+  * \return Nothing.
+  */
+void simpleScanner::WriteFileInfo(){
+	fileInformation *finfo = GetFileInfo();
+	if(!finfo && mmap_input.empty()) return;
+
+	chunk_files++;
+
+	std::string name, value;
+	if(!writePresort){
+		// Write header information to the output root file.
+		std::stringstream stream;
+		if(chunk_files < 10){ stream << "head/file0" << chunk_files; }
+		else{ stream << "head/file" << chunk_files; }
+		head_path = stream.str();
+		root_file->mkdir(head_path.c_str());
+		root_file->cd(head_path.c_str());
+		for(size_t index = 0; finfo && index < finfo->size(); index++){
+			finfo->at(index, name, value);
+			TNamed named(name.c_str(), value.c_str());
+			named.Write();
+		}
+
+		// Files scanned with the memory-mapped reader are not loaded through the standard input path.
+		if(!mmap_input.empty()){
+			TNamed named("File name", mmap_input.c_str());
+			named.Write();
+		}
+		root_file->cd();
+	}
+	else if(mmap_input.empty()){ // The input file header is not available to the memory-mapped reader.
+		// Write header information to the output presort file.
+		spill_writer->Flush();
+		if(GetFileFormat() == 0){
+			PLD_header tempHeader;
+			tempHeader.SetFacility(std::string(GetLdfHeader()->GetFacility()));
+			tempHeader.SetFormat("PRESORTED_EVENTS");
+			tempHeader.SetStartDateTime(std::string(GetLdfHeader()->GetDate()));
+			tempHeader.SetEndDateTime(std::string(GetLdfHeader()->GetDate()));					
+			tempHeader.SetTitle(std::string(GetLdfHeader()->GetRunTitle()));
+			tempHeader.SetRunNumber(GetLdfHeader()->GetRunNumber());
+			tempHeader.Write(&psort_file);
+		}
+		else{
+			GetPldHeader()->SetFormat("PRESORTED_EVENTS");
+			GetPldHeader()->Write(&psort_file);
+		}
+		spill_writer->Sync();
+	}
+}
+
+/** Write the data time, all output trees, and all histograms of the current chunk to the root output file.
+  * \param[in]  verbose_ Print the number of entries written to each tree.
+  * \return Nothing.
+  */
+void simpleScanner::WriteRootOutput(const bool &verbose_){
+	if(online_mode){ // Write all online diagnostic histograms to the output root file.
+		int numHists = online->WriteHists(root_file);
+		if(verbose_) std::cout << msgHeader << "Writing " << numHists << " histograms to root file.\n";
+	}
+
+	// Add the data time of this chunk to the file.
+	std::stringstream stream;
+	stream << handler->GetDeltaEventTime() - chunk_start_time << " s";
+	root_file->cd(head_path.c_str());
+	TNamed named("Data time", stream.str().c_str());
+	named.Write();
+	
+	root_file->cd();
+
+	// Write root trees (or the histograms which replace them) to output file.
+	if(hist_file){
+		int numHists = hist_file->Write(root_file);
+		if(verbose_) std::cout << msgHeader << "Writing " << numHists << " user histograms to root file.\n";
+	}
+	else if(root_tree){
+		if(verbose_) std::cout << msgHeader << "Writing " << root_tree->GetEntries() << " processed data entries to root file.\n";
+		root_tree->Write();			
+	}
+	
+	if(write_raw){
+		if(verbose_) std::cout << msgHeader << "Writing " << raw_tree->GetEntries() << " raw data entries to root file.\n";
+		raw_tree->Write();
+	}
+
+	if(write_index){
+		if(verbose_) std::cout << msgHeader << "Writing " << index_tree->GetEntries() << " event index entries to root file.\n";
+		index_tree->Write();
+	}
+	
+	// A separate trace file is written once all chunks are complete.
+	if(write_traces && !trace_file){
+		if(verbose_) std::cout << msgHeader << "Writing " << trace_tree->GetEntries() << " raw ADC traces to root file.\n";
+		trace_tree->Write();
+	}
+	
+	if(write_stats){
+		if(verbose_) std::cout << msgHeader << "Writing " << stat_tree->GetEntries() << " raw event stats entries to root file.\n";
+		stat_tree->Write();
+	}
+	
+	// Write debug histograms.
+	chanCounts->GetHist()->Write();
+	chanMaxADC->GetHist()->Write();
+	chanEnergy->GetHist()->Write();
+}
+
+/** Write the footer of the presort output file, update its header, and close it.
+  * \param[in]  runTime_ The total data time of the file (in seconds).
+  * \return Nothing.
+  */
+void simpleScanner::ClosePresortFile(const double &runTime_){
+	// All complete spills must be on file before the footer is written.
+	spill_writer->Flush();
+
+	psort_file.write((char *)&fileFooterWord, 4);
+	psort_file.write((char *)&endBufferWord, 4);
+
+	// Write the spill index after the EOF words so that readers may seek directly to any spill.
+	presortIndex.WriteFooter(&psort_file);
+	presortIndex.Clear();
+
+	// Write the maximum raw event spill length and the total time to the header.
+	PLD_header tempHeader;
+	tempHeader.SetMaxSpillSize(maxSpillLength);
+	tempHeader.SetRunTime(runTime_);
+	tempHeader.OverwriteValues(&psort_file);
+
+	psort_file.close();
+}
+
+/** Start a new output chunk if the current chunk has reached the size or time limit.
+  * \return True if a new chunk was started and false otherwise.
+  */
+bool simpleScanner::CheckRotation(){
+	if(rotate_size == 0 && rotate_time <= 0) return false;
+
+	if(rotate_size > 0){
+		unsigned long long size;
+		if(writePresort) size = spill_writer->Tell();
+		else if(writer){ // The writer thread may be writing baskets to the file.
+			std::lock_guard<std::mutex> lock(writer->GetFillMutex());
+			size = root_file->GetEND();
+		}
+		else size = root_file->GetEND();
+		if(size >= rotate_size) return RotateOutput(true);
+	}
+
+	if(rotate_time > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - chunk_start).count() >= rotate_time)
+		return RotateOutput(true);
+
+	return false;
+}
+
+/** Close the current output chunk and start a new one. The new chunk is a complete output file
+  * with its own head, map, config, and calib directories.
+  * \param[in]  copyFileInfo_ Write the information of the current input file to the new chunk.
+  * \return True if the new chunk was opened successfully and false otherwise.
+  */
+bool simpleScanner::RotateOutput(const bool &copyFileInfo_){
+	std::string oldFilename = GetChunkFilename();
+	double dataTime = handler->GetDeltaEventTime();
+
+	chunk_number++;
+	std::string newFilename = GetChunkFilename();
+
+	if(!writePresort){
+		// All queued entries must be in the trees before they are written.
+		if(writer) writer->Flush();
+
+		TFile *newFile = OpenRootFile(newFilename);
+		if(!newFile){
+			std::cout << msgHeader << "Failed to open output root file '" << newFilename << "'! Continuing to write to '" << oldFilename << "'.\n";
+			chunk_number--;
+			return false;
+		}
+
+		// Write the current chunk.
+		WriteRootOutput(false);
+		if(hist_file) hist_file->Zero();
+
+		// Move the (now empty) trees to the new file.
+		extTree *trees[5] = {root_tree, raw_tree, trace_tree, stat_tree, index_tree};
+		bool active[5] = {true, write_raw, (write_traces && !trace_file), write_stats, write_index};
+		for(int i = 0; i < 5; i++){
+			if(!active[i] || !trees[i]) continue;
+			trees[i]->Reset();
+			trees[i]->SetDirectory(newFile);
+		}
+
+		root_file->Close();
+		rotated_bytes += root_file->GetBytesWritten();
+		delete root_file;
+		root_file = newFile;
+
+		// Each chunk holds only the histogram counts of its own data.
+		rotated_events += chanCounts->GetHist()->GetEntries();
+		chanCounts->Zero();
+		chanMaxADC->Zero();
+		chanEnergy->Zero();
+		if(online_mode) online->ZeroAll();
+
+		chunk_files = 0;
+		data_entries = 0;
+		head_path = "head";
+		WriteSetupInfo();
+	}
+	else{
+		// Close the current spill without writing the events of the raw event in progress.
+		if(currSpillLength > 0){
+			std::deque<ChannelEventPair*> pending;
+			pending.swap(chanEventList);
+			HandlePresortOutput(true);
+			pending.swap(chanEventList);
+		}
+
+		rotated_bytes += spill_writer->Tell();
+		ClosePresortFile(dataTime - chunk_start_time);
+
+		psort_file.open(newFilename.c_str());
+		if(!psort_file.good()){
+			std::cout << msgHeader << "Failed to open output presort file '" << newFilename << "'!\n";
+			return false;
+		}
+		spill_writer->Sync();
+
+		maxSpillLength = 0;
+		chunk_files = 0;
+	}
+
+	std::cout << msgHeader << "Closed output file '" << oldFilename << "'. Writing to '" << newFilename << "'.\n";
+
+	chunk_start_time = dataTime;
+	chunk_start = std::chrono::steady_clock::now();
+
+	// The current input file continues in the new chunk.
+	if(copyFileInfo_) WriteFileInfo();
+
+	return true;
+}
+
 /** ExtraCommands is used to send command strings to classes derived
   * from ScanInterface. If ScanInterface receives an unrecognized
   * command from the user, it will pass it on to the derived class.
@@ -305,7 +925,10 @@ bool simpleScanner::ExtraCommands(const std::string &cmd_, std::vector<std::stri
 				}
 				else{ std::cout << msgHeader << "Failed to set canvas update frequency to " << frequency << " events!\n"; }
 			}
-			else{ online->Refresh(); }
+			else{
+				std::lock_guard<std::mutex> lock(extTree::GetOutputLock());
+				online->Refresh();
+			}
 		}
 		else if(cmd_ == "list"){
 			online->PrintHists();
@@ -441,7 +1064,7 @@ bool simpleScanner::ExtraCommands(const std::string &cmd_, std::vector<std::stri
 			if(args_.size() >= 2){
 				std::string gateStr = (args_.size() >= 3)?args_.at(2):"";
 				std::string optStr = (args_.size() >= 4)?args_.at(3):"";
-				if(args_.at(0) == "data")
+				if(args_.at(0) == "data" && root_tree)
 					root_tree->SafeDraw(args_.at(1), gateStr, optStr);
 				else if(args_.at(0) == "raw")
 					raw_tree->SafeDraw(args_.at(1), gateStr, optStr);
@@ -530,6 +1153,138 @@ void simpleScanner::ExtraArguments(){
 		std::cout << msgHeader << "Forcing using of trace processor.\n";
 		forceUseOfTrace = true;
 	}
+	if(userOpts.at(12).active){ // Raw event block size.
+		int userBlockSize = atoi(userOpts.at(12).argument.c_str());
+		if(userBlockSize > 0){
+			block_size = userBlockSize;
+			std::cout << msgHeader << "Processing raw events in blocks of " << block_size << ".\n";
+		}
+		else{ std::cout << msgHeader << "Invalid raw event block size (" << userOpts.at(12).argument << ")!\n"; }
+	}
+	if(userOpts.at(13).active){ // Raw event time window.
+		std::string windowStr = userOpts.at(13).argument;
+		size_t index = windowStr.find(':');
+		if(index != std::string::npos){
+			std::string lowStr = windowStr.substr(0, index);
+			std::string highStr = windowStr.substr(index+1);
+			window_low = (!lowStr.empty() ? strtod(lowStr.c_str(), NULL) : -1);
+			window_high = (!highStr.empty() ? strtod(highStr.c_str(), NULL) : -1);
+			std::cout << msgHeader << "Only processing raw events in time window [" << lowStr << ", " << highStr << ").\n";
+		}
+		else{ std::cout << msgHeader << "Invalid raw event time window (" << windowStr << ")!\n"; }
+	}
+	if(userOpts.at(14).active){ // Asynchronous output.
+		async_output = true;
+		if(!userOpts.at(14).argument.empty()){
+			int userSlots = atoi(userOpts.at(14).argument.c_str());
+			if(userSlots > 0) async_slots = userSlots;
+			else{ std::cout << msgHeader << "Invalid number of asynchronous output buffers (" << userOpts.at(14).argument << ")!\n"; }
+		}
+		std::cout << msgHeader << "Filling output trees on a background thread (" << async_slots << " buffers).\n";
+	}
+	if(userOpts.at(16).active){ // Columnar output.
+		column_directory = userOpts.at(16).argument;
+		std::cout << msgHeader << "Writing processed data to columnar output \"" << column_directory << "\" instead of the data tree.\n";
+	}
+	if(userOpts.at(17).active){ // Output rotation by size.
+		double userSize = strtod(userOpts.at(17).argument.c_str(), NULL);
+		if(userSize > 0){
+			rotate_size = (unsigned long long)(userSize * 1048576);
+			std::cout << msgHeader << "Starting a new output file every " << userSize << " MB.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid output rotation size (" << userOpts.at(17).argument << ")!\n"; }
+	}
+	if(userOpts.at(18).active){ // Output rotation by time.
+		double userTime = strtod(userOpts.at(18).argument.c_str(), NULL);
+		if(userTime > 0){
+			rotate_time = userTime;
+			std::cout << msgHeader << "Starting a new output file every " << userTime << " s.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid output rotation time (" << userOpts.at(18).argument << ")!\n"; }
+	}
+	if(userOpts.at(19).active){ // Output rotation by number of input files.
+		int userFiles = atoi(userOpts.at(19).argument.c_str());
+		if(userFiles > 0){
+			rotate_files = userFiles;
+			std::cout << msgHeader << "Starting a new output file every " << userFiles << " input files.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid number of input files per output file (" << userOpts.at(19).argument << ")!\n"; }
+	}
+	if(userOpts.at(20).active){ // Presort spill size.
+		int userWords = atoi(userOpts.at(20).argument.c_str());
+		if(userWords > 0){
+			spillThreshold = userWords;
+			std::cout << msgHeader << "Closing presort spills after " << spillThreshold << " words.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid presort spill size (" << userOpts.at(20).argument << ")!\n"; }
+	}
+	if(userOpts.at(21).active){ // Presort output buffer size.
+		double userSize = strtod(userOpts.at(21).argument.c_str(), NULL);
+		if(userSize >= 0){
+			spill_flush_size = (size_t)(userSize * 1024);
+			std::cout << msgHeader << "Writing presort spills to file in blocks of " << userSize << " kB.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid presort output buffer size (" << userOpts.at(21).argument << ")!\n"; }
+	}
+	if(userOpts.at(22).active){ // Asynchronous presort output.
+		async_presort = true;
+		std::cout << msgHeader << "Writing presort spills on a background thread.\n";
+	}
+	if(userOpts.at(23).active){ // Memory-mapped presort input.
+		mmap_input = userOpts.at(23).argument;
+		std::cout << msgHeader << "Scanning presort file \"" << mmap_input << "\" using the memory-mapped reader.\n";
+	}
+	if(userOpts.at(24).active){ // Trace analysis cache.
+		trace_cache_dir = userOpts.at(24).argument;
+		std::cout << msgHeader << "Caching trace analysis results in \"" << trace_cache_dir << "\".\n";
+	}
+	if(userOpts.at(25).active){ // Separate trace file.
+		trace_filename = userOpts.at(25).argument;
+		write_traces = true;
+		std::cout << msgHeader << "Writing ADC traces to separate file \"" << trace_filename << "\".\n";
+	}
+	if(userOpts.at(26).active){ // Trace compression.
+		compress_traces = true;
+		write_traces = true;
+		std::cout << msgHeader << "Compressing ADC traces before writing.\n";
+	}
+	if(userOpts.at(15).active){ // Implicit multithreading of output.
+		int userThreads = atoi(userOpts.at(15).argument.c_str());
+		if(userThreads > 0){
+			io_threads = userThreads;
+			std::cout << msgHeader << "Compressing output trees using " << io_threads << " threads.\n";
+		}
+		else{ std::cout << msgHeader << "Invalid number of output threads (" << userOpts.at(15).argument << ")!\n"; }
+	}
+	if(userOpts.at(28).active){ // Event index of the data tree.
+		if(!column_directory.empty()) // The index entries must match the entries of the data tree.
+			std::cout << msgHeader << "Warning! The event index is disabled when writing columnar output.\n";
+		else{
+			write_index = true;
+			std::cout << msgHeader << "Writing an event index of the data tree to the output file.\n";
+		}
+	}
+	if(userOpts.at(29).active){ // Flat output layout.
+		flat_output = true;
+		std::cout << msgHeader << "Writing the data tree using the flat output layout.\n";
+		if(async_output){
+			std::cout << msgHeader << "Warning! Asynchronous output is not supported by the flat output layout.\n";
+			async_output = false;
+		}
+	}
+	if(userOpts.at(27).active){ // Histogram-only output.
+		hist_filename = userOpts.at(27).argument;
+		std::cout << msgHeader << "Filling histograms defined in \"" << hist_filename << "\" instead of writing output trees.\n";
+		if(write_traces || write_raw || write_stats || !column_directory.empty())
+			std::cout << msgHeader << "Warning! Trace, raw, stats, and columnar output are disabled in histogram-only mode.\n";
+		write_traces = false;
+		write_raw = false;
+		write_index = false;
+		write_stats = false;
+		column_directory = "";
+		async_output = false;
+		io_threads = 0;
+	}
 }
 
 /** CmdHelp is used to allow a derived class to print a help statement about
@@ -574,6 +1329,24 @@ void simpleScanner::ArgHelp(){
 	AddOption(optionExt("record", no_argument, NULL, 0, "", "Write all start events to output file even when no other events are found"));
 	AddOption(optionExt("parameters", required_argument, NULL, 0, "<list>", "Set default fitting/CFD parameters by supplying comma-delimited string"));
 	AddOption(optionExt("force-traces", no_argument, NULL, 0, "", "Change all entries in map file to type 'trace' to do trace analysis"));
+	AddOption(optionExt("block", required_argument, NULL, 0, "<size>", "Process raw events in blocks of the specified size (default=1)"));
+	AddOption(optionExt("window", required_argument, NULL, 0, "<tmin:tmax>", "Only process raw events starting in the specified range of pixie clock ticks"));
+	AddOption(optionExt("async", optional_argument, NULL, 0, "[=buffers]", "Fill the output trees on a background thread using the specified number of buffers, given as --async=<buffers> (default=64)"));
+	AddOption(optionExt("io-threads", required_argument, NULL, 0, "<N>", "Use root implicit multithreading with N threads to compress the output trees"));
+	AddOption(optionExt("columns", required_argument, NULL, 0, "<dir>", "Write processed data to memory-mappable column files in the specified directory instead of the data tree"));
+	AddOption(optionExt("rotate-size", required_argument, NULL, 0, "<MB>", "Start a new output file (run_NNN.root) when the current one reaches the specified size"));
+	AddOption(optionExt("rotate-time", required_argument, NULL, 0, "<seconds>", "Start a new output file after the specified wall-clock time"));
+	AddOption(optionExt("rotate-files", required_argument, NULL, 0, "<N>", "Start a new output file after every N input files"));
+	AddOption(optionExt("presort-spill", required_argument, NULL, 0, "<words>", "Close presort output spills after the specified number of words (default=10000)"));
+	AddOption(optionExt("presort-buffer", required_argument, NULL, 0, "<kB>", "Collect complete presort spills in a buffer of the specified size before writing them to file (default=1024)"));
+	AddOption(optionExt("presort-async", no_argument, NULL, 0, "", "Write presort output spills on a background thread"));
+	AddOption(optionExt("mmap-presort", required_argument, NULL, 0, "<filename>", "Scan a presort file using the fast memory-mapped reader instead of the standard input path"));
+	AddOption(optionExt("trace-cache", required_argument, NULL, 0, "<dir>", "Store trace analysis results in the specified directory and reuse them for channels whose analysis parameters are unchanged"));
+	AddOption(optionExt("trace-file", required_argument, NULL, 0, "<filename>", "Write ADC traces to a separate root file instead of the output file (implies --traces)"));
+	AddOption(optionExt("trace-codec", no_argument, NULL, 0, "", "Write ADC traces as losslessly compressed byte streams (implies --traces)"));
+	AddOption(optionExt("hist-only", required_argument, NULL, 0, "<filename>", "Fill the histograms defined in the specified file instead of writing any output trees"));
+	AddOption(optionExt("index", no_argument, NULL, 0, "", "Write the time, detector mask, and detector multiplicities of each data tree entry to an index tree"));
+	AddOption(optionExt("flat", no_argument, NULL, 0, "", "Write the data tree as fixed-size array leaves (e.g. vandle_ctof[vandle_mult]) instead of structure branches"));
 }
 
 /** SyntaxStr is used to print a linux style usage message to the screen.
@@ -591,6 +1364,9 @@ void simpleScanner::SyntaxStr(char *name_){
   * \return Nothing.
   */
 void simpleScanner::IdleTask(){
+	// Do not hold on to a partial block while waiting for more data.
+	((simpleUnpacker*)GetCore())->FlushBlock(this);
+
 	gSystem->ProcessEvents();
 }
 
@@ -644,10 +1420,13 @@ bool simpleScanner::Initialize(std::string prefix_){
 		return false;
 	}
 
-	for(int i = 0; i <= mapfile->GetMaxModule(); i++){
-		for(int j = 0; j < 16; j++){
+	for(int i = 0; i < mapfile->GetMaxModules(); i++){
+		for(int j = 0; j < mapfile->GetMaxChannels(); j++){
 			MapEntry *mapptr = mapfile->GetMapEntry(i, j);
-			if(!mapptr || mapptr->type == "ignore") continue;
+			if(!mapptr || mapptr->type == "ignore"){ // Drop events from this channel inside the unpacker.
+				((simpleUnpacker*)GetCore())->RejectChannel(i, j);
+				continue;
+			}
 			else if(mapptr->hasTag("untriggered")){ // Add this channel to the unpacker whitelist so that it is always added to the raw event.
 				GetCore()->AddToWhitelist(i, j);
 				std::cout << prefix_ << "Adding mod=" << i << ", chan=" << j << " to unpacker whitelist.\n";
@@ -708,6 +1487,8 @@ bool simpleScanner::Initialize(std::string prefix_){
 	std::cout << prefix_ << "Set event width to " << configfile->eventWidth << " μs (" << GetCore()->GetEventWidth() << " pixie clock ticks).\n";
 	std::cout << prefix_ << "Set event delay to " << configfile->eventDelay << " μs (" << GetCore()->GetEventDelay() << " pixie clock ticks).\n";
 	std::cout << prefix_ << "Set raw event builder mode to (" << configfile->buildMethod << ").\n";
+	((simpleUnpacker*)GetCore())->SetBlockSize(block_size);
+	((simpleUnpacker*)GetCore())->SetTimeWindow(window_low, window_high);
 	handler = new ProcessorHandler();
 	
 	int startMod, startChan;
@@ -742,7 +1523,7 @@ bool simpleScanner::Initialize(std::string prefix_){
 		std::string userInput;
 		while(true){
 			std::cout << prefix_ << "Encountered errors during initialization. Continue? (y,n) ";
-			std::cin >> userInput;
+			if(!(std::cin >> userInput)) return false; // No terminal input (e.g. running in the background).
 			if(userInput == "y" || userInput == "Y") break;
 			else if(userInput == "n" || userInput == "N") return false; // Hard abort.
 			std::cout << prefix_ << "Invalid input (" << userInput << ").\n";
@@ -750,55 +1531,202 @@ bool simpleScanner::Initialize(std::string prefix_){
 	}
 	
 	if(!writePresort){
+		// Histogram-only scans fill histograms directly from the processor structures and create no output trees.
+		// The histograms are created before the output file is opened so that they are not owned by it.
+		if(!hist_filename.empty()){
+			std::cout << prefix_ << "Reading histogram definition file " << hist_filename << "\n";
+			hist_file = new HistFile(hist_filename.c_str());
+			if(!hist_file->IsInit() || !handler->InitHistOutput(hist_file) || !hist_file->Compile()){
+				std::cout << prefix_ << "Failed to initialize histograms from '" << hist_filename << "'!\n";
+				return false;
+			}
+			std::cout << prefix_ << "Filling " << hist_file->GetNumHists() << " histograms without output trees.\n";
+		}
+
 		// Initialize the root output file.
 		std::cout << prefix_ << "Initializing root output.\n";
-		if(force_overwrite){ root_file = new TFile(GetOutputFilename().c_str(), "RECREATE"); }
-		else{ root_file = new TFile(GetOutputFilename().c_str(), "CREATE"); }
+		root_file = OpenRootFile(GetChunkFilename());
 
 		// Check that the root file is open.
-		if(!root_file->IsOpen()){
-			std::cout << prefix_ << "Failed to open output root file '" << GetOutputFilename() << "'!\n";
-			root_file->Close();
-			delete root_file;
-			root_file = NULL;
+		if(!root_file){
+			std::cout << prefix_ << "Failed to open output root file '" << GetChunkFilename() << "'!\n";
 			return false;
 		}
 		
-		// Setup the root tree for data output.
-		root_tree = new extTree("data", "Pixie data");
+		output_start = std::chrono::steady_clock::now();
+		chunk_start = output_start;
+
+		// Setup the background thread for filling the output trees.
+		if(async_output){
+			ROOT::EnableThreadSafety();
+			writer = new AsyncWriter(async_slots);
+		}
+
+		// Enable parallel compression of output tree baskets. Must be called before any trees are created.
+		if(io_threads > 0){
+			ROOT::EnableImplicitMT(io_threads);
+			std::cout << prefix_ << "Enabled root implicit multithreading (" << ROOT::GetThreadPoolSize() << " threads).\n";
+		}
+		
+		// Setup the root tree for data output. The histograms or the columnar output replace it.
+		if(!hist_file && column_directory.empty()) root_tree = new extTree("data", "Pixie data");
 	
 		// Setup the raw data tree for output.
 		if(write_raw){
 			raw_tree = new extTree("raw", "Raw pixie data");
 	
 			// Add branches to the xia data tree.
-			raw_tree->Branch("loc", &xia_data_location);
-			raw_tree->Branch("energy", &xia_data_energy);
-			raw_tree->Branch("time", &xia_data_time);
+			if(writer){
+				writer->Branch(raw_tree, "loc", &xia_data_location);
+				writer->Branch(raw_tree, "energy", &xia_data_energy);
+				writer->Branch(raw_tree, "time", &xia_data_time);
+			}
+			else{
+				raw_tree->Branch("loc", &xia_data_location);
+				raw_tree->Branch("energy", &xia_data_energy);
+				raw_tree->Branch("time", &xia_data_time);
+			}
+			configfile->rawTree.Apply(raw_tree);
+			std::cout << prefix_ << "Set output tree options (" << configfile->rawTree.Print() << ").\n";
+		}
+
+		// Setup the event index tree for fast entry selection in the tools.
+		if(write_index){
+			index_tree = new extTree("index", "Pixie data event index");
+			event_index = new EventIndex();
+			handler->InitEventIndex(event_index);
+			event_index->Branch(index_tree, writer);
+			std::cout << prefix_ << "Indexing " << event_index->GetNumStructures() << " detector types.\n";
 		}
 
 		// Initialize the unpacker tree.
-		if(write_stats)
-			stat_tree = ((simpleUnpacker*)GetCore())->InitTree();
+		if(write_stats){
+			stat_tree = ((simpleUnpacker*)GetCore())->InitTree(writer);
+			configfile->statsTree.Apply(stat_tree);
+			std::cout << prefix_ << "Set output tree options (" << configfile->statsTree.Print() << ").\n";
+		}
 
 		// Add branches to the output tree.
-		handler->InitRootOutput(root_tree);		
+		if(root_tree){
+			if(flat_output) handler->SetFlatOutput();
+			handler->InitRootOutput(root_tree, configfile->dataTree.splitLevel, writer);
+			configfile->dataTree.Apply(root_tree);
+			std::cout << prefix_ << "Set output tree options (" << configfile->dataTree.Print() << ").\n";
+		}
+
+		// Setup the columnar output for processed data.
+		if(!column_directory.empty()){
+			columns = new ColumnWriter();
+			if(!columns->Open(column_directory) || !handler->InitColumnOutput(columns)){
+				std::cout << prefix_ << "Failed to initialize columnar output in \"" << column_directory << "\"!\n";
+				return false;
+			}
+		}
+
+		// Compile the output event filter.
+		if(!configfile->outputFilter.empty()){
+			event_filter = new EventFilter();
+			handler->InitEventFilter(event_filter);
+			if(!event_filter->Compile(configfile->outputFilter)){
+				std::cout << prefix_ << "Failed to compile output filter \"" << configfile->outputFilter << "\"!\n";
+				std::cout << prefix_ << " " << event_filter->GetError() << ".\n";
+				return false;
+			}
+			std::cout << prefix_ << "Only writing events passing output filter \"" << configfile->outputFilter << "\".\n";
+		}
+
+		// Setup the skim outputs. Each skim shares the unpacking and processing of the data tree.
+		if(!hist_file){
+			for(std::vector<SkimConfig>::iterator iter = configfile->skims.begin(); iter != configfile->skims.end(); iter++){
+				std::string skim_filename = GetSkimFilename(iter->name);
+				TFile *skim_file = OpenRootFile(skim_filename);
+				if(!skim_file){
+					std::cout << prefix_ << "Failed to open skim output file '" << skim_filename << "'!\n";
+					return false;
+				}
+
+				SkimStream *skim = new SkimStream(*iter, skim_file);
+				skims.push_back(skim);
+
+				handler->InitSkimOutput(skim, configfile->dataTree.splitLevel);
+				if(!skim->Compile()){
+					std::cout << prefix_ << "Failed to compile filter \"" << iter->filter << "\" of skim '" << iter->name << "'!\n";
+					std::cout << prefix_ << " " << skim->GetError() << ".\n";
+					return false;
+				}
+				configfile->dataTree.Apply(skim->GetTree());
+				std::cout << prefix_ << "Writing skim '" << iter->name << "' (" << skim->GetNumBranches() << " branches) to '" << skim_filename << "'.\n";
+			}
+			root_file->cd();
+		}
+		else if(!configfile->skims.empty())
+			std::cout << prefix_ << "Warning! Skim outputs are disabled in histogram-only mode. Ignoring " << configfile->skims.size() << " skim(s).\n";
 
 		// Set processor options.
 		if(write_traces){ 
+			// Traces are written to a single tree, either in the output file or in a separate trace file.
+			if(!trace_filename.empty()){
+				trace_file = OpenRootFile(trace_filename);
+				if(!trace_file){
+					std::cout << prefix_ << "Failed to open output trace file '" << trace_filename << "'!\n";
+					return false;
+				}
+				trace_file->cd();
+			}
+
 			trace_tree = new extTree("trace", "Raw pixie ADC traces");
-			handler->InitTraceOutput(trace_tree); 
+
+			// Link each trace entry to its entry in the data tree.
+			if(writer){
+				writer->Branch(trace_tree, "entry", &trace_entry);
+				writer->Branch(trace_tree, "chunk", &trace_chunk);
+			}
+			else{
+				trace_tree->Branch("entry", &trace_entry);
+				trace_tree->Branch("chunk", &trace_chunk);
+			}
+
+			// Write compressed traces in place of the trace structures.
+			if(compress_traces){
+				trace_codec = new TraceCodec();
+				handler->SetTraceCodec(trace_codec);
+			}
+
+			handler->InitTraceOutput(trace_tree, configfile->traceTree.splitLevel, writer); 
+			configfile->traceTree.Apply(trace_tree);
+			std::cout << prefix_ << "Set output tree options (" << configfile->traceTree.Print() << ").\n";
+
+			root_file->cd();
 		}
+
+		// Record the time spent filling each tree to measure the compression speedup.
+		if(io_threads > 0){
+			if(root_tree) root_tree->SetFillTiming();
+			if(write_raw) raw_tree->SetFillTiming();
+			if(write_stats) stat_tree->SetFillTiming();
+			if(write_traces) trace_tree->SetFillTiming();
+		}
+
+		// All branches are defined, so start filling the trees.
+		if(writer) writer->Start();
 	}
 	else{
 		// Initialize the presort file.
 		std::cout << prefix_ << "Initializing presort output file.\n";
-		psort_file.open(GetOutputFilename().c_str());
+		psort_file.open(GetChunkFilename().c_str());
+		spill_writer = new SpillWriter(&psort_file, spill_flush_size, async_presort);
+		chunk_start = std::chrono::steady_clock::now();
 	}
 
 	// Set processor options.
 	if(use_root_fitting){ handler->ToggleFitting(); }
 
+	// Reuse trace analysis results from previous scans.
+	if(!trace_cache_dir.empty()){
+		trace_cache = new TraceCache(trace_cache_dir);
+		handler->SetTraceCache(trace_cache);
+	}
+
 	// Set untriggered mode.
 	if(untriggered_mode)
 		handler->ToggleUntriggered();
@@ -811,15 +1739,8 @@ bool simpleScanner::Initialize(std::string prefix_){
   */
 void simpleScanner::FinalInitialization(){
 	if(!writePresort){
-		// Add file header information to the output root file.
-		root_file->mkdir("head");
-	
-		// Add map and config file entries to the file.	
-		mapfile->Write(root_file);
-		configfile->Write(root_file);
-
-		// Add calibration entries to the file.
-		calibfile->Write(root_file);
+		// Add file header information and the map, config, and calibration entries to the output root file.
+		WriteSetupInfo();
 	}
 	else{
 	}
@@ -832,45 +1753,15 @@ void simpleScanner::FinalInitialization(){
 void simpleScanner::Notify(const std::string &code_/*=""*/){
 	if(code_ == "START_SCAN"){  }
 	else if(code_ == "STOP_SCAN"){  }
-	else if(code_ == "SCAN_COMPLETE"){ std::cout << msgHeader << "Scan complete.\n"; }
+	else if(code_ == "SCAN_COMPLETE"){ 
+		// Process any raw events remaining in the unpacker's current block.
+		((simpleUnpacker*)GetCore())->FlushBlock(this);
+		std::cout << msgHeader << "Scan complete.\n"; 
+	}
 	else if(code_ == "LOAD_FILE"){
 		std::cout << msgHeader << "File loaded.\n";
 		fileInformation *finfo = GetFileInfo();
-		if(finfo){
-			loaded_files++;
-			std::string name, value;
-			if(!writePresort){
-				// Write header information to the output root file.
-				std::stringstream stream;
-				if(loaded_files < 10){ stream << "head/file0" << loaded_files; }
-				else{ stream << "head/file" << loaded_files; }
-				head_path = stream.str();
-				root_file->mkdir(head_path.c_str());
-				root_file->cd(head_path.c_str());
-				for(size_t index = 0; index < finfo->size(); index++){
-					finfo->at(index, name, value);
-					TNamed named(name.c_str(), value.c_str());
-					named.Write();
-				}
-			}
-			else{
-				// Write header information to the output presort file.
-				if(GetFileFormat() == 0){
-					PLD_header tempHeader;
-					tempHeader.SetFacility(std::string(GetLdfHeader()->GetFacility()));
-					tempHeader.SetFormat("PRESORTED_EVENTS");
-					tempHeader.SetStartDateTime(std::string(GetLdfHeader()->GetDate()));
-					tempHeader.SetEndDateTime(std::string(GetLdfHeader()->GetDate()));					
-					tempHeader.SetTitle(std::string(GetLdfHeader()->GetRunTitle()));
-					tempHeader.SetRunNumber(GetLdfHeader()->GetRunNumber());
-					tempHeader.Write(&psort_file);
-				}
-				else{
-					GetPldHeader()->SetFormat("PRESORTED_EVENTS");
-					GetPldHeader()->Write(&psort_file);
-				}
-			}
-		}
+		if(finfo){ StartInputFile(); }
 		else{ std::cout << msgHeader << "Failed to fetch input file info!\n"; }
 	}
 	else if(code_ == "REWIND_FILE"){  }
@@ -878,6 +1769,22 @@ void simpleScanner::Notify(const std::string &code_/*=""*/){
 	else{ std::cout << msgHeader << "Unknown notification code '" << code_ << "'!\n"; }
 }
 
+/** Set up the output for a new input file. Must be called once for each input file before it is scanned.
+  * \return Nothing.
+  */
+void simpleScanner::StartInputFile(){
+	loaded_files++;
+
+	// Start a new output chunk if the current chunk already holds the maximum number of input files.
+	if(rotate_files > 0 && chunk_files >= rotate_files)
+		RotateOutput(false);
+
+	WriteFileInfo();
+
+	// Each input file has its own set of trace analysis cache files.
+	if(trace_cache) trace_cache->SetRun(GetCacheRunName());
+}
+
 /** Return a pointer to the Unpacker object to use for data unpacking.
   * If no object has been initialized, create a new one.
   * \return Pointer to an Unpacker object.
@@ -889,11 +1796,146 @@ Unpacker *simpleScanner::GetCore(){
 
 /** Add a channel event to the deque of events to send to the processors.
   * This method should only be called from Unpacker::ProcessRawEvent().
+  * The scanner takes ownership of the event, which must be a ChanEvent.
   * \param[in]  event_ The raw XiaData to add.
   * \return True if the event is added to the processor handler, and false otherwise.
   */
 bool simpleScanner::AddEvent(XiaData *event_){
-	if(!event_){ return false; }
+	ChannelEventPair *pair_ = BuildPair(event_);
+	if(!pair_){ return false; }
+	
+	return AddPair(pair_);
+}
+
+/** Process all channel events read in from the rawEvent.
+  * This method should only be called from Unpacker::ProcessRawEvent().
+  * \return True if at least one valid signal was found, and false otherwise.
+  */
+bool simpleScanner::ProcessEvents(){
+	bool retval = ProcessCurrentEvent();
+
+	// Check for the need to update the online canvas.
+	CheckOnlineUpdate();
+	
+	return retval;
+}
+
+/** Process a block of raw events. All channel events in the block are preprocessed
+  * in a single pass by each processor before the raw events are processed and written
+  * to the output one at a time. This method should only be called from simpleUnpacker::FlushBlock()
+  * or ScanPresortFile().
+  * \param[in]  block_ Deque of raw events, each of which is a deque of channel events.
+  * \return The number of raw events in which at least one valid signal was found.
+  */
+unsigned int simpleScanner::ProcessBlock(std::deque<std::deque<XiaData*> > &block_){
+	if(block_.empty()){ return 0; }
+
+	// Map all channel events in the block and hand them to the processors for preprocessing.
+	if(blockPairs.size() < block_.size())
+		blockPairs.resize(block_.size());
+	for(size_t index = 0; index < block_.size(); index++){
+		blockPairs[index].clear();
+		bool hasNonStart = false;
+		for(std::deque<XiaData*>::iterator iter = block_[index].begin(); iter != block_[index].end(); ++iter){
+			ChannelEventPair *pair_ = BuildPair(*iter);
+			if(!pair_){ continue; }
+			if(untriggered_mode || !pair_->entry->hasTag("start")) hasNonStart = true;
+			blockPairs[index].push_back(pair_);
+		}
+		block_[index].clear();
+
+		// Only preprocess raw events which will actually be processed (see ProcessCurrentEvent).
+		// Events of other raw events are still passed to AddPair() so that they are cleaned up.
+		if(!hasNonStart && !recordAllStarts){ continue; }
+		for(std::vector<ChannelEventPair*>::iterator iter = blockPairs[index].begin(); iter != blockPairs[index].end(); ){
+			if(!handler->AddBlockEvent(*iter)){ // Invalid detector type. Delete it
+				delete (*iter);
+				iter = blockPairs[index].erase(iter);
+				continue;
+			}
+			++iter;
+		}
+	}
+
+	// Compute high resolution timing, energy, etc. for the entire block at once.
+	handler->PreProcessBlock();
+
+	// Process the raw events one at a time.
+	unsigned int numValid = 0;
+	for(size_t index = 0; index < block_.size(); index++){
+		if(blockPairs[index].empty()){ continue; }
+		for(std::vector<ChannelEventPair*>::iterator iter = blockPairs[index].begin(); iter != blockPairs[index].end(); ++iter){
+			AddPair(*iter);
+		}
+		blockPairs[index].clear();
+		if(ProcessCurrentEvent(true)) numValid++;
+	}
+	
+	// Check for the need to update the online canvas.
+	CheckOnlineUpdate(block_.size());
+
+	return numValid;
+}
+
+/** Scan a presort file using the memory-mapped presort reader instead of the generic input path.
+  * Each spill is decoded directly into a block of raw events, and ADC traces are only copied for
+  * channels which require them.
+  * \param[in]  fname_ Path to the input presort file.
+  * \return True if the file was scanned successfully and false otherwise.
+  */
+bool simpleScanner::ScanPresortFile(const std::string &fname_){
+	PresortReader reader;
+	if(!reader.Open(fname_)){
+		std::cout << msgHeader << "Failed to open presort file '" << fname_ << "'!\n";
+		return false;
+	}
+
+	// Traces are only needed for trace analysis or when writing them to the output.
+	if(write_traces) reader.KeepAllTraces();
+	else{
+		for(int i = 0; i < mapfile->GetMaxModules(); i++){
+			for(int j = 0; j < mapfile->GetMaxChannels(); j++){
+				MapEntry *mapptr = mapfile->GetMapEntry(i, j);
+				if(mapptr && mapptr->type == "trace") reader.SetTraceFlag(i, j);
+			}
+		}
+	}
+	reader.SetTimeWindow(window_low, window_high);
+
+	// The physics processors do not need to preprocess presorted data.
+	handler->SetPresortMode(true);
+	presortData = true;
+	firstEvent = false;
+
+	// Run the same per-file setup as files loaded through the standard input path.
+	StartInputFile();
+
+	std::cout << msgHeader << "Scanning " << reader.GetNumSpills() << " spills (" << reader.GetLength() / 1048576.0 << " MB) from presort file '" << fname_ << "'.\n";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::deque<std::deque<XiaData*> > block;
+	for(size_t index = 0; index < reader.GetNumSpills(); index++){
+		if(reader.ReadSpill(index, GetCore(), block) > 0)
+			ProcessBlock(block);
+		block.clear();
+	}
+
+	double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double totalMB = reader.GetLength() / 1048576.0;
+	std::cout << msgHeader << "Decoded " << reader.GetNumEvents() << " events in " << reader.GetNumRawEvents() << " raw events in " << totalTime << " s (" << (totalTime > 0 ? totalMB / totalTime : 0) << " MB/s).\n";
+	if(reader.GetSkippedTraceBytes() > 0)
+		std::cout << msgHeader << "Skipped " << reader.GetSkippedTraceBytes() / 1048576.0 << " MB of unused ADC traces.\n";
+
+	return true;
+}
+
+/** Map a channel event and link it to its map and calibration entries.
+  * \param[in]  event_ The raw XiaData to map. Deleted if the channel is not mapped.
+  * \return Pointer to the new ChannelEventPair or NULL if the event was rejected.
+  */
+ChannelEventPair *simpleScanner::BuildPair(XiaData *event_){
+	if(!event_){ return NULL; }
 
 	if(firstEvent){ // This is the first event to be processed.
 		if(this->GetFileFormat() == 2){ // Reading presorted data from file.
@@ -913,27 +1955,20 @@ bool simpleScanner::AddEvent(XiaData *event_){
 		xia_data_location = 16*event_->modNum + event_->chanNum;
 		xia_data_energy = event_->energy;
 		xia_data_time = event_->time*8E-9;
-		raw_tree->SafeFill();
+		raw_tree->SafeFill(writer);
 	}
 
 	// Check that this channel is defined in the map.
 	MapEntry *mapentry = mapfile->GetMapEntry(event_);
 	if(!mapentry || mapentry->type == "ignore"){
 		delete event_;
-		return false;
+		return NULL;
 	}
 	
-	ChanEvent *current_event = NULL;
-	
-	if(!presortData){ // Non presorted data. Create a new ChanEvent.
-		current_event = new ChanEvent(event_);
-		
-		// We no longer need the XiaData since we made a copy of it using ChanEvent.
-		delete event_;
-	}
-	else{ // We already have a ChanEvent. Convert XiaData pointer to ChanEvent pointer.
-		current_event = (ChanEvent*)event_;
-	}
+	// The unpacker allocates all channel events as ChanEvents (see simpleUnpacker::GetNewEvent)
+	// and presorted data is read directly into ChanEvents, so we may take ownership of the
+	// event (and its ADC trace) without making a copy of it.
+	ChanEvent *current_event = (ChanEvent*)event_;
 	
 	// Link the channel event to its corresponding map entry.
 	ChannelEventPair *pair_;
@@ -947,6 +1982,14 @@ bool simpleScanner::AddEvent(XiaData *event_){
 		chanMaxADC->Fill(pair_->channelEvent->maximum, pair_->entry->location);
 	}
 	
+	return pair_;
+}
+
+/** Pass a channel event pair to the processor handler and add it to the current raw event.
+  * \param[in]  pair_ The pair to add. Deleted if no processor accepts the event.
+  * \return True if the pair is added to the processor handler, and false otherwise.
+  */
+bool simpleScanner::AddPair(ChannelEventPair *pair_){
 	// Pass this event to the correct processor
 	if(!handler->AddEvent(pair_)){ // Invalid detector type. Delete it
 		delete pair_;
@@ -970,11 +2013,11 @@ bool simpleScanner::AddEvent(XiaData *event_){
 	return true;
 }
 
-/** Process all channel events read in from the rawEvent.
-  * This method should only be called from Unpacker::ProcessRawEvent().
+/** Process all channel events in the current raw event and clear the event list.
+  * \param[in]  preprocessed_ Set to true if the events have already been preprocessed.
   * \return True if at least one valid signal was found, and false otherwise.
   */
-bool simpleScanner::ProcessEvents(){
+bool simpleScanner::ProcessCurrentEvent(const bool &preprocessed_/*=false*/){
 	bool retval = true;
 
 	// Check that at least one of the events in the event list is not a
@@ -983,23 +2026,47 @@ bool simpleScanner::ProcessEvents(){
 	if(nonStartEvents || recordAllStarts){
 		if(!writePresort){
 			// Call each processor to do the processing.
-			if(handler->Process()){ // This event had at least one valid signal
-				// Fill the root tree with processed data.
-				root_tree->SafeFill();
+			if(handler->Process(!preprocessed_)){ // This event had at least one valid signal
+				// Fill each skim output with the events passing its own filter.
+				for(std::vector<SkimStream*>::iterator iter = skims.begin(); iter != skims.end(); iter++)
+					(*iter)->Fill();
+
+				// Drop events failing the output filter before they are serialized.
+				if(!event_filter || event_filter->Accept()){
+					// Fill the root tree (or the columnar output or histograms) with processed data.
+					if(hist_file) hist_file->Fill();
+					else if(columns) columns->Fill();
+					else root_tree->SafeFill(writer);
+
+					// Fill the event index with the same entry number as the data tree.
+					if(write_index){
+						event_index->Update(handler->GetDeltaEventTime());
+						index_tree->SafeFill(writer);
+					}
 
-				// Fill the ADC trace tree with raw traces.		
-				if(write_traces){ trace_tree->SafeFill(); }
+					// Fill the ADC trace tree with raw traces, linked to the data entry by its index.
+					if(write_traces){
+						trace_entry = data_entries;
+						trace_chunk = chunk_number;
+						trace_tree->SafeFill(writer);
+					}
+					data_entries++;
+				}
 			}
 			else{ retval = false; }
 		}
 		else{
 			// Call each processor's preprocess routine.
 			// The preprocessors will calculate high res timing, energy, etc.
-			handler->PreProcess();
+			if(!preprocessed_) handler->PreProcess();
 
 			// Write the sorted data to the output file.
 			HandlePresortOutput();
 		}
+
+		// Start a new output chunk if required. Presort files are only split between spills.
+		if(!writePresort || currSpillLength == 0)
+			CheckRotation();
 		
 		nonStartEvents = false;
 	}
@@ -1012,35 +2079,132 @@ bool simpleScanner::ProcessEvents(){
 		delete chanEventList.front();
 		chanEventList.pop_front(); // Remove this event from the raw event deque.
 	}
+	
+	return retval;
+}
+
+/** Update the online canvas if enough raw events have been processed since the last update.
+  * \param[in]  count_ The number of raw events which were processed since the last call.
+  * \return Nothing.
+  */
+void simpleScanner::CheckOnlineUpdate(const int &count_/*=1*/){
+	if(!online_mode){ return; }
+	
+	if(events_since_last_update >= events_between_updates){
+		std::lock_guard<std::mutex> lock(extTree::GetOutputLock());
+		online->Refresh();
+		events_since_last_update = 0;
+	}
+	else{ events_since_last_update += count_; }
+}
 
-	// Check for the need to update the online canvas.
-	if(online_mode){
-		if(events_since_last_update >= events_between_updates){
-			online->Refresh();
-			events_since_last_update = 0;
+/** Get the name used to identify the current input file in the trace analysis cache.
+  * \return The input filename if it is available (from the file information or the memory-mapped input), or the run number, or the output filename.
+  */
+std::string simpleScanner::GetCacheRunName(){
+	std::string runName;
+
+	// Files scanned with the memory-mapped reader are identified by their filename.
+	if(!mmap_input.empty())
+		runName = mmap_input.substr(mmap_input.find_last_of('/')+1);
+
+	fileInformation *finfo = (runName.empty() ? GetFileInfo() : NULL);
+	std::string name, value;
+	for(size_t index = 0; finfo && index < finfo->size(); index++){
+		finfo->at(index, name, value);
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+		if(name.find("file") != std::string::npos && !value.empty()){
+			runName = value.substr(value.find_last_of('/')+1);
+			break;
 		}
-		else{ events_since_last_update++; }
+		else if(name.find("run") != std::string::npos && name.find("number") != std::string::npos && !value.empty())
+			runName = "run" + value;
 	}
-	
-	return retval;
+
+	// Use the output filename as a last resort. Cache files then depend on the output filename.
+	if(runName.empty()){
+		std::stringstream stream;
+		std::string outputName = GetOutputFilename();
+		stream << outputName.substr(outputName.find_last_of('/')+1) << "_file" << loaded_files;
+		runName = stream.str();
+	}
+
+	// Remove characters which are not allowed in filenames.
+	for(std::string::iterator iter = runName.begin(); iter != runName.end(); iter++){
+		if((*iter) == ' ' || (*iter) == '/') (*iter) = '_';
+	}
+
+	return runName;
 }
 
-/** Write pixie events in the raw event to the output presort file.
+/** Reserve space at the end of the presort spill buffer.
+  * \param[in]  size_ The number of bytes to reserve.
+  * \return Pointer to the start of the reserved space. The spill buffer length is not changed.
+  */
+char *simpleScanner::ReserveSpillBuffer(const size_t &size_){
+	if(spillBufferUsed + size_ > spillBuffer.size())
+		spillBuffer.resize(std::max(2*spillBuffer.size(), spillBufferUsed + size_));
+	return &spillBuffer[spillBufferUsed];
+}
+
+/** Write a pixie event to a buffer keeping only a region of interest of its trace. The offset of the region and
+  * the baseline of the trace are stored in two extra header words, in place of the external timestamp words.
+  * Events which already have an external timestamp are written with their full trace.
+  * \param[in]  event_  The channel event to write.
+  * \param[out] ptr_    Buffer to write the event to.
+  * \param[in]  offset_ Index of the first sample of the region.
+  * \param[in]  length_ Number of samples in the region.
+  * \return The number of bytes written to the buffer.
+  */
+int simpleScanner::WriteEventROI(ChanEvent *event_, char *ptr_, const size_t &offset_, const size_t &length_){
+	unsigned short *fullTrace = event_->adcTrace;
+	size_t fullLength = event_->traceLength;
+
+	event_->adcTrace = fullTrace + offset_;
+	event_->traceLength = length_;
+	int numBytesWritten = event_->writeEvent(NULL, ptr_, true);
+	event_->adcTrace = fullTrace;
+	event_->traceLength = fullLength;
+
+	if(numBytesWritten < 16){ return numBytesWritten; }
+
+	// The region of interest words can only be stored if the external timestamp words are unused.
+	// Otherwise, write the full trace.
+	unsigned int word0;
+	memcpy((char *)&word0, ptr_, 4);
+	unsigned int headerLength = (word0 & 0x0001F000) >> 12;
+	unsigned int eventLength = (word0 & 0x7FFE0000) >> 17;
+	if(headerLength != 4 && headerLength != 8 && headerLength != 12 && headerLength != 16){
+		return event_->writeEvent(NULL, ptr_, true);
+	}
+
+	// Insert the two region of interest words after the header and update the header and event lengths.
+	memmove(ptr_ + 4*headerLength + 8, ptr_ + 4*headerLength, numBytesWritten - 4*headerLength);
+
+	unsigned int roiWord = roiHeaderTag | (unsigned int)(offset_ & 0xFFFF);
+	memcpy(ptr_ + 4*headerLength, (char *)&roiWord, 4);
+	memcpy(ptr_ + 4*headerLength + 4, (char *)&event_->baseline, 4);
+
+	word0 = (word0 & ~0x7FFFF000) | ((headerLength + 2) << 12) | ((eventLength + 2) << 17);
+	memcpy(ptr_, (char *)&word0, 4);
+
+	return numBytesWritten + 8;
+}
+
+/** Write pixie events in the raw event to the output presort file. The spill is assembled in
+  * memory and passed to the spill writer once its length is known.
   * \param[in]  forceWrite Close the raw event spill even if the threshold has not been reached.
   */
 void simpleScanner::HandlePresortOutput(bool forceWrite/*=false*/){
 	// This is a new raw event spill.
 	if(currSpillLength == 0){
-		// The 1-word DATA identifier.
-		psort_file.write((char *)&dataHeaderWord, 4);
-		
-		// This is where we would write the length of the raw event "spill".
-		// Since we don't currently know how long it will be we will use a placeholder for now.
-		// We will save the index so we may overwrite it with the correct value later.
-		spillLengthIndex = psort_file.tellp();
-		
-		// Write a 0xFFFFFFFF as a placeholder.
-		psort_file.write((char *)&endBufferWord, 4);
+		// The 1-word DATA identifier followed by a placeholder for the length of the spill.
+		// The length is filled in when the spill is closed.
+		char *ptr = ReserveSpillBuffer(8);
+		memcpy(ptr, (char *)&dataHeaderWord, 4);
+		memcpy(ptr+4, (char *)&endBufferWord, 4);
+		spillBufferUsed = 8;
+		presortSpill = SpillEntry();
 		
 		// Update the current length of our raw event spill.
 		// We will need to subtract these two words later, but we
@@ -1048,23 +2212,42 @@ void simpleScanner::HandlePresortOutput(bool forceWrite/*=false*/){
 		currSpillLength += 2; 
 	}
 
-	// If there are events in the raw event, write it to the file.
+	// If there are events in the raw event, write it to the buffer.
 	if(!chanEventList.empty()){
 		// Write the event data.
 		for(std::deque<ChannelEventPair*>::iterator iter = chanEventList.begin(); iter != chanEventList.end(); ++iter){ 
-			// Write each event to the presort file.
-			int numBytesWritten = (*iter)->channelEvent->writeEvent(&psort_file, NULL, (*iter)->entry->hasTag("recordTrace"));
+			size_t roiOffset, roiLength;
+			bool writeROI = ((*iter)->entry->hasTag("recordTrace") && (*iter)->entry->getROI((*iter)->channelEvent, roiOffset, roiLength));
+
+			// Reserve enough space for the event header (at most 16 words), the two region of interest words, and the trace.
+			char *ptr = ReserveSpillBuffer((writeROI ? 72 : 64) + 2*(*iter)->channelEvent->traceLength);
+
+			// Write each event to the spill buffer.
+			int numBytesWritten;
+			if(writeROI)
+				numBytesWritten = WriteEventROI((*iter)->channelEvent, ptr, roiOffset, roiLength);
+			else
+				numBytesWritten = (*iter)->channelEvent->writeEvent(NULL, ptr, (*iter)->entry->hasTag("recordTrace"));
 
 			if(numBytesWritten % 4 != 0)
 				std::cout << msgHeader << "Warning! Number of bytes written to presort file not divisible by 4!\n";
 
 			// Add the length of the event.
-			if(numBytesWritten >= 0)
+			if(numBytesWritten >= 0){
+				spillBufferUsed += numBytesWritten;
 				currSpillLength += numBytesWritten/4;
+			}
+
+			// Keep track of the number of events and the time range of the spill for the index.
+			double eventTime = (*iter)->channelEvent->eventTimeLo + ((*iter)->channelEvent->eventTimeHi & 0x0000FFFF) * 4294967296.0;
+			if(presortSpill.firstTime < 0 || eventTime < presortSpill.firstTime){ presortSpill.firstTime = eventTime; }
+			if(presortSpill.lastTime < 0 || eventTime > presortSpill.lastTime){ presortSpill.lastTime = eventTime; }
+			presortSpill.numEvents++;
 		}
 
 		// Close the raw event with a delimiter.
-		psort_file.write((char *)&endBufferWord, 4);
+		memcpy(ReserveSpillBuffer(4), (char *)&endBufferWord, 4);
+		spillBufferUsed += 4;
 	
 		// Account for the delimiter.
 		currSpillLength++;
@@ -1073,19 +2256,25 @@ void simpleScanner::HandlePresortOutput(bool forceWrite/*=false*/){
 	// Check if we have enough data to close the spill.
 	if(currSpillLength >= spillThreshold + 2 || forceWrite){
 		// Close the spill with a delimiter.
-		psort_file.write((char *)&endBufferWord, 4);
+		memcpy(ReserveSpillBuffer(4), (char *)&endBufferWord, 4);
+		spillBufferUsed += 4;
 
 		// Remove the length of the header from the spill length.
 		currSpillLength = currSpillLength - 2;
 		
-		// Overwrite the 1-word raw event spill length in 4-byte words.
-		psort_file.seekp(spillLengthIndex, std::ios::beg);
-		psort_file.write((char *)&currSpillLength, 4);
-		psort_file.seekp(0, std::ios::end);
+		// Fill in the 1-word raw event spill length in 4-byte words and write the whole spill.
+		memcpy(&spillBuffer[4], (char *)&currSpillLength, 4);
+		presortSpill.offset = spill_writer->Write(&spillBuffer[0], spillBufferUsed);
+		spillBufferUsed = 0;
 
 		// Keep track of the maximum raw event length. Required for later scanning.
 		if(currSpillLength > maxSpillLength)
 			maxSpillLength = currSpillLength;
+
+		// Add the spill to the index.
+		presortSpill.length = currSpillLength;
+		if(presortIndex.empty()) presortIndex.SetHeaderLength(presortSpill.offset);
+		presortIndex.Add(presortSpill);
 	
 		// Reset the spill length.
 		currSpillLength = 0;
@@ -1111,8 +2300,12 @@ int main(int argc, char *argv[]){
 	if(!scanner.Setup(argc, argv))
 		return 1;
 
-	// Run the main loop.
-	int retval = scanner.Execute();
+	// Run the main loop (or scan a presort file with the memory-mapped reader).
+	int retval;
+	if(scanner.GetMmapInput().empty())
+		retval = scanner.Execute();
+	else
+		retval = (scanner.ScanPresortFile(scanner.GetMmapInput()) ? 0 : 1);
 	
 	scanner.Close();
 
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "SkimStream.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// class SkimStream
+///////////////////////////////////////////////////////////////////////////////
+
+/** Default constructor.
+  * \param[in]  config_ Name, branch list, and filter of the skim.
+  * \param[in]  file_   The open output file of the skim. The skim takes ownership of the file.
+  */
+SkimStream::SkimStream(const SkimConfig &config_, TFile *file_) : config(config_), file(file_), tree(NULL), numBranches(0), numFilled(0) {
+	if(file){
+		filename = file->GetName();
+		file->cd();
+		tree = new TTree("data", ("Pixie data (" + config.name + " skim)").c_str());
+	}
+}
+
+/// Destructor. Closes the output file.
+SkimStream::~SkimStream(){
+	Close();
+}
+
+/** Add the data structure of a processor. The structure is branched to the output tree if its type
+  * is in the branch list of the skim, and it may always be used in the filter expression.
+  * \param[in]  name_       Name of the structure (i.e. the processor type).
+  * \param[in]  object_     Pointer to the structure. Must remain valid until Close() is called.
+  * \param[in]  splitLevel_ Split level of the branch.
+  * \return True if the structure was added successfully and false otherwise.
+  */
+bool SkimStream::AddStructure(const std::string &name_, TObject *object_, const int &splitLevel_/*=99*/){
+	if(!tree || !object_) return false;
+
+	// Every structure may be used by the filter, even those which are not written.
+	bool retval = filter.AddStructure(name_, object_);
+	structures.push_back(name_);
+
+	if(config.HasBranch(name_)){
+		if(!tree->Branch(name_.c_str(), object_, 32000, splitLevel_)) return false;
+		numBranches++;
+	}
+
+	return retval;
+}
+
+/** Compile the filter expression of the skim. Must be called after all structures are added.
+  * Prints a warning for each type in the branch list which does not match any structure.
+  * \return True if the filter was compiled successfully and false otherwise.
+  */
+bool SkimStream::Compile(){
+	for(std::vector<std::string>::iterator iter = config.branches.begin(); iter != config.branches.end(); iter++){
+		if((*iter) == "*" || std::find(structures.begin(), structures.end(), (*iter)) != structures.end()) continue;
+		std::cout << "SkimStream: \033[1;33mWARNING! Type \"" << (*iter) << "\" of skim '" << config.name << "' does not match any processor and will not be written.\033[0m\n";
+	}
+
+	if(config.filter.empty()) return true;
+	return filter.Compile(config.filter);
+}
+
+/** Fill the output tree if the current event passes the filter of the skim.
+  * \return True if the event was written and false otherwise.
+  */
+bool SkimStream::Fill(){
+	if(!tree || !filter.Accept()) return false;
+	tree->Fill();
+	numFilled++;
+	return true;
+}
+
+/// Write the output tree and close the output file.
+void SkimStream::Close(){
+	if(!file) return;
+
+	file->cd();
+	if(tree) tree->Write();
+	file->Close();
+
+	delete file;
+	file = NULL;
+	tree = NULL;
+}
@@ -0,0 +1,264 @@
+#include <iostream>
+#include <iomanip>
+
+// Local files
+#include "SpillIndex.hpp"
+
+const unsigned int fileFooterWord = 0x20464f45; // "EOF "
+const unsigned int fileHeaderWord = 0x44414548; // "HEAD"
+const unsigned int dataHeaderWord = 0x41544144; // "DATA"
+const unsigned int endBufferWord = 0xFFFFFFFF;
+const unsigned int indexHeaderWord = 0x58444e49; // "INDX"
+const unsigned int roiHeaderTag = 0x524F0000; // "RO"
+
+const unsigned int indexVersion = 1; // Version of the spill index footer.
+const unsigned int indexRecordSize = 32; // Size of a single spill record in the footer (in bytes).
+
+const unsigned int endSpillVsn = 9999; // Module number of the end of spill marker.
+
+/** Search the start of the file for the first DATA spill. A candidate is accepted
+  * only if it is followed directly by another DATA spill or by the end of the file.
+  * \param[in]  file_ Input file stream.
+  * \return True if the first spill was found and false otherwise.
+  */
+bool SpillIndex::FindFirstSpill(std::ifstream &file_){
+	unsigned int word;
+	unsigned int length;
+	unsigned long long position = 4; // Skip the HEAD word.
+	while(position + 8 <= fileLength){
+		file_.seekg(position);
+		file_.read((char*)&word, 4);
+		if(word == dataHeaderWord){
+			file_.read((char*)&length, 4);
+			unsigned long long next = position + 4*((unsigned long long)length + 2);
+			if(next == fileLength){
+				headerLength = position;
+				return true;
+			}
+			else if(next + 4 <= fileLength){
+				file_.seekg(next);
+				file_.read((char*)&word, 4);
+				if(word == dataHeaderWord || word == fileFooterWord){
+					headerLength = position;
+					return true;
+				}
+			}
+		}
+		position += 4;
+	}
+	return false;
+}
+
+/** Read the spill index from the footer of a presorted pld file.
+  * \param[in]  file_ Input file stream.
+  * \return True if a valid footer index was found and false otherwise.
+  */
+bool SpillIndex::ReadFooter(std::ifstream &file_){
+	if(fileLength < 32) return false;
+
+	// The last 12 bytes of the file hold the offset of the footer and the INDX word.
+	unsigned long long footerOffset;
+	unsigned int word;
+	file_.seekg(fileLength - 12);
+	file_.read((char*)&footerOffset, 8);
+	file_.read((char*)&word, 4);
+	if(!file_.good() || word != indexHeaderWord || footerOffset + 32 > fileLength) return false;
+
+	unsigned int version, numSpills;
+	file_.seekg(footerOffset);
+	file_.read((char*)&word, 4);
+	file_.read((char*)&version, 4);
+	file_.read((char*)&numSpills, 4);
+	file_.read((char*)&headerLength, 8);
+	if(!file_.good() || word != indexHeaderWord || version != indexVersion) return false;
+	if(footerOffset + 20 + (unsigned long long)indexRecordSize*numSpills + 12 != fileLength) return false;
+
+	spills.resize(numSpills);
+	for(std::vector<SpillEntry>::iterator iter = spills.begin(); iter != spills.end(); ++iter){
+		file_.read((char*)&iter->offset, 8);
+		file_.read((char*)&iter->length, 4);
+		file_.read((char*)&iter->numEvents, 4);
+		file_.read((char*)&iter->firstTime, 8);
+		file_.read((char*)&iter->lastTime, 8);
+	}
+	if(!file_.good()){
+		spills.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/// Default constructor.
+SpillIndex::SpillIndex() : headerLength(0), fileLength(0), init(false) { }
+
+/** Build the spill index of a pld (or presorted pld) file. If the file ends with a spill index
+  * footer, the index is read from the footer. Otherwise, all DATA spills in the file are walked.
+  * \param[in]  filename_   Path to the input file.
+  * \param[in]  parseTimes_ Decode the pixie event headers in each spill to find the event count and time range.
+  * \param[in]  useFooter_  Read the index from the footer of the file, if present.
+  * \return True if at least one spill was found and false otherwise.
+  */
+bool SpillIndex::Build(const char *filename_, const bool &parseTimes_/*=true*/, const bool &useFooter_/*=true*/){
+	Clear();
+
+	std::ifstream file(filename_, std::ios::binary);
+	if(!file.good()){
+		std::cout << " SpillIndex: Error! Failed to open input file \"" << filename_ << "\".\n";
+		return false;
+	}
+
+	file.seekg(0, std::ios::end);
+	fileLength = file.tellg();
+	file.seekg(0);
+
+	unsigned int word;
+	file.read((char*)&word, 4);
+	if(word != fileHeaderWord){
+		std::cout << " SpillIndex: Error! Input file \"" << filename_ << "\" is not a pld file.\n";
+		return false;
+	}
+
+	// Use the index stored in the footer of the file, if there is one.
+	if(useFooter_ && ReadFooter(file)) return (init = !spills.empty());
+	file.clear();
+
+	if(!FindFirstSpill(file)){
+		std::cout << " SpillIndex: Error! Failed to find the first spill in \"" << filename_ << "\".\n";
+		return false;
+	}
+
+	std::vector<unsigned int> buffer;
+	unsigned int length;
+	unsigned long long position = headerLength;
+	while(position + 8 <= fileLength){
+		file.seekg(position);
+		file.read((char*)&word, 4);
+		if(word == fileFooterWord){ break; }
+		else if(word != dataHeaderWord){
+			std::cout << " SpillIndex: Warning! Encountered unexpected word (0x" << std::hex << word << std::dec << ") at offset " << position << ".\n";
+			break;
+		}
+
+		file.read((char*)&length, 4);
+		SpillEntry entry(position, length);
+		if(position + entry.GetSize() > fileLength){
+			std::cout << " SpillIndex: Warning! Spill at offset " << position << " is truncated.\n";
+			break;
+		}
+
+		if(parseTimes_){
+			buffer.resize(length);
+			file.read((char*)buffer.data(), 4*(unsigned long long)length);
+			ParseSpill(buffer.data(), length, entry);
+		}
+
+		spills.push_back(entry);
+		position += entry.GetSize();
+	}
+
+	return (init = !spills.empty());
+}
+
+/** Write the index as a footer following the EOF words of a presorted pld file. Readers which
+  * stop at the EOF words are unaffected. The footer is laid out as
+  *  INDX, version, number of spills, header length (8 B), one 32 B record per spill, footer offset (8 B), INDX
+  * where each record holds the offset (8 B), length (4 B), event count (4 B), and first and last time (8 B each).
+  * \param[in]  file_ Output file stream, positioned directly after the EOF words.
+  * \return True if the footer was written successfully and false otherwise.
+  */
+bool SpillIndex::WriteFooter(std::ostream *file_) const {
+	unsigned long long footerOffset = file_->tellp();
+	unsigned int numSpills = spills.size();
+
+	file_->write((char*)&indexHeaderWord, 4);
+	file_->write((char*)&indexVersion, 4);
+	file_->write((char*)&numSpills, 4);
+	file_->write((char*)&headerLength, 8);
+	for(std::vector<SpillEntry>::const_iterator iter = spills.begin(); iter != spills.end(); ++iter){
+		file_->write((char*)&iter->offset, 8);
+		file_->write((char*)&iter->length, 4);
+		file_->write((char*)&iter->numEvents, 4);
+		file_->write((char*)&iter->firstTime, 8);
+		file_->write((char*)&iter->lastTime, 8);
+	}
+	file_->write((char*)&footerOffset, 8);
+	file_->write((char*)&indexHeaderWord, 4);
+
+	return file_->good();
+}
+
+/** Find the number of pixie events and the time range of a spill of raw pixie module data.
+  * \param[in]  data_   Pointer to the first word of the spill (after the length word).
+  * \param[in]  nWords_ Length of the spill in 4-byte words.
+  * \param[out] entry_  Spill entry to update.
+  * \return The number of events found in the spill.
+  */
+unsigned int SpillIndex::ParseSpill(unsigned int *data_, const unsigned int &nWords_, SpillEntry &entry_){
+	entry_.numEvents = 0;
+	entry_.firstTime = -1;
+	entry_.lastTime = -1;
+
+	unsigned int position = 0;
+	while(position + 2 <= nWords_){
+		// Skip delimiter words between module buffers.
+		if(data_[position] == endBufferWord){
+			position++;
+			continue;
+		}
+
+		unsigned int bufferLength = data_[position];
+		unsigned int vsn = data_[position+1];
+		if(bufferLength < 2 || vsn == endSpillVsn || position + bufferLength > nWords_){ break; }
+
+		// Walk the pixie event headers in this module buffer.
+		unsigned int eventPosition = position + 2;
+		while(eventPosition + 3 <= position + bufferLength){
+			unsigned int eventLength = (data_[eventPosition] & 0x7FFE0000) >> 17;
+			if(eventLength < 4){ break; }
+
+			double eventTime = data_[eventPosition+1] + (data_[eventPosition+2] & 0x0000FFFF) * 4294967296.0;
+			if(entry_.firstTime < 0 || eventTime < entry_.firstTime){ entry_.firstTime = eventTime; }
+			if(entry_.lastTime < 0 || eventTime > entry_.lastTime){ entry_.lastTime = eventTime; }
+
+			entry_.numEvents++;
+			eventPosition += eventLength;
+		}
+
+		position += bufferLength;
+	}
+
+	return entry_.numEvents;
+}
+
+/// Remove all entries from the index.
+void SpillIndex::Clear(){
+	spills.clear();
+	headerLength = 0;
+	fileLength = 0;
+	init = false;
+}
+
+/** Find the first spill which may contain events at or after a given time.
+  * \param[in]  time_ Pixie clock time to search for.
+  * \return The index of the spill or size() if no such spill exists.
+  */
+size_t SpillIndex::FindSpill(const double &time_) const {
+	for(size_t i = 0; i < spills.size(); i++){
+		if(spills.at(i).HasTime() && spills.at(i).lastTime >= time_){ return i; }
+	}
+	return spills.size();
+}
+
+/// Print the index to the screen.
+void SpillIndex::Print() const {
+	std::cout << " Header length = " << headerLength << " B, file length = " << fileLength << " B, " << spills.size() << " spills\n";
+	std::cout << "  spill\toffset\tlength\tevents\tfirstTime\tlastTime\n";
+	for(size_t i = 0; i < spills.size(); i++){
+		const SpillEntry *entry = &spills.at(i);
+		std::cout << "  " << i << "\t" << entry->offset << "\t" << entry->length << "\t" << entry->numEvents << "\t";
+		std::cout << std::fixed << std::setprecision(0) << entry->firstTime << "\t" << entry->lastTime << std::endl;
+		std::cout.unsetf(std::ios::fixed);
+		std::cout << std::setprecision(6);
+	}
+}
@@ -0,0 +1,100 @@
+// Local files
+#include "SpillWriter.hpp"
+
+/// Main loop of the background thread.
+void SpillWriter::Run(){
+	std::unique_lock<std::mutex> lock(writeMutex);
+	while(true){
+		while(!busy && !stopping)
+			dataReady.wait(lock);
+		if(!busy){ break; } // Stopping with nothing left to write.
+
+		// The scan thread does not touch the write buffer while busy is set.
+		lock.unlock();
+		file->write(writing.data(), writing.size());
+		writing.clear();
+		lock.lock();
+
+		numWrites++;
+		busy = false;
+		writeDone.notify_all();
+	}
+}
+
+/// Write all pending spills to file (or pass them to the background thread).
+void SpillWriter::WritePending(){
+	if(pending.empty()) return;
+
+	if(!async){
+		file->write(pending.data(), pending.size());
+		pending.clear();
+		numWrites++;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(writeMutex);
+	while(busy)
+		writeDone.wait(lock);
+	writing.swap(pending);
+	busy = true;
+	dataReady.notify_one();
+}
+
+/** Default constructor.
+  * \param[in]  file_      Pointer to the output file stream.
+  * \param[in]  flushSize_ The number of bytes of completed spills to collect before writing them to file.
+  * \param[in]  async_     Write spills to file on a background thread.
+  */
+SpillWriter::SpillWriter(std::ofstream *file_, const size_t &flushSize_/*=1048576*/, const bool &async_/*=false*/){
+	file = file_;
+	flushSize = flushSize_;
+	position = (file->good() ? (unsigned long long)file->tellp() : 0);
+	numWrites = 0;
+	async = async_;
+	busy = false;
+	stopping = false;
+	pending.reserve(flushSize);
+	if(async) writerThread = std::thread(&SpillWriter::Run, this);
+}
+
+/// Destructor. Writes all pending spills and stops the background thread.
+SpillWriter::~SpillWriter(){
+	Flush();
+	if(async){
+		{
+			std::unique_lock<std::mutex> lock(writeMutex);
+			stopping = true;
+		}
+		dataReady.notify_one();
+		writerThread.join();
+	}
+}
+
+/** Add a complete spill to the output. The spill is copied, so the caller may reuse its buffer.
+  * \param[in]  data_   Pointer to the start of the spill (including the DATA word and the length word).
+  * \param[in]  length_ Length of the spill (in bytes).
+  * \return The file position of the start of the spill (in bytes).
+  */
+unsigned long long SpillWriter::Write(const char *data_, const size_t &length_){
+	unsigned long long start = position;
+	pending.insert(pending.end(), data_, data_ + length_);
+	position += length_;
+	if(pending.size() >= flushSize) WritePending();
+	return start;
+}
+
+/// Write all pending spills and wait until they are on file. Must be called before writing to the file directly.
+void SpillWriter::Flush(){
+	WritePending();
+	if(async){
+		std::unique_lock<std::mutex> lock(writeMutex);
+		while(busy)
+			writeDone.wait(lock);
+	}
+}
+
+/// Flush all pending spills and set the current position from the file. Must be called after writing to the file directly.
+void SpillWriter::Sync(){
+	Flush();
+	position = (file->good() ? (unsigned long long)file->tellp() : 0);
+}
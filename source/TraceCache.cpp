@@ -0,0 +1,178 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+
+// Local files
+#include "TraceCache.hpp"
+
+const unsigned int cacheHeaderWord = 0x43435254; // "TRCC"
+
+const unsigned int cacheVersion = 2; // Version of the cache file format.
+
+/** Open the cache of a channel for the current run. If a cache file exists and was written with the same
+  * analysis parameters, it is opened for reading. Otherwise, a new cache file is started.
+  * \param[in]  chanID_ Channel ID (16*mod+chan).
+  * \param[in]  hash_   Hash of the analysis parameters of the channel.
+  * \return Pointer to the cache state of the channel.
+  */
+CacheChannel *TraceCache::OpenChannel(const unsigned int &chanID_, const unsigned long long &hash_){
+	CacheChannel *channel = new CacheChannel();
+	channels[chanID_] = channel;
+
+	std::stringstream stream;
+	stream << directory << "/" << run << "_m" << chanID_/16 << "c" << chanID_%16 << ".tcache";
+	channel->filename = stream.str();
+	channel->hash = hash_;
+
+	// The header holds the file identifier, the version, the channel ID, and the parameter hash.
+	unsigned int header[3];
+	unsigned long long fileHash = 0;
+	channel->input.open(channel->filename.c_str(), std::ios::binary);
+	if(channel->input.good()){
+		channel->input.read((char*)header, 12);
+		channel->input.read((char*)&fileHash, 8);
+		if(channel->input.good() && header[0] == cacheHeaderWord && header[1] == cacheVersion && header[2] == chanID_ && fileHash == hash_){
+			channel->mode = CacheChannel::READ;
+			numReused++;
+			return channel;
+		}
+		channel->input.close();
+	}
+
+	// Write the results to a temporary file which replaces the old cache file when the run is closed.
+	channel->mode = CacheChannel::WRITE;
+	channel->output.open((channel->filename + ".tmp").c_str(), std::ios::binary);
+	if(!channel->output.good()){
+		std::cout << " TraceCache: Warning! Failed to open cache file \"" << channel->filename << ".tmp\".\n";
+		channel->mode = CacheChannel::STALE;
+		return channel;
+	}
+
+	header[0] = cacheHeaderWord;
+	header[1] = cacheVersion;
+	header[2] = chanID_;
+	channel->output.write((char*)header, 12);
+	channel->output.write((char*)&hash_, 8);
+	numRecomputed++;
+
+	return channel;
+}
+
+/** Default constructor.
+  * \param[in]  directory_ Directory containing the cache files.
+  */
+TraceCache::TraceCache(const std::string &directory_) : directory(directory_), run("run"), numRead(0), numWritten(0), numReused(0), numRecomputed(0), numStale(0) { }
+
+/// Destructor. Closes the cache files of the current run.
+TraceCache::~TraceCache(){
+	Close();
+}
+
+/** Set the name of the current run. The cache files of the previous run are closed.
+  * \param[in]  run_ Name of the run (used as a prefix for all cache files).
+  * \return Nothing.
+  */
+void TraceCache::SetRun(const std::string &run_){
+	Close();
+	run = run_;
+}
+
+/** Read the trace analysis results of the next hit of a channel from the cache.
+  * \param[in]  chanID_ Channel ID (16*mod+chan).
+  * \param[in]  hash_   Hash of the analysis parameters of the channel.
+  * \param[out] event_  The channel event to update.
+  * \return True if the results were read from the cache and false if they must be computed.
+  */
+bool TraceCache::Read(const unsigned int &chanID_, const unsigned long long &hash_, ChanEvent *event_){
+	std::map<unsigned int, CacheChannel*>::iterator iter = channels.find(chanID_);
+	CacheChannel *channel = (iter != channels.end() ? iter->second : OpenChannel(chanID_, hash_));
+	if(channel->mode != CacheChannel::READ){ return false; }
+
+	// Check that the cached hit is the same as the current hit.
+	CacheRecord record;
+	channel->input.read((char*)&record, sizeof(CacheRecord));
+	if(!channel->input.good() || record.time != event_->time){
+		std::cout << " TraceCache: Warning! Cache file \"" << channel->filename << "\" does not match the input data. Recomputing.\n";
+		channel->input.close();
+		channel->mode = CacheChannel::STALE;
+		numStale++;
+		return false;
+	}
+
+	event_->baseline = record.baseline;
+	event_->phase = record.phase;
+	event_->qdc = record.qdc;
+	event_->qdc2 = record.qdc2;
+	event_->stddev = record.stddev;
+	event_->maximum = record.maximum;
+	event_->max_index = record.max_index;
+	event_->max_ADC = record.max_ADC;
+	event_->valid_chan = (record.valid != 0);
+	numRead++;
+
+	return true;
+}
+
+/** Store the trace analysis results of a hit. Results are only stored for channels which are
+  * not being read from the cache.
+  * \param[in]  chanID_ Channel ID (16*mod+chan).
+  * \param[in]  event_  The analyzed channel event.
+  * \return Nothing.
+  */
+void TraceCache::Write(const unsigned int &chanID_, ChanEvent *event_){
+	std::map<unsigned int, CacheChannel*>::iterator iter = channels.find(chanID_);
+	if(iter == channels.end() || iter->second->mode != CacheChannel::WRITE){ return; }
+
+	CacheRecord record;
+	record.time = event_->time;
+	record.baseline = event_->baseline;
+	record.phase = event_->phase;
+	record.qdc = event_->qdc;
+	record.qdc2 = event_->qdc2;
+	record.stddev = event_->stddev;
+	record.maximum = event_->maximum;
+	record.max_index = (unsigned int)event_->max_index;
+	record.max_ADC = event_->max_ADC;
+	record.valid = (event_->valid_chan ? 1 : 0);
+	iter->second->output.write((char*)&record, sizeof(CacheRecord));
+	numWritten++;
+}
+
+/// Close all cache files of the current run. New cache files replace the old ones and stale cache files are removed.
+void TraceCache::Close(){
+	for(std::map<unsigned int, CacheChannel*>::iterator iter = channels.begin(); iter != channels.end(); iter++){
+		CacheChannel *channel = iter->second;
+		if(channel->mode == CacheChannel::WRITE){
+			channel->output.close();
+			if(rename((channel->filename + ".tmp").c_str(), channel->filename.c_str()) != 0)
+				std::cout << " TraceCache: Warning! Failed to write cache file \"" << channel->filename << "\".\n";
+		}
+		else if(channel->mode == CacheChannel::STALE){
+			channel->output.close();
+			remove((channel->filename + ".tmp").c_str());
+			remove(channel->filename.c_str());
+		}
+		delete channel;
+	}
+	channels.clear();
+}
+
+/// Print statistics about cache usage.
+void TraceCache::Print() const {
+	std::cout << " TraceCache: Reused " << numReused << " channel(s) (" << numRead << " hits), recomputed " << numRecomputed << " channel(s) (" << numWritten << " hits)";
+	if(numStale > 0) std::cout << ", " << numStale << " stale channel(s)";
+	std::cout << ".\n";
+}
+
+/** Compute the 64-bit FNV-1a hash of a string.
+  * \param[in]  str_ The string to hash.
+  * \return The hash of the string.
+  */
+unsigned long long TraceCache::Hash(const std::string &str_){
+	unsigned long long hash = 14695981039346656037ULL;
+	for(std::string::const_iterator iter = str_.begin(); iter != str_.end(); iter++){
+		hash ^= (unsigned char)(*iter);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
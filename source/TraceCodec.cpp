@@ -0,0 +1,187 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+// Local files
+#include "TraceCodec.hpp"
+
+const unsigned int codecBlockSize = 32; // Number of samples per bit-packed block.
+
+/** Encode a single ADC trace and append it to an output buffer. Each encoded trace is laid out as
+  * channel ID (2 B), number of samples (2 B), first sample (2 B), the full number of samples (4 B, only
+  * if the 2 B field holds 0xFFFF), blocks
+  * where each block of up to 32 samples holds its bit width (1 B) followed by the bit-packed, zigzag
+  * encoded differences between neighboring samples. Baseline regions need only a few bits per sample.
+  * \param[in]  trace_  Pointer to the first ADC sample.
+  * \param[in]  length_ Number of samples in the trace.
+  * \param[in]  chanID_ Channel ID (16*mod+chan).
+  * \param[out] output_ Buffer to append the encoded trace to.
+  * \return The number of bytes appended to the output buffer.
+  */
+size_t TraceCodec::Encode(const unsigned short *trace_, const size_t &length_, const unsigned short &chanID_, std::vector<unsigned char> &output_){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	size_t length = (length_ < 0xFFFFFFFF ? length_ : 0xFFFFFFFF);
+	size_t numBlocks = (length + codecBlockSize - 1) / codecBlockSize;
+
+	// Reserve enough space for the largest possible codes (17 bits) and shrink the buffer afterwards.
+	size_t initialSize = output_.size();
+	output_.resize(initialSize + 10 + numBlocks + (17*length+7)/8 + numBlocks);
+	unsigned char *ptr = output_.data() + initialSize;
+
+	// The header words are written in little endian byte order. Traces of 65535 samples
+	// or more store 0xFFFF as the number of samples followed by the full 4-byte length.
+	unsigned short header[3] = {chanID_, (unsigned short)(length < 0xFFFF ? length : 0xFFFF), (unsigned short)(length > 0 ? trace_[0] : 0)};
+	for(int i = 0; i < 3; i++){
+		*ptr++ = (unsigned char)(header[i] & 0xFF);
+		*ptr++ = (unsigned char)(header[i] >> 8);
+	}
+	if(header[1] == 0xFFFF){
+		for(int i = 0; i < 4; i++)
+			*ptr++ = (unsigned char)((length >> (8*i)) & 0xFF);
+	}
+
+	// Subtract each sample from the one after it and zigzag encode the difference so that small
+	// negative differences also have small codes. Written as a simple loop so that it vectorizes.
+	if(residuals.size() < length) residuals.resize(length);
+	int *res = residuals.data();
+	if(length > 0) res[0] = 0;
+	for(size_t i = 1; i < length; i++){
+		int diff = (int)trace_[i] - (int)trace_[i-1];
+		res[i] = (diff << 1) ^ (diff >> 31);
+	}
+
+	for(size_t blockStart = 0; blockStart < length; blockStart += codecBlockSize){
+		size_t blockLength = (length - blockStart < codecBlockSize ? length - blockStart : codecBlockSize);
+
+		// Find the number of bits needed for the largest code in the block.
+		unsigned int mask = 0;
+		for(size_t i = 0; i < blockLength; i++)
+			mask |= (unsigned int)res[blockStart+i];
+		unsigned char bits = 0;
+		while(mask >> bits) bits++;
+		*ptr++ = bits;
+
+		// Pack the codes, least significant bit first.
+		unsigned long long buffer = 0;
+		unsigned int bufferBits = 0;
+		for(size_t i = 0; i < blockLength; i++){
+			buffer |= (unsigned long long)res[blockStart+i] << bufferBits;
+			bufferBits += bits;
+			while(bufferBits >= 8){
+				*ptr++ = (unsigned char)(buffer & 0xFF);
+				buffer >>= 8;
+				bufferBits -= 8;
+			}
+		}
+		if(bufferBits > 0) *ptr++ = (unsigned char)(buffer & 0xFF);
+	}
+
+	output_.resize(ptr - output_.data());
+
+	size_t numBytes = output_.size() - initialSize;
+
+	TraceCodecStats &chanStats = stats[chanID_];
+	chanStats.numTraces++;
+	chanStats.rawBytes += 2*length;
+	chanStats.packedBytes += numBytes;
+	chanStats.encodeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return numBytes;
+}
+
+/** Decode a single encoded trace.
+  * \param[in]  data_   Pointer to the start of the encoded trace.
+  * \param[in]  size_   Number of bytes available.
+  * \param[out] output_ Vector to append the decoded samples to.
+  * \param[out] chanID_ Channel ID of the trace (optional).
+  * \return The number of bytes read or 0 if the trace is invalid.
+  */
+size_t TraceCodec::Decode(const unsigned char *data_, const size_t &size_, std::vector<unsigned short> &output_, unsigned short *chanID_/*=NULL*/){
+	if(size_ < 6){ return 0; }
+
+	unsigned short header[3];
+	for(int i = 0; i < 3; i++)
+		header[i] = (unsigned short)(data_[2*i] | (data_[2*i+1] << 8));
+	if(chanID_) *chanID_ = header[0];
+
+	size_t length = header[1];
+	int sample = header[2];
+	size_t position = 6;
+
+	// Long traces store the full number of samples after the header words.
+	if(length == 0xFFFF){
+		if(size_ < 10){ return 0; }
+		length = 0;
+		for(int i = 0; i < 4; i++)
+			length |= (size_t)data_[position++] << (8*i);
+	}
+
+	output_.reserve(output_.size() + length);
+	for(size_t blockStart = 0; blockStart < length; blockStart += codecBlockSize){
+		size_t blockLength = (length - blockStart < codecBlockSize ? length - blockStart : codecBlockSize);
+		if(position >= size_){ return 0; }
+
+		unsigned int bits = data_[position++];
+		if(bits > 32 || position + (blockLength*bits+7)/8 > size_){ return 0; }
+
+		unsigned long long buffer = 0;
+		unsigned int bufferBits = 0;
+		unsigned long long mask = (1ULL << bits) - 1;
+		for(size_t i = 0; i < blockLength; i++){
+			while(bufferBits < bits){
+				buffer |= (unsigned long long)data_[position++] << bufferBits;
+				bufferBits += 8;
+			}
+			unsigned int code = (unsigned int)(buffer & mask);
+			buffer >>= bits;
+			bufferBits -= bits;
+
+			// The first code of the trace is always zero.
+			sample += (int)(code >> 1) ^ -(int)(code & 1);
+			output_.push_back((unsigned short)sample);
+		}
+	}
+
+	return position;
+}
+
+/** Decode all traces in a buffer.
+  * \param[in]  data_   Buffer of encoded traces.
+  * \param[out] output_ Vector to append the decoded samples of all traces to.
+  * \return The number of traces decoded.
+  */
+unsigned int TraceCodec::DecodeAll(const std::vector<unsigned char> &data_, std::vector<unsigned short> &output_){
+	unsigned int numTraces = 0;
+	size_t position = 0;
+	while(position < data_.size()){
+		size_t numBytes = Decode(data_.data() + position, data_.size() - position, output_);
+		if(numBytes == 0){
+			std::cout << " TraceCodec: Warning! Invalid encoded trace at byte " << position << ".\n";
+			break;
+		}
+		position += numBytes;
+		numTraces++;
+	}
+	return numTraces;
+}
+
+/// Print the compression ratio and encoding throughput of each channel.
+void TraceCodec::Print() const {
+	TraceCodecStats total;
+	std::cout << "  chanID  traces      raw (MB)    packed (MB) ratio   MB/s\n";
+	for(std::map<unsigned short, TraceCodecStats>::const_iterator iter = stats.begin(); iter != stats.end(); iter++){
+		const TraceCodecStats &chanStats = iter->second;
+		std::cout << "  " << std::setw(6) << iter->first << "  " << std::setw(10) << chanStats.numTraces;
+		std::cout << "  " << std::setw(10) << chanStats.rawBytes / 1048576.0 << "  " << std::setw(10) << chanStats.packedBytes / 1048576.0;
+		std::cout << "  " << std::setw(5) << (chanStats.packedBytes > 0 ? (double)chanStats.rawBytes / chanStats.packedBytes : 0);
+		std::cout << "  " << (chanStats.encodeTime > 0 ? chanStats.rawBytes / 1048576.0 / chanStats.encodeTime : 0) << std::endl;
+		total.numTraces += chanStats.numTraces;
+		total.rawBytes += chanStats.rawBytes;
+		total.packedBytes += chanStats.packedBytes;
+		total.encodeTime += chanStats.encodeTime;
+	}
+	std::cout << "  total   " << std::setw(10) << total.numTraces << "  " << std::setw(10) << total.rawBytes / 1048576.0 << "  " << std::setw(10) << total.packedBytes / 1048576.0;
+	std::cout << "  " << std::setw(5) << (total.packedBytes > 0 ? (double)total.rawBytes / total.packedBytes : 0);
+	std::cout << "  " << (total.encodeTime > 0 ? total.rawBytes / 1048576.0 / total.encodeTime : 0) << std::endl;
+}
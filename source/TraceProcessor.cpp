@@ -20,6 +20,6 @@ bool TraceProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair *chEv
 }
 
 TraceProcessor::TraceProcessor(MapFile *map_) : Processor("Trace", "trace", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 }
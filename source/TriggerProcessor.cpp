@@ -18,7 +18,7 @@ bool TriggerProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair *ch
 }
 
 TriggerProcessor::TriggerProcessor(MapFile *map_) : Processor("Trigger", "trigger", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &waveform;
 }
 
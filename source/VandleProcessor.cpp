@@ -77,7 +77,7 @@ bool VandleProcessor::HandleEvent(ChannelEventPair *chEvt, ChannelEventPair *chE
 }
 
 VandleProcessor::VandleProcessor(MapFile *map_) : Processor("Vandle", "vandle", map_){
-	root_structure = (Structure*)&structure;
+	SetRootStructure(&structure);
 	root_waveform = &L_waveform;
 	
 	// Set the detector type to a bar.
@@ -0,0 +1,169 @@
+#ifndef COLUMNREADER_HPP
+#define COLUMNREADER_HPP
+
+#include <vector>
+#include <map>
+#include <string>
+
+/// Schema type name of a column element type.
+template <class T> struct columnType{ static const char *name(){ return ""; } };
+template <> struct columnType<char>{ static const char *name(){ return "int8"; } };
+template <> struct columnType<unsigned char>{ static const char *name(){ return "uint8"; } };
+template <> struct columnType<bool>{ static const char *name(){ return "bool"; } };
+template <> struct columnType<short>{ static const char *name(){ return "int16"; } };
+template <> struct columnType<unsigned short>{ static const char *name(){ return "uint16"; } };
+template <> struct columnType<int>{ static const char *name(){ return "int32"; } };
+template <> struct columnType<unsigned int>{ static const char *name(){ return "uint32"; } };
+template <> struct columnType<long>{ static const char *name(){ return (sizeof(long) == 8 ? "int64" : "int32"); } };
+template <> struct columnType<unsigned long>{ static const char *name(){ return (sizeof(long) == 8 ? "uint64" : "uint32"); } };
+template <> struct columnType<long long>{ static const char *name(){ return "int64"; } };
+template <> struct columnType<unsigned long long>{ static const char *name(){ return "uint64"; } };
+template <> struct columnType<float>{ static const char *name(){ return "float32"; } };
+template <> struct columnType<double>{ static const char *name(){ return "float64"; } };
+
+class jsonValue{
+  public:
+	enum jsonType {NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT};
+
+	jsonType type;
+	bool boolean;
+	double number;
+	std::string str;
+	std::vector<jsonValue> array;
+	std::map<std::string, jsonValue> object;
+
+	jsonValue() : type(NONE), boolean(false), number(0) { }
+
+	/// Return the member of an object with the specified name or an empty value if it does not exist.
+	const jsonValue &operator [] (const std::string &name_) const;
+
+	/** Parse a JSON document.
+	  * \param[in]  str_ The document to parse.
+	  * \param[out] pos_ Position in the document. Updated to the character following the parsed value.
+	  * \return True if a value was parsed successfully and false otherwise.
+	  */
+	bool parse(const std::string &str_, size_t &pos_);
+};
+
+class columnFile{
+  private:
+	void *ptr; /// Pointer to the start of the memory-mapped file.
+	size_t length; /// Length of the file (in bytes).
+
+	columnFile(const columnFile &); // Not copyable.
+	columnFile &operator = (const columnFile &);
+
+  public:
+	columnFile() : ptr(NULL), length(0) { }
+
+	~columnFile(){ close(); }
+
+	/// Map a file into memory (read-only). Return true if the file was mapped successfully.
+	bool open(const std::string &fname_);
+
+	/// Unmap the file.
+	void close();
+
+	/// Return a pointer to the start of the file.
+	const void *data() const { return ptr; }
+
+	/// Return the length of the file in bytes.
+	size_t size() const { return length; }
+};
+
+class columnField{
+  public:
+	std::string name; /// Name of the structure member.
+	std::string type; /// Schema type of a single element (e.g. "float64").
+	std::string description; /// Description of the structure member.
+	std::string filename; /// Path to the column file.
+	size_t width; /// Size of a single element (in bytes).
+	bool isVector; /// True if the member has one element per vector element, false if it has one element per entry.
+
+	columnFile file; /// The memory-mapped column file.
+
+	columnField() : width(0), isVector(false) { }
+
+	/// Return the number of elements in the column.
+	size_t size() const { return (width > 0 ? file.size() / width : 0); }
+};
+
+class columnStructure{
+  public:
+	std::string name; /// Name of the structure (i.e. the processor type).
+	std::string className; /// Class name of the structure.
+	unsigned long long elements; /// Total number of vector elements.
+
+	std::vector<columnField*> fields; /// List of all columns of the structure.
+
+	columnFile offsets; /// Cumulative multiplicity at the start of each entry (entries+1 values).
+
+	columnStructure() : elements(0) { }
+
+	~columnStructure();
+
+	/// Return the field with the specified name or NULL if it does not exist.
+	columnField *getField(const std::string &name_) const;
+
+	/// Return the index of the first vector element of an entry.
+	unsigned long long begin(const unsigned long long &entry_) const { return ((const unsigned long long*)offsets.data())[entry_]; }
+
+	/// Return one past the index of the last vector element of an entry.
+	unsigned long long end(const unsigned long long &entry_) const { return ((const unsigned long long*)offsets.data())[entry_+1]; }
+
+	/// Return the multiplicity of an entry.
+	unsigned long long getMult(const unsigned long long &entry_) const { return end(entry_) - begin(entry_); }
+};
+
+class columnReader{
+  private:
+	std::string directory; /// Directory containing the column files.
+	unsigned long long entries; /// Total number of entries.
+
+	std::vector<columnStructure*> structures; /// List of all structures.
+
+	/// Return a pointer to the raw data of a column after checking its type.
+	const void *getColumnData(const std::string &structure_, const std::string &field_, const std::string &type_, const size_t &width_, size_t &count_) const;
+
+  public:
+	columnReader() : entries(0) { }
+
+	~columnReader(){ close(); }
+
+	/** Read the schema from a columnar output directory and map all column files into memory.
+	  * \param[in]  directory_ Path to the directory written by simpleScan --columns.
+	  * \return True if all columns were opened successfully and false otherwise.
+	  */
+	bool open(const std::string &directory_);
+
+	/// Unmap all column files.
+	void close();
+
+	/// Return the total number of entries.
+	unsigned long long getEntries() const { return entries; }
+
+	/// Return the number of structures.
+	size_t getNumStructures() const { return structures.size(); }
+
+	/// Return the structure at the specified index.
+	columnStructure *getStructure(const size_t &index_) const { return (index_ < structures.size() ? structures.at(index_) : NULL); }
+
+	/// Return the structure with the specified name or NULL if it does not exist.
+	columnStructure *getStructure(const std::string &name_) const;
+
+	/** Get a pointer to the data of a column without copying.
+	  * \param[in]  structure_ Name of the structure (e.g. "vandle").
+	  * \param[in]  field_     Name of the structure member (e.g. "ctof").
+	  * \param[out] count_     The number of elements in the column.
+	  * \return Pointer to the first element or NULL if the column does not exist or is not of type T.
+	  */
+	template <class T>
+	const T *getColumn(const std::string &structure_, const std::string &field_, size_t &count_) const {
+		return (const T*)getColumnData(structure_, field_, columnType<T>::name(), sizeof(T), count_);
+	}
+
+	/// Print the schema of all structures.
+	void print() const;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SCANMERGER_HPP
+#define SCANMERGER_HPP
+
+#include <vector>
+#include <string>
+
+class TFile;
+class TDirectory;
+
+class scanMerger{
+  private:
+	std::vector<std::string> inputs; /// List of simpleScan output files to merge (in order).
+
+	double totalTime; /// Sum of the "Data time" entries of all input files (in seconds).
+
+	int fileCount; /// The number of head/fileNN directories written to the output file.
+
+	/// Merge a TTree from all input files into the output file.
+	long long mergeTree(const std::string &name_, TFile *output_);
+
+	/// Merge the trace tree from all input files into the output file, offsetting its entry branch so that it indexes the merged data tree.
+	long long mergeTraceTree(std::vector<TFile*> &files_, TFile *output_);
+
+	/// Sum all histograms in a directory from all input files.
+	int mergeHists(const std::string &path_, std::vector<TFile*> &files_, TDirectory *dest_);
+
+	/// Copy the head directory of an input file to the output file, renumbering all fileNN sub-directories.
+	int copyHead(TFile *input_, TDirectory *dest_, const bool &firstFile_);
+
+  public:
+	scanMerger() : totalTime(0), fileCount(0) { }
+
+	/// Add a file to the list of files to merge. Files are merged in the order they are added.
+	void addFile(const std::string &fname_){ inputs.push_back(fname_); }
+
+	/// Return the number of files to merge.
+	size_t getNumFiles() const { return inputs.size(); }
+
+	/// Return the total data time of all merged files (in seconds).
+	double getTotalTime() const { return totalTime; }
+
+	/** Merge all input files into a single output file. All trees are concatenated in input order,
+	  * all histograms are summed, and the map, config, and calib directories are taken from the first file.
+	  * \param[in]  fname_     Filename of the output root file.
+	  * \param[in]  singleRun_ Set to true if all inputs are consecutive pieces of the same run, in which case
+	  *                        only the file information of the first input is kept in the head directory.
+	  * \return True if all files were merged successfully and false otherwise.
+	  */
+	bool merge(const std::string &fname_, const bool &singleRun_=false);
+
+	/// Recursively copy all objects in a directory to another directory.
+	static int copyDirectory(TDirectory *src_, TDirectory *dest_);
+};
+
+#endif
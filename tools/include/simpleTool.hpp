@@ -97,6 +97,16 @@ class simpleTool{
 	TFile *openInputFile();
 	
 	TTree *loadInputTree();
+
+	/** Get the entry numbers of all input tree entries with at least a minimum multiplicity of a detector type.
+	  * Only the multiplicity branch of the event index tree (written by the scanner with --index) is read, so
+	  * that non-matching entries of the input tree are never deserialized.
+	  * \param[in]  type_    The detector type (e.g. "vandle").
+	  * \param[out] entries_ Entry numbers of the matching input tree entries.
+	  * \param[in]  minMult_ The minimum multiplicity of the detector type.
+	  * \return True if the event index was used. If no index is found for the input tree, entries_ holds every entry and false is returned.
+	  */
+	bool getIndexedEntries(const std::string &type_, std::vector<long long> &entries_, const unsigned short &minMult_=1);
 	
 	TFile *openOutputFile();
 
@@ -10,7 +10,7 @@
 
 #include "cmcalc.hpp"
 #include "simpleTool.hpp"
-#include "Structures.h"
+#include "Readers.h"
 
 // Energy in MeV
 double energy2tof(const double &E_, const double &d){
@@ -336,12 +336,13 @@ int simpleComCalculator::execute(int argc, char *argv[]){
 			}
 
 			TBranch *branch = NULL;
-			VandleStructure *ptr = NULL;
+			VandleReader *reader = NULL;
 			std::vector<double> hitTheta;
 			std::vector<int> detLocation;
 	
 			if(!mcarlo){
-				intree->SetBranchAddress("vandle", &ptr, &branch);
+				// Only read the vandle members which are actually used.
+				reader = new VandleReader(intree, "ctof,r,theta,energy,tqdc,loc");
 			}
 			else{
 				intree->SetMakeClass(1);
@@ -349,59 +350,80 @@ int simpleComCalculator::execute(int argc, char *argv[]){
 				intree->SetBranchAddress("location", &detLocation);
 			}
 	
-			if(!branch){
+			if(mcarlo ? !branch : !reader->IsValid()){
 				std::cout << " Error: Failed to load branch \"vandle\" from input TTree.\n";
+				if(reader) delete reader;
 				return 8;
 			}
 	
+			// Skip entries without any vandle events using the event index (if available).
+			std::vector<long long> entries;
+			if(!mcarlo){
+				getIndexedEntries("vandle", entries);
+				reader->SetEntryList(entries);
+			}
+			else{
+				long long numEntries = intree->GetEntries();
+				for(long long i = 0; i < numEntries; i++)
+					entries.push_back(i);
+			}
+
 			progressBar pbar;
-			pbar.start(intree->GetEntries());
+			pbar.start(entries.size());
 	
 			unsigned int badCount = 0;
-			for(unsigned int i = 0; i < intree->GetEntries(); i++){
+			for(unsigned int i = 0; i < entries.size(); i++){
 				pbar.check(i);
-	
-				intree->GetEntry(i);
 		
 				if(!mcarlo){
-					for(unsigned int j = 0; j < ptr->mult; j++){
-						if(ptr->r.at(j) >= 0.65){
+					if(!reader->Next()) break;
+
+					ColumnSpan<double> ctofs = reader->ctof();
+					ColumnSpan<double> rs = reader->r();
+					ColumnSpan<double> thetas = reader->theta();
+					ColumnSpan<double> energies = reader->energy();
+					ColumnSpan<float> tqdcs = reader->tqdc();
+					ColumnSpan<unsigned short> locs = reader->loc();
+					for(size_t j = 0; j < rs.size(); j++){
+						if(rs[j] >= 0.65){
 							badCount++;
 							continue;
 						}
 			
 						// Check the tqdc threshold (if available).
-						if(threshold > 0 && ptr->tqdc.at(j) < threshold) continue;
+						if(threshold > 0 && tqdcs[j] < threshold) continue;
+
+						ctof = ctofs[j];
+						energy = energies[j];
+						tqdc = tqdcs[j];
+						theta = thetas[j];
+						location = locs[j];
 
 						// Apply TOF offset correction.
 						if(timeOffset != 0){
 							const double Mn = 10454.0750977429; // MeV
-							ptr->ctof.at(j) = ptr->ctof.at(j)+timeOffset;
-							ptr->energy.at(j) = 0.5*Mn*std::pow(ptr->r.at(j)/ptr->ctof.at(j), 2.0);
+							ctof = ctof+timeOffset;
+							energy = 0.5*Mn*std::pow(rs[j]/ctof, 2.0);
 						}
 	
 						// Check against the input tcutg (if available).
-						if(useTCutG && !tcutg->IsInside(ptr->ctof.at(j), ptr->tqdc.at(j))) continue;
+						if(useTCutG && !tcutg->IsInside(ctof, tqdc)) continue;
 	
-						rxn.SetLabAngle(ptr->theta.at(j));
+						rxn.SetLabAngle(theta);
 						if(treeMode){
-							ctof = ptr->ctof.at(j);
-							energy = ptr->energy.at(j);
-							tqdc = ptr->tqdc.at(j);
-							theta = ptr->theta.at(j);
-							location = ptr->loc.at(j);
-			
 							angleCOM = rxn.GetEjectile()->comAngle[0];
 				
 							outtree->Fill();
 						}
-						hE->Fill(ptr->theta.at(j), ptr->energy.at(j));
-						h2d->Fill(ptr->theta.at(j), ptr->ctof.at(j));
-						hEcom->Fill(rxn.GetEjectile()->comAngle[0], ptr->energy.at(j));
-						h2dcom->Fill(rxn.GetEjectile()->comAngle[0], ptr->ctof.at(j));
+						hE->Fill(theta, energy);
+						h2d->Fill(theta, ctof);
+						hEcom->Fill(rxn.GetEjectile()->comAngle[0], energy);
+						h2dcom->Fill(rxn.GetEjectile()->comAngle[0], ctof);
 					}
 				}
 				else{
+					intree->GetEntry(entries[i]);
+
 					for(unsigned int j = 0; j < hitTheta.size(); j++){
 						theta = hitTheta.at(j);
 						rxn.SetLabAngle(theta);
@@ -414,6 +436,8 @@ int simpleComCalculator::execute(int argc, char *argv[]){
 			}
 	
 			pbar.finalize();
+
+			if(reader) delete reader;
 		
 			std::cout << "  Rejected " << badCount << " events.\n";
 		}
@@ -0,0 +1,292 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "columnReader.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// class jsonValue
+///////////////////////////////////////////////////////////////////////////////
+
+static void skipWhitespace(const std::string &str_, size_t &pos_){
+	while(pos_ < str_.size() && (str_[pos_] == ' ' || str_[pos_] == '\t' || str_[pos_] == '\n' || str_[pos_] == '\r')) pos_++;
+}
+
+static bool parseString(const std::string &str_, size_t &pos_, std::string &output_){
+	if(pos_ >= str_.size() || str_[pos_] != '\"') return false;
+	output_ = "";
+	for(pos_++; pos_ < str_.size(); pos_++){
+		if(str_[pos_] == '\"'){
+			pos_++;
+			return true;
+		}
+		else if(str_[pos_] == '\\' && pos_+1 < str_.size()){
+			char c = str_[++pos_];
+			if(c == 'n') output_ += '\n';
+			else if(c == 't') output_ += '\t';
+			else if(c == 'r') output_ += '\r';
+			else if(c == 'u' && pos_+4 < str_.size()){ // Only plain ascii characters are supported.
+				output_ += (char)strtol(str_.substr(pos_+1, 4).c_str(), NULL, 16);
+				pos_ += 4;
+			}
+			else output_ += c;
+		}
+		else output_ += str_[pos_];
+	}
+	return false;
+}
+
+const jsonValue &jsonValue::operator [] (const std::string &name_) const {
+	static const jsonValue empty;
+	std::map<std::string, jsonValue>::const_iterator iter = object.find(name_);
+	return (iter != object.end() ? iter->second : empty);
+}
+
+bool jsonValue::parse(const std::string &str_, size_t &pos_){
+	skipWhitespace(str_, pos_);
+	if(pos_ >= str_.size()) return false;
+
+	char c = str_[pos_];
+	if(c == '{'){
+		type = OBJECT;
+		pos_++;
+		skipWhitespace(str_, pos_);
+		if(pos_ < str_.size() && str_[pos_] == '}'){ pos_++; return true; }
+		while(pos_ < str_.size()){
+			std::string name;
+			skipWhitespace(str_, pos_);
+			if(!parseString(str_, pos_, name)) return false;
+			skipWhitespace(str_, pos_);
+			if(pos_ >= str_.size() || str_[pos_++] != ':') return false;
+			if(!object[name].parse(str_, pos_)) return false;
+			skipWhitespace(str_, pos_);
+			if(pos_ >= str_.size()) return false;
+			if(str_[pos_] == '}'){ pos_++; return true; }
+			if(str_[pos_++] != ',') return false;
+		}
+		return false;
+	}
+	else if(c == '['){
+		type = ARRAY;
+		pos_++;
+		skipWhitespace(str_, pos_);
+		if(pos_ < str_.size() && str_[pos_] == ']'){ pos_++; return true; }
+		while(pos_ < str_.size()){
+			array.push_back(jsonValue());
+			if(!array.back().parse(str_, pos_)) return false;
+			skipWhitespace(str_, pos_);
+			if(pos_ >= str_.size()) return false;
+			if(str_[pos_] == ']'){ pos_++; return true; }
+			if(str_[pos_++] != ',') return false;
+		}
+		return false;
+	}
+	else if(c == '\"'){
+		type = STRING;
+		return parseString(str_, pos_, str);
+	}
+	else if(str_.compare(pos_, 4, "true") == 0){
+		type = BOOLEAN;
+		boolean = true;
+		pos_ += 4;
+		return true;
+	}
+	else if(str_.compare(pos_, 5, "false") == 0){
+		type = BOOLEAN;
+		boolean = false;
+		pos_ += 5;
+		return true;
+	}
+	else if(str_.compare(pos_, 4, "null") == 0){
+		type = NONE;
+		pos_ += 4;
+		return true;
+	}
+
+	char *end;
+	number = strtod(str_.c_str() + pos_, &end);
+	if(end == str_.c_str() + pos_) return false;
+	type = NUMBER;
+	pos_ = end - str_.c_str();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class columnFile
+///////////////////////////////////////////////////////////////////////////////
+
+bool columnFile::open(const std::string &fname_){
+	close();
+
+	int fd = ::open(fname_.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0){
+		::close(fd);
+		return false;
+	}
+
+	length = info.st_size;
+	if(length > 0){
+		ptr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+		if(ptr == MAP_FAILED){
+			ptr = NULL;
+			length = 0;
+			::close(fd);
+			return false;
+		}
+		madvise(ptr, length, MADV_SEQUENTIAL);
+	}
+
+	// The mapping remains valid after the file descriptor is closed.
+	::close(fd);
+
+	return true;
+}
+
+void columnFile::close(){
+	if(ptr) munmap(ptr, length);
+	ptr = NULL;
+	length = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class columnStructure
+///////////////////////////////////////////////////////////////////////////////
+
+columnStructure::~columnStructure(){
+	for(std::vector<columnField*>::iterator iter = fields.begin(); iter != fields.end(); iter++){
+		delete (*iter);
+	}
+}
+
+columnField *columnStructure::getField(const std::string &name_) const {
+	for(std::vector<columnField*>::const_iterator iter = fields.begin(); iter != fields.end(); iter++){
+		if((*iter)->name == name_) return (*iter);
+	}
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class columnReader
+///////////////////////////////////////////////////////////////////////////////
+
+const void *columnReader::getColumnData(const std::string &structure_, const std::string &field_, const std::string &type_, const size_t &width_, size_t &count_) const {
+	count_ = 0;
+
+	columnStructure *structure = getStructure(structure_);
+	columnField *field = (structure ? structure->getField(field_) : NULL);
+	if(!field){
+		std::cout << " columnReader: Error! No column named \"" << structure_ << "." << field_ << "\".\n";
+		return NULL;
+	}
+	if(field->type != type_ || field->width != width_){
+		std::cout << " columnReader: Error! Column \"" << structure_ << "." << field_ << "\" is of type " << field->type << ", not " << type_ << ".\n";
+		return NULL;
+	}
+
+	count_ = field->size();
+
+	return field->file.data();
+}
+
+bool columnReader::open(const std::string &directory_){
+	close();
+
+	directory = directory_;
+
+	std::ifstream schemaFile((directory + "/schema.json").c_str());
+	if(!schemaFile.good()){
+		std::cout << " columnReader: Error! Failed to open schema file \"" << directory << "/schema.json\".\n";
+		return false;
+	}
+
+	std::stringstream stream;
+	stream << schemaFile.rdbuf();
+	std::string document = stream.str();
+
+	jsonValue schema;
+	size_t pos = 0;
+	if(!schema.parse(document, pos) || schema.type != jsonValue::OBJECT){
+		std::cout << " columnReader: Error! Failed to parse schema file \"" << directory << "/schema.json\".\n";
+		return false;
+	}
+
+	unsigned short endianTest = 1;
+	std::string byteOrder = (*(unsigned char*)&endianTest == 1 ? "little" : "big");
+	if(schema["byteOrder"].str != byteOrder){
+		std::cout << " columnReader: Error! Column files were written with " << schema["byteOrder"].str << " endian byte order.\n";
+		return false;
+	}
+
+	entries = (unsigned long long)schema["entries"].number;
+
+	const std::vector<jsonValue> &structList = schema["structures"].array;
+	for(std::vector<jsonValue>::const_iterator iter = structList.begin(); iter != structList.end(); iter++){
+		columnStructure *structure = new columnStructure();
+		structure->name = (*iter)["name"].str;
+		structure->className = (*iter)["class"].str;
+		structure->elements = (unsigned long long)(*iter)["elements"].number;
+		structures.push_back(structure);
+
+		if(!structure->offsets.open(directory + "/" + (*iter)["offsets"].str) || structure->offsets.size() != 8*(entries+1)){
+			std::cout << " columnReader: Error! Invalid offsets column for structure \"" << structure->name << "\".\n";
+			close();
+			return false;
+		}
+
+		const std::vector<jsonValue> &fieldList = (*iter)["fields"].array;
+		for(std::vector<jsonValue>::const_iterator iter2 = fieldList.begin(); iter2 != fieldList.end(); iter2++){
+			columnField *field = new columnField();
+			field->name = (*iter2)["name"].str;
+			field->type = (*iter2)["type"].str;
+			field->description = (*iter2)["description"].str;
+			field->filename = directory + "/" + (*iter2)["file"].str;
+			field->width = (size_t)(*iter2)["bytes"].number;
+			field->isVector = (*iter2)["vector"].boolean;
+			structure->fields.push_back(field);
+
+			// Check that the column holds one element for every entry (or every vector element).
+			if(!field->file.open(field->filename) || field->size() != (field->isVector ? structure->elements : entries)){
+				std::cout << " columnReader: Error! Invalid column file \"" << field->filename << "\".\n";
+				close();
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void columnReader::close(){
+	for(std::vector<columnStructure*>::iterator iter = structures.begin(); iter != structures.end(); iter++){
+		delete (*iter);
+	}
+	structures.clear();
+	entries = 0;
+}
+
+columnStructure *columnReader::getStructure(const std::string &name_) const {
+	for(std::vector<columnStructure*>::const_iterator iter = structures.begin(); iter != structures.end(); iter++){
+		if((*iter)->name == name_) return (*iter);
+	}
+	return NULL;
+}
+
+void columnReader::print() const {
+	std::cout << " " << directory << ": " << entries << " entries\n";
+	for(std::vector<columnStructure*>::const_iterator iter = structures.begin(); iter != structures.end(); iter++){
+		std::cout << "  " << (*iter)->name << " (" << (*iter)->className << "), " << (*iter)->elements << " elements\n";
+		for(std::vector<columnField*>::const_iterator iter2 = (*iter)->fields.begin(); iter2 != (*iter)->fields.end(); iter2++){
+			std::cout << "   " << (*iter2)->name << "\t" << (*iter2)->type << ((*iter2)->isVector ? "[]" : "") << "\t" << (*iter2)->description << std::endl;
+		}
+	}
+}
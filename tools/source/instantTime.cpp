@@ -3,10 +3,9 @@
 
 #include "TFile.h"
 #include "TTree.h"
-#include "TBranch.h"
 
 #include "simpleTool.hpp"
-#include "Structures.h"
+#include "Readers.h"
 
 class instantTime : public simpleTool {
   public:
@@ -43,13 +42,11 @@ int instantTime::execute(int argc, char *argv[]){
 		return 2;
 	}
 
-	TBranch *branch = NULL;
-	LogicStructure *ptr = NULL;
+	// Only the logic signal times are needed.
+	LogicReader reader(intree, "time");
 
-	intree->SetBranchAddress("logic", &ptr, &branch);
-
-	if(!branch){
-		std::cout << " Error: Failed to load branch \"trigger\" from input TTree.\n";
+	if(!reader.IsValid()){
+		std::cout << " Error: Failed to load branch \"logic\" from input TTree.\n";
 		return false;
 	}
 
@@ -74,22 +71,26 @@ int instantTime::execute(int argc, char *argv[]){
 	outtree->Branch("tdiff", &tdiff);
 	outtree->Branch("time", &currTime);
 
+	// Skip entries without any logic signals using the event index (if available).
+	std::vector<long long> entries;
+	getIndexedEntries("logic", entries);
+	reader.SetEntryList(entries);
+
 	progressBar pbar;
-	pbar.start(intree->GetEntries());
-
-	for(int i = 0; i < intree->GetEntries(); i++){
-		pbar.check(i);
-		intree->GetEntry(i);
-		if(ptr->mult == 0)
-			continue;
-		for(unsigned int j = 0; j < ptr->mult; j++){
+	pbar.start(reader.GetNumSelected());
+
+	unsigned int numRead = 0;
+	while(reader.Next()){
+		pbar.check(numRead++);
+		ColumnSpan<double> times = reader.time();
+		for(size_t j = 0; j < times.size(); j++){
 			if(count++ != 0){
-				currTime = ptr->time.at(j)-firstTime;
+				currTime = times[j]-firstTime;
 				tdiff = currTime-prevTime;
 				outtree->Fill();
 				prevTime = currTime;
 			}
-			else{ firstTime = ptr->time.at(j); }
+			else{ firstTime = times[j]; }
 		}
 	}
 
@@ -0,0 +1,481 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "simpleTool.hpp"
+#include "scanMerger.hpp"
+#include "SpillIndex.hpp"
+
+class scanJob{
+  public:
+	std::string input; /// Input file for the scan.
+	std::string output; /// Output root file of the scan.
+	std::string log; /// Log file for scan output.
+	std::string window; /// Raw event time window argument.
+
+	int status; /// Exit status of the scan (-1 if the scan has not finished).
+
+	scanJob() : status(-1) { }
+
+	scanJob(const std::string &input_, const std::string &output_) : input(input_), output(output_), status(-1) { }
+
+	/// Return the argument list for this scan. Additional arguments are split on whitespace.
+	std::vector<std::string> getArguments(const std::string &exe_, const std::string &args_) const;
+
+	/** Start the scan in the calling (child) process. Input is read from /dev/null and all output goes to the log file.
+	  * This function only returns if the scan could not be started.
+	  */
+	void exec(const std::vector<std::string> &args_) const;
+};
+
+std::vector<std::string> scanJob::getArguments(const std::string &exe_, const std::string &args_) const {
+	std::vector<std::string> args;
+	args.push_back(exe_);
+	args.push_back("-b");
+	args.push_back("-f");
+	args.push_back("-i");
+	args.push_back(input);
+	args.push_back("-o");
+	args.push_back(output);
+	if(!window.empty()){
+		args.push_back("--window");
+		args.push_back(window);
+	}
+
+	std::stringstream stream(args_);
+	std::string arg;
+	while(stream >> arg) args.push_back(arg);
+
+	return args;
+}
+
+void scanJob::exec(const std::vector<std::string> &args_) const {
+	int devnull = open("/dev/null", O_RDONLY);
+	int logfile = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(devnull < 0 || logfile < 0) return;
+
+	dup2(devnull, STDIN_FILENO);
+	dup2(logfile, STDOUT_FILENO);
+	dup2(logfile, STDERR_FILENO);
+	close(devnull);
+	close(logfile);
+
+	std::vector<char*> argv;
+	for(std::vector<std::string>::const_iterator iter = args_.begin(); iter != args_.end(); iter++){
+		argv.push_back((char*)iter->c_str());
+	}
+	argv.push_back(NULL);
+
+	// Search the PATH so the default scan executable name still works.
+	execvp(argv.front(), argv.data());
+}
+
+class parallelScan : public simpleTool {
+  private:
+	std::string scan_exe;
+	std::string scan_args;
+	std::string tmp_dir;
+
+	std::string run_list;
+
+	int num_jobs;
+	int num_overlap;
+
+	long mem_budget; /// Total memory available to all concurrent scans (in MB).
+	long job_memory; /// Estimated peak memory usage of a single scan (in MB).
+
+	bool keep_files;
+	bool print_index;
+
+	bool writeChunk(std::ifstream &input_, SpillIndex &index_, const size_t &start_, const size_t &stop_, const std::string &fname_);
+
+	int runJobs(std::vector<scanJob> &jobs_, const int &maxJobs_);
+
+	void removeFiles(std::vector<scanJob> &jobs_, const bool &removeInput_=true);
+
+	int executeChunks();
+
+	int executeBatch();
+
+  public:
+	parallelScan();
+
+	void addOptions();
+
+	bool processArgs();
+
+	int execute(int argc, char *argv[]);
+};
+
+parallelScan::parallelScan() : simpleTool() {
+	scan_exe = "simpleScan";
+	scan_args = "";
+	tmp_dir = "./";
+	num_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	num_overlap = 1;
+	mem_budget = (sysconf(_SC_PHYS_PAGES) / 1024) * (sysconf(_SC_PAGESIZE) / 1024) * 3 / 4;
+	job_memory = 1024;
+	keep_files = false;
+	print_index = false;
+
+	if(num_jobs < 1) num_jobs = 1;
+}
+
+bool parallelScan::writeChunk(std::ifstream &input_, SpillIndex &index_, const size_t &start_, const size_t &stop_, const std::string &fname_){
+	std::ofstream output(fname_.c_str(), std::ios::binary);
+	if(!output.good()) return false;
+
+	std::vector<char> buffer(1048576);
+
+	unsigned long long start = index_.at(start_).offset;
+	unsigned long long stop = index_.at(stop_-1).offset + index_.at(stop_-1).GetSize();
+
+	// Copy the file header followed by the range of spills.
+	unsigned long long ranges[2][2] = {{0, index_.GetHeaderLength()}, {start, stop}};
+	for(int i = 0; i < 2; i++){
+		input_.seekg(ranges[i][0]);
+		unsigned long long remaining = ranges[i][1] - ranges[i][0];
+		while(remaining > 0){
+			size_t length = (remaining < buffer.size() ? remaining : buffer.size());
+			input_.read(buffer.data(), length);
+			output.write(buffer.data(), length);
+			remaining -= length;
+		}
+	}
+
+	// Close the file.
+	output.write((char *)&fileFooterWord, 4);
+	output.write((char *)&endBufferWord, 4);
+
+	bool retval = input_.good() && output.good();
+	output.close();
+
+	return retval;
+}
+
+int parallelScan::runJobs(std::vector<scanJob> &jobs_, const int &maxJobs_){
+	std::map<pid_t, size_t> running;
+	size_t nextJob = 0;
+	int numFailed = 0;
+
+	while(nextJob < jobs_.size() || !running.empty()){
+		// Start new scans until the maximum number of concurrent jobs or the memory budget is reached.
+		while(nextJob < jobs_.size() && (int)running.size() < maxJobs_){
+			if(!running.empty() && mem_budget > 0 && (long)(running.size()+1)*job_memory > mem_budget) break;
+
+			std::vector<std::string> args = jobs_.at(nextJob).getArguments(scan_exe, scan_args);
+			pid_t pid = fork();
+			if(pid == 0){ // Child process.
+				jobs_.at(nextJob).exec(args);
+				_exit(127);
+			}
+			else if(pid < 0){
+				std::cout << " Error! Failed to start scan of " << jobs_.at(nextJob).input << ".\n";
+				numFailed++;
+				nextJob++;
+				continue;
+			}
+			std::cout << "  Started job " << nextJob << ":";
+			for(std::vector<std::string>::iterator iter = args.begin(); iter != args.end(); iter++) std::cout << " " << *iter;
+			std::cout << std::endl;
+			running[pid] = nextJob++;
+		}
+
+		// Wait for a scan to finish.
+		int status;
+		struct rusage usage;
+		pid_t pid = wait4(-1, &status, 0, &usage);
+		if(pid < 0) break;
+
+		// Use the largest peak memory usage seen so far as the estimate for future scans.
+		if(usage.ru_maxrss / 1024 > job_memory){
+			job_memory = usage.ru_maxrss / 1024;
+			std::cout << "  Increased memory estimate to " << job_memory << " MB per scan.\n";
+		}
+
+		std::map<pid_t, size_t>::iterator iter = running.find(pid);
+		if(iter == running.end()) continue;
+
+		scanJob *job = &jobs_.at(iter->second);
+		job->status = (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+		if(job->status != 0 || access(job->output.c_str(), F_OK) != 0){
+			std::cout << " Error! Job " << iter->second << " failed (status=" << job->status << "). See " << job->log << ".\n";
+			numFailed++;
+		}
+		else std::cout << "  Finished job " << iter->second << ".\n";
+		running.erase(iter);
+	}
+
+	return numFailed;
+}
+
+void parallelScan::removeFiles(std::vector<scanJob> &jobs_, const bool &removeInput_/*=true*/){
+	for(std::vector<scanJob>::iterator iter = jobs_.begin(); iter != jobs_.end(); iter++){
+		if(removeInput_) remove(iter->input.c_str());
+		remove(iter->output.c_str());
+		remove(iter->log.c_str());
+	}
+}
+
+void parallelScan::addOptions(){
+	addOption(optionExt("jobs", required_argument, NULL, 'j', "<N>", "Specify the number of concurrent scan jobs (default=number of cpu cores)."), userOpts, optstr);
+	addOption(optionExt("overlap", required_argument, NULL, 0, "<N>", "Specify the number of spills of overlap between neighboring chunks (default=1)."), userOpts, optstr);
+	addOption(optionExt("scan", required_argument, NULL, 0, "<path>", "Specify the path to the simpleScan executable (default=simpleScan)."), userOpts, optstr);
+	addOption(optionExt("args", required_argument, NULL, 'a', "<args>", "Specify additional command line arguments to pass to each scan (split on whitespace)."), userOpts, optstr);
+	addOption(optionExt("tmp", required_argument, NULL, 0, "<dir>", "Specify the directory for temporary chunk files (default=./)."), userOpts, optstr);
+	addOption(optionExt("keep", no_argument, NULL, 'k', "", "Do not delete temporary chunk files."), userOpts, optstr);
+	addOption(optionExt("index", no_argument, NULL, 0, "", "Print the spill index of the input file and exit."), userOpts, optstr);
+	addOption(optionExt("batch", required_argument, NULL, 'b', "<runlist>", "Scan all input files listed in a run list and merge the outputs."), userOpts, optstr);
+	addOption(optionExt("memory", required_argument, NULL, 'm', "<MB>", "Specify the memory budget for all concurrent scans (default=75% of physical memory)."), userOpts, optstr);
+	addOption(optionExt("job-memory", required_argument, NULL, 0, "<MB>", "Specify the initial memory estimate for a single scan (default=1024)."), userOpts, optstr);
+}
+
+bool parallelScan::processArgs(){
+	if(userOpts.at(0).active){
+		num_jobs = strtol(userOpts.at(0).argument.c_str(), NULL, 0);
+		if(num_jobs < 1){
+			std::cout << " Error: Invalid number of jobs (" << userOpts.at(0).argument << ")!\n";
+			return false;
+		}
+	}
+	if(userOpts.at(1).active){
+		num_overlap = strtol(userOpts.at(1).argument.c_str(), NULL, 0);
+		if(num_overlap < 0){
+			std::cout << " Error: Invalid number of overlap spills (" << userOpts.at(1).argument << ")!\n";
+			return false;
+		}
+		else if(num_overlap == 0)
+			std::cout << " Warning: Raw events spanning chunk boundaries will be lost without spill overlap.\n";
+	}
+	if(userOpts.at(2).active)
+		scan_exe = userOpts.at(2).argument;
+	if(userOpts.at(3).active)
+		scan_args = userOpts.at(3).argument;
+	if(userOpts.at(4).active){
+		tmp_dir = userOpts.at(4).argument;
+		if(tmp_dir.empty() || tmp_dir.back() != '/') tmp_dir += '/';
+	}
+	if(userOpts.at(5).active)
+		keep_files = true;
+	if(userOpts.at(6).active)
+		print_index = true;
+	if(userOpts.at(7).active)
+		run_list = userOpts.at(7).argument;
+	if(userOpts.at(8).active){
+		mem_budget = strtol(userOpts.at(8).argument.c_str(), NULL, 0);
+		if(mem_budget <= 0){
+			std::cout << " Error: Invalid memory budget (" << userOpts.at(8).argument << ")!\n";
+			return false;
+		}
+	}
+	if(userOpts.at(9).active){
+		job_memory = strtol(userOpts.at(9).argument.c_str(), NULL, 0);
+		if(job_memory <= 0){
+			std::cout << " Error: Invalid scan memory estimate (" << userOpts.at(9).argument << ")!\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int parallelScan::executeChunks(){
+	if(input_filename.empty()){
+		std::cout << " Error: Must specify input filename!\n";
+		return 1;
+	}
+
+	std::string extension = input_filename.substr(input_filename.find_last_of('.')+1);
+	if(extension != "pld"){
+		std::cout << " Error: Input file must be in pld format!\n";
+		return 1;
+	}
+
+	// Find all spill boundaries in the input file.
+	std::cout << " Indexing spills in " << input_filename << ".\n";
+	SpillIndex index;
+	if(!index.Build(input_filename.c_str())){
+		std::cout << " Error: Failed to index input file!\n";
+		return 2;
+	}
+
+	if(print_index){
+		index.Print();
+		return 0;
+	}
+
+	if(output_filename.empty()){
+		std::cout << " Error: Must specify output filename!\n";
+		return 1;
+	}
+
+	// Split the run into chunks of consecutive spills.
+	size_t numSpills = index.size();
+	size_t numChunks = (num_jobs < (int)numSpills ? num_jobs : numSpills);
+	std::cout << " Found " << numSpills << " spills. Splitting run into " << numChunks << " chunks.\n";
+
+	std::string prefix = output_filename.substr(output_filename.find_last_of('/')+1);
+	prefix = tmp_dir + prefix.substr(0, prefix.find_last_of('.'));
+
+	std::ifstream input(input_filename.c_str(), std::ios::binary);
+
+	std::vector<scanJob> jobs;
+	std::vector<double> startTimes;
+	for(size_t i = 0; i <= numChunks; i++){
+		size_t spill = (i * numSpills) / numChunks;
+		while(spill < numSpills && !index.at(spill).HasTime()) spill++;
+		startTimes.push_back((i > 0 && spill < numSpills) ? index.at(spill).firstTime : -1);
+	}
+
+	for(size_t i = 0; i < numChunks; i++){
+		size_t start = (i * numSpills) / numChunks;
+		size_t stop = ((i+1) * numSpills) / numChunks;
+
+		// Add overlap spills so that raw events crossing the chunk boundary are built completely.
+		start = (start > (size_t)num_overlap ? start - num_overlap : 0);
+		stop = (stop + num_overlap < numSpills ? stop + num_overlap : numSpills);
+
+		std::stringstream stream;
+		stream << prefix << ".chunk" << std::setfill('0') << std::setw(2) << i;
+
+		scanJob job(stream.str() + ".pld", stream.str() + ".root");
+		job.log = stream.str() + ".log";
+
+		// Each chunk only keeps the raw events which start inside its own time window.
+		std::stringstream window;
+		window << std::fixed << std::setprecision(0);
+		if(startTimes.at(i) >= 0) window << startTimes.at(i);
+		window << ":";
+		if(startTimes.at(i+1) >= 0) window << startTimes.at(i+1);
+		job.window = window.str();
+
+		if(!writeChunk(input, index, start, stop, job.input)){
+			std::cout << " Error: Failed to write chunk file " << job.input << "!\n";
+			removeFiles(jobs);
+			remove(job.input.c_str());
+			return 3;
+		}
+
+		std::cout << "  Chunk " << i << ": spills [" << start << ", " << stop << "), window [" << job.window << ")\n";
+		jobs.push_back(job);
+	}
+
+	input.close();
+
+	// Scan all chunks.
+	std::cout << " Running " << jobs.size() << " scans on " << num_jobs << " processes.\n";
+	int numFailed = runJobs(jobs, num_jobs);
+	if(numFailed > 0){
+		std::cout << " Error: " << numFailed << " of " << jobs.size() << " scans failed! Keeping temporary files.\n";
+		return 4;
+	}
+
+	// Merge the chunk outputs in time order.
+	scanMerger merger;
+	for(std::vector<scanJob>::iterator iter = jobs.begin(); iter != jobs.end(); iter++){
+		merger.addFile(iter->output);
+	}
+
+	if(!merger.merge(output_filename, true)){
+		std::cout << " Error: Failed to merge scan outputs! Keeping temporary files.\n";
+		return 5;
+	}
+
+	if(!keep_files) removeFiles(jobs);
+
+	return 0;
+}
+
+int parallelScan::executeBatch(){
+	std::ifstream listFile(run_list.c_str());
+	if(!listFile.good()){
+		std::cout << " Error: Failed to open run list \"" << run_list << "\"!\n";
+		return 1;
+	}
+
+	if(output_filename.empty()){
+		std::cout << " Error: Must specify output filename!\n";
+		return 1;
+	}
+
+	// Read the list of input files. Blank lines and lines starting with '#' are ignored.
+	// Each line is one path and is passed to the scan as a single argument, so it may contain spaces.
+	std::vector<scanJob> jobs;
+	std::string line;
+	while(std::getline(listFile, line)){
+		size_t start = line.find_first_not_of(" \t");
+		if(start == std::string::npos || line[start] == '#') continue;
+		line = line.substr(start, line.find_last_not_of(" \t\r") - start + 1);
+
+		if(access(line.c_str(), R_OK) != 0){
+			std::cout << " Error: Failed to open input file \"" << line << "\" listed in run list!\n";
+			return 1;
+		}
+
+		// Include the job index so that runs with the same name (or listed twice) do not overwrite each other.
+		std::string name = line.substr(line.find_last_of('/')+1);
+		std::stringstream stream;
+		stream << tmp_dir << name.substr(0, name.find_last_of('.')) << ".job" << std::setfill('0') << std::setw(3) << jobs.size();
+
+		scanJob job(line, stream.str() + ".root");
+		job.log = stream.str() + ".log";
+		jobs.push_back(job);
+	}
+
+	listFile.close();
+
+	if(jobs.empty()){
+		std::cout << " Error: Run list \"" << run_list << "\" contains no input files!\n";
+		return 1;
+	}
+
+	// Scan all runs.
+	std::cout << " Running " << jobs.size() << " scans on up to " << num_jobs << " processes (memory budget " << mem_budget << " MB).\n";
+	int numFailed = runJobs(jobs, num_jobs);
+	if(numFailed > 0){
+		std::cout << " Error: " << numFailed << " of " << jobs.size() << " scans failed! Keeping temporary files.\n";
+		return 4;
+	}
+
+	// Merge the run outputs in run list order.
+	scanMerger merger;
+	for(std::vector<scanJob>::iterator iter = jobs.begin(); iter != jobs.end(); iter++){
+		merger.addFile(iter->output);
+	}
+
+	if(!merger.merge(output_filename)){
+		std::cout << " Error: Failed to merge scan outputs! Keeping temporary files.\n";
+		return 5;
+	}
+
+	if(!keep_files) removeFiles(jobs, false);
+
+	return 0;
+}
+
+int parallelScan::execute(int argc, char *argv[]){
+	if(!setup(argc, argv))
+		return 0;
+
+	if(!run_list.empty())
+		return executeBatch();
+
+	return executeChunks();
+}
+
+int main(int argc, char *argv[]){
+	parallelScan obj;
+
+	return obj.execute(argc, argv);
+}
@@ -3,10 +3,9 @@
 
 #include "TFile.h"
 #include "TTree.h"
-#include "TBranch.h"
 
 #include "simpleTool.hpp"
-#include "Structures.h"
+#include "Readers.h"
 
 class phasePhase : public simpleTool {
   private:
@@ -61,38 +60,44 @@ bool phasePhase::process(){
 		return false;
 	}
 
-	TBranch *branch = NULL;
-	TraceStructure *ptr = NULL;
+	// Only read the members which are actually used.
+	TraceReader reader(intree, "loc,maximum,phase,tdiff");
 
-	intree->SetBranchAddress("trace", &ptr, &branch);
-
-	if(!branch){
+	if(!reader.IsValid()){
 		std::cout << " Error: Failed to load branch \"trace\" from input TTree.\n";
 		return false;
 	}
 
-	std::cout << " Processing " << intree->GetEntries() << " entries.\n";
-	for(int i = 0; i < intree->GetEntries(); i++){
-		intree->GetEntry(i);
-		if(ptr->mult == 0)
+	// Skip entries without any traces using the event index (if available).
+	std::vector<long long> entries;
+	getIndexedEntries("trace", entries);
+	reader.SetEntryList(entries);
+
+	std::cout << " Processing " << reader.GetNumSelected() << " entries.\n";
+	while(reader.Next()){
+		if(reader.size() == 0)
 			continue;
+		ColumnSpan<unsigned short> loc = reader.loc();
+		ColumnSpan<float> maximum = reader.maximum();
+		ColumnSpan<float> phase = reader.phase();
+		ColumnSpan<double> tdiffs = reader.tdiff();
 		p1 = -1;
 		p2 = -1;
-		for(unsigned int j = 0; j < ptr->mult; j++){
-			if(ptr->loc[j] == startID){
-				max1 = ptr->maximum[j];
+		for(size_t j = 0; j < loc.size(); j++){
+			if(loc[j] == startID){
+				max1 = maximum[j];
 
 				// Check the threshold.
 				if(max1 >= threshold)
-					p1 = ptr->phase[j]*4;
+					p1 = phase[j]*4;
 			}
-			else if(ptr->loc[j] == stopID){
-				max2 = ptr->maximum[j];
+			else if(loc[j] == stopID){
+				max2 = maximum[j];
 
 				// Check the threshold.
 				if(max2 >= threshold){
-					p2 = ptr->phase[j]*4;
-					tdiff = ptr->tdiff[j];
+					p2 = phase[j]*4;
+					tdiff = tdiffs[j];
 				}
 			}
 		}
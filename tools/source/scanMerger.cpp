@@ -0,0 +1,240 @@
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <set>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TKey.h"
+#include "TH1.h"
+#include "TNamed.h"
+#include "TClass.h"
+#include "TDirectory.h"
+
+#include "scanMerger.hpp"
+
+long long scanMerger::mergeTree(const std::string &name_, TFile *output_){
+	TChain chain(name_.c_str());
+	for(std::vector<std::string>::iterator iter = inputs.begin(); iter != inputs.end(); iter++){
+		chain.Add(iter->c_str());
+	}
+
+	output_->cd();
+	long long entries = chain.Merge(output_, 0, "fast keep");
+	std::cout << "  Merged " << entries << " entries into TTree \"" << name_ << "\".\n";
+
+	return entries;
+}
+
+long long scanMerger::mergeTraceTree(std::vector<TFile*> &files_, TFile *output_){
+	// The entry branch of each trace tree indexes the data tree of the same file,
+	// so offset it by the number of data entries in all preceding input files.
+	std::vector<unsigned long long> offsets;
+	unsigned long long offset = 0;
+	for(std::vector<TFile*>::iterator iter = files_.begin(); iter != files_.end(); iter++){
+		offsets.push_back(offset);
+		TTree *data = (TTree*)(*iter)->Get("data");
+		if(!data){
+			std::cout << "  Warning! No data tree found in " << (*iter)->GetName() << ". Trace entries are only linked to the data of their own input file.\n";
+			return mergeTree("trace", output_);
+		}
+		offset += data->GetEntries();
+	}
+
+	TChain chain("trace");
+	for(std::vector<std::string>::iterator iter = inputs.begin(); iter != inputs.end(); iter++){
+		chain.Add(iter->c_str());
+	}
+
+	unsigned long long entry = 0;
+	chain.SetBranchAddress("entry", &entry);
+
+	output_->cd();
+	TTree *tree = chain.CloneTree(0);
+
+	long long entries = chain.GetEntries();
+	for(long long i = 0; i < entries; i++){
+		chain.GetEntry(i);
+		entry += offsets.at(chain.GetTreeNumber());
+		tree->Fill();
+	}
+
+	tree->Write();
+	std::cout << "  Merged " << entries << " entries into TTree \"trace\".\n";
+
+	return entries;
+}
+
+int scanMerger::mergeHists(const std::string &path_, std::vector<TFile*> &files_, TDirectory *dest_){
+	TDirectory *src = (!path_.empty() ? files_.front()->GetDirectory(path_.c_str()) : files_.front());
+	if(!src) return 0;
+
+	int count = 0;
+	TIter next(src->GetListOfKeys());
+	TKey *key;
+	while((key = (TKey*)next())){
+		TClass *cl = TClass::GetClass(key->GetClassName());
+		if(!cl || !cl->InheritsFrom("TH1")) continue;
+
+		TH1 *sum = (TH1*)key->ReadObj();
+		sum->SetDirectory(NULL);
+		for(size_t i = 1; i < files_.size(); i++){
+			TDirectory *dir = (!path_.empty() ? files_.at(i)->GetDirectory(path_.c_str()) : files_.at(i));
+			TH1 *hist = (dir ? (TH1*)dir->Get(key->GetName()) : NULL);
+			if(hist) sum->Add(hist);
+			else std::cout << "  Warning! Histogram \"" << path_ << "/" << key->GetName() << "\" not found in " << files_.at(i)->GetName() << ".\n";
+		}
+
+		dest_->cd();
+		sum->Write(key->GetName());
+		delete sum;
+		count++;
+	}
+
+	return count;
+}
+
+int scanMerger::copyHead(TFile *input_, TDirectory *dest_, const bool &firstFile_){
+	TDirectory *head = input_->GetDirectory("head");
+	if(!head) return 0;
+
+	int count = 0;
+	TIter next(head->GetListOfKeys());
+	TKey *key;
+	while((key = (TKey*)next())){
+		TClass *cl = TClass::GetClass(key->GetClassName());
+		if(!cl || !cl->InheritsFrom("TDirectory")) continue;
+
+		TDirectory *src = (TDirectory*)key->ReadObj();
+
+		// Add up the total data time.
+		TNamed *named = (TNamed*)src->Get("Data time");
+		if(named) totalTime += strtod(named->GetTitle(), NULL);
+
+		if(!firstFile_) continue;
+
+		std::stringstream stream;
+		if(++fileCount < 10){ stream << "file0" << fileCount; }
+		else{ stream << "file" << fileCount; }
+
+		TDirectory *dest = dest_->mkdir(stream.str().c_str());
+		copyDirectory(src, dest);
+		count++;
+	}
+
+	return count;
+}
+
+bool scanMerger::merge(const std::string &fname_, const bool &singleRun_/*=false*/){
+	if(inputs.empty()){
+		std::cout << " Error! No input files to merge.\n";
+		return false;
+	}
+
+	std::vector<TFile*> files;
+	for(std::vector<std::string>::iterator iter = inputs.begin(); iter != inputs.end(); iter++){
+		TFile *file = new TFile(iter->c_str(), "READ");
+		if(!file->IsOpen()){
+			std::cout << " Error! Failed to open input file \"" << *iter << "\".\n";
+			delete file;
+			for(std::vector<TFile*>::iterator iter2 = files.begin(); iter2 != files.end(); iter2++) delete (*iter2);
+			return false;
+		}
+		files.push_back(file);
+	}
+
+	TFile *output = new TFile(fname_.c_str(), "RECREATE");
+	if(!output->IsOpen()){
+		std::cout << " Error! Failed to open output file \"" << fname_ << "\".\n";
+		delete output;
+		for(std::vector<TFile*>::iterator iter = files.begin(); iter != files.end(); iter++) delete (*iter);
+		return false;
+	}
+
+	std::cout << " Merging " << files.size() << " files into " << fname_ << ".\n";
+
+	totalTime = 0;
+	fileCount = 0;
+
+	std::set<std::string> merged;
+	TIter next(files.front()->GetListOfKeys());
+	TKey *key;
+	while((key = (TKey*)next())){
+		std::string name = key->GetName();
+		TClass *cl = TClass::GetClass(key->GetClassName());
+		if(!cl || !merged.insert(name).second) continue; // Skip older cycles of the same key.
+
+		if(cl->InheritsFrom("TTree")){ // Concatenate trees in input order.
+			if(name == "trace") mergeTraceTree(files, output);
+			else mergeTree(name, output);
+		}
+		else if(cl->InheritsFrom("TDirectory")){
+			TDirectory *dest = output->mkdir(name.c_str());
+			if(name == "head"){ // Keep the file information and add up the total data time.
+				for(size_t i = 0; i < files.size(); i++){
+					copyHead(files.at(i), dest, (!singleRun_ || i == 0));
+				}
+			}
+			else if(name == "hists"){ // Sum online histograms.
+				mergeHists(name, files, dest);
+			}
+			else{ // Copy the map, config, and calibration entries from the first file.
+				copyDirectory((TDirectory*)key->ReadObj(), dest);
+			}
+		}
+	}
+
+	// Sum the diagnostic histograms.
+	mergeHists("", files, output);
+
+	// Write the total data time to the head directory.
+	std::stringstream stream;
+	stream << totalTime << " s";
+	if(singleRun_ && fileCount > 0){
+		std::stringstream path;
+		if(fileCount < 10){ path << "head/file0" << fileCount; }
+		else{ path << "head/file" << fileCount; }
+		output->cd(path.str().c_str());
+	}
+	else if(output->GetDirectory("head")){ output->cd("head"); }
+	else{ output->cd(); }
+	TNamed named("Data time", stream.str().c_str());
+	named.Write(0, TObject::kOverwrite);
+
+	std::cout << " Total data time is " << stream.str() << std::endl;
+
+	output->Close();
+	delete output;
+
+	for(std::vector<TFile*>::iterator iter = files.begin(); iter != files.end(); iter++){
+		(*iter)->Close();
+		delete (*iter);
+	}
+
+	return true;
+}
+
+int scanMerger::copyDirectory(TDirectory *src_, TDirectory *dest_){
+	if(!src_ || !dest_) return 0;
+
+	int count = 0;
+	TIter next(src_->GetListOfKeys());
+	TKey *key;
+	while((key = (TKey*)next())){
+		TClass *cl = TClass::GetClass(key->GetClassName());
+		if(cl && cl->InheritsFrom("TDirectory")){
+			TDirectory *dest = dest_->mkdir(key->GetName());
+			count += copyDirectory((TDirectory*)key->ReadObj(), dest);
+		}
+		else{
+			TObject *obj = key->ReadObj();
+			dest_->cd();
+			obj->Write(key->GetName());
+			delete obj;
+			count++;
+		}
+	}
+
+	return count;
+}
@@ -267,6 +267,45 @@ TTree *simpleTool::loadInputTree(){
 	return intree;
 }
 
+/** Get the entry numbers of all input tree entries with at least a minimum multiplicity of a detector type.
+  * Only the multiplicity branch of the event index tree (written by the scanner with --index) is read, so
+  * that non-matching entries of the input tree are never deserialized.
+  * \param[in]  type_    The detector type (e.g. "vandle").
+  * \param[out] entries_ Entry numbers of the matching input tree entries.
+  * \param[in]  minMult_ The minimum multiplicity of the detector type.
+  * \return True if the event index was used. If no index is found for the input tree, entries_ holds every entry and false is returned.
+  */
+bool simpleTool::getIndexedEntries(const std::string &type_, std::vector<long long> &entries_, const unsigned short &minMult_/*=1*/){
+	entries_.clear();
+	if(!infile || !intree) return false;
+
+	// The index must describe the same entries as the input tree.
+	TTree *index = (TTree*)infile->Get("index");
+	std::string branchName = type_ + "_mult";
+	if(!index || index->GetEntries() != intree->GetEntries() || !index->GetBranch(branchName.c_str())){
+		for(long long i = 0; i < intree->GetEntries(); i++)
+			entries_.push_back(i);
+		return false;
+	}
+
+	unsigned short mult = 0;
+	index->SetBranchStatus("*", 0);
+	index->SetBranchStatus(branchName.c_str(), 1);
+	index->SetBranchAddress(branchName.c_str(), &mult);
+
+	long long numEntries = index->GetEntries();
+	for(long long i = 0; i < numEntries; i++){
+		index->GetEntry(i);
+		if(mult >= minMult_) entries_.push_back(i);
+	}
+
+	delete index;
+
+	std::cout << " Selected " << entries_.size() << " of " << numEntries << " entries with " << type_ << " multiplicity >= " << minMult_ << " using the event index.\n";
+
+	return true;
+}
+
 TFile *simpleTool::openOutputFile(){
 	if(outfile != NULL && outfile->IsOpen()){
 		outfile->Close();
@@ -10,6 +10,7 @@
 
 #include "simpleTool.hpp"
 #include "Structures.h"
+#include "TraceCodec.hpp"
 
 #define ADC_CLOCK 4 // ns per ADC clock tick
 
@@ -20,6 +21,10 @@ class tracer : public simpleTool {
 	unsigned int tlength;
  
 	Trace *trace;
+	std::vector<unsigned char> *packed; /// Compressed traces (written with --trace-codec).
+
+	std::vector<unsigned short> wave; /// Samples of all traces of the current entry.
+	unsigned int mult; /// Number of traces of the current entry.
 
 	TBranch *branch;
  	
@@ -27,6 +32,9 @@ class tracer : public simpleTool {
 
 	bool setAddresses();
 
+	/// Copy (or decode) the traces of the current entry.
+	void readWave();
+
 	void getEntry();
 
   public:
@@ -44,11 +52,25 @@ class tracer : public simpleTool {
 bool tracer::setAddresses(){
 	if(!intree) return false;
 
-	intree->SetBranchAddress("trace", &trace, &branch);
+	// Compressed traces are decoded transparently.
+	if(!intree->GetBranch("trace") && intree->GetBranch("trace_packed"))
+		intree->SetBranchAddress("trace_packed", &packed, &branch);
+	else
+		intree->SetBranchAddress("trace", &trace, &branch);
 	
 	return (branch != NULL);
 }
 
+void tracer::readWave(){
+	wave.clear();
+	if(packed){
+		mult = TraceCodec::DecodeAll(*packed, wave);
+		return;
+	}
+	wave.insert(wave.end(), trace->wave.begin(), trace->wave.end());
+	mult = trace->mult;
+}
+
 void tracer::getEntry(){
 	if(!intree) return;
 
@@ -59,13 +81,14 @@ void tracer::getEntry(){
 	long long entry = startEntry;
 	while(bin <= numEntries && entry < intree->GetEntries()){
 		intree->GetEntry(entry++);
+		readWave();
 
 		// Skip empty traces.
-		if(trace->wave.empty()) continue;
+		if(wave.empty()) continue;
 
 		// Get the trace length.
 		if(bin == 0){
-			tlength = trace->wave.size()/trace->mult;
+			tlength = wave.size()/mult;
 			std::cout << " Trace length is " << tlength << " ADC ticks (" << tlength*ADC_CLOCK << " ns).\n";
 			hist = new TH2I("hist", "Traces", tlength, 0, tlength*ADC_CLOCK, numEntries, 0, numEntries);
 			hist->SetStats(0);
@@ -74,13 +97,13 @@ void tracer::getEntry(){
 		int globalBin;
 		for(unsigned int i = 0; i < tlength; i++){
 			globalBin = hist->GetBin(i, bin);
-			hist->SetBinContent(globalBin, trace->wave.at(i));
+			hist->SetBinContent(globalBin, wave.at(i));
 		}
 		bin++;
 	}
 }
 
-tracer::tracer() : simpleTool(), startEntry(0), numEntries(1), tlength(0), trace(NULL), branch(NULL), hist(NULL) { 
+tracer::tracer() : simpleTool(), startEntry(0), numEntries(1), tlength(0), trace(NULL), packed(NULL), mult(0), branch(NULL), hist(NULL) { 
 	input_objname = "trace";
 }
 